@@ -0,0 +1,27 @@
+#include <map>
+#include <memory>
+#include <string>
+
+#include "BDtaunuDef.h"
+#include "BDtaunuUtils.h"
+#include "AnalysisContext.h"
+
+const int AnalysisContext::catalogue_version = 1;
+
+AnalysisContext::AnalysisContext() : 
+  lund_to_name(bdtaunu::LundToNameMap()), 
+  name_to_lund(bdtaunu::NameToLundMap()), 
+  recoD_catalogue(), 
+  mcB_catalogue() {
+}
+
+std::shared_ptr<const AnalysisContext> AnalysisContext::Create() {
+  return std::shared_ptr<const AnalysisContext>(new AnalysisContext());
+}
+
+// Initialization of a function local static is thread safe, so 
+// concurrent first calls still build exactly one context. 
+std::shared_ptr<const AnalysisContext> AnalysisContext::Default() {
+  static const std::shared_ptr<const AnalysisContext> context = Create();
+  return context;
+}
@@ -0,0 +1,83 @@
+#ifndef __ANALYSISCONTEXT_H__
+#define __ANALYSISCONTEXT_H__
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "BDtaunuDef.h"
+
+/** @brief Immutable tables shared by every part of the tuple analysis.
+ *
+ * @detail
+ * # Purpose
+ * The readers, graph managers, visitors, and graphviz writers all need 
+ * the same read only tables: 
+ * * The particle data table (PDT) compiled from `cached/pdt.dat`, in both 
+ *   directions. 
+ * * RecoDTypeCatalogue, used to classify reconstructed \f$D/D^*\f$ modes.
+ * * McBTypeCatalogue, used to classify MC truth \f$B\f$ decays.
+ *
+ * This class owns one copy of each. It is built once and then handed 
+ * out by const reference, so any number of readers in a process, 
+ * including readers on different threads, share a single copy without 
+ * locking. 
+ *
+ * # Lifetime
+ * Contexts are reference counted through `std::shared_ptr`. Each reader 
+ * holds a reference to the context it was constructed with, and the 
+ * managers, visitors, and writers it owns borrow that context. 
+ *
+ * `Default()` returns a context that is built the first time it is 
+ * called, so processes that never construct a reader never pay for 
+ * building the tables. 
+ *
+ * Usage Example
+ * -------------
+ *
+ *     auto context = AnalysisContext::Create();
+ *     BDtaunuReader reader1("sp1235r1.root", "ntp1", context);
+ *     BDtaunuReader reader2("sp1235r2.root", "ntp1", context);
+ */
+class AnalysisContext {
+
+  public:
+
+    //! Build a new context. 
+    static std::shared_ptr<const AnalysisContext> Create();
+
+    //! Process wide context; built on first use. 
+    static std::shared_ptr<const AnalysisContext> Default();
+
+    //! Version of the decays registered in the catalogues. 
+    /*! Bump with any change to RecoDTypeCatalogue or McBTypeCatalogue, 
+     * so that results derived with the old catalogues are not reused; 
+     * see ResultCache. */
+    static const int catalogue_version;
+
+    AnalysisContext(const AnalysisContext&) = delete;
+    AnalysisContext &operator=(const AnalysisContext&) = delete;
+    ~AnalysisContext() {};
+
+    //! lundId : particle name map
+    const std::map<int, std::string> &get_lund_to_name() const { return lund_to_name; }
+
+    //! particle name : lundId map
+    const std::map<std::string, int> &get_name_to_lund() const { return name_to_lund; }
+
+    //! Catalogue of reconstructed \f$D/D^*\f$ modes. 
+    const bdtaunu::RecoDTypeCatalogue &get_recoD_catalogue() const { return recoD_catalogue; }
+
+    //! Catalogue of MC truth \f$B\f$ types. 
+    const bdtaunu::McBTypeCatalogue &get_mcB_catalogue() const { return mcB_catalogue; }
+
+  private:
+    AnalysisContext();
+
+    const std::map<int, std::string> lund_to_name;
+    const std::map<std::string, int> name_to_lund;
+    const bdtaunu::RecoDTypeCatalogue recoD_catalogue;
+    const bdtaunu::McBTypeCatalogue mcB_catalogue;
+};
+
+#endif
@@ -0,0 +1,393 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstring>
+#include <cstdlib>
+
+#include "BDtaunuDef.h"
+#include "BDtaunuReader.h"
+#include "BDtaunuMcReader.h"
+#include "UpsilonCandidate.h"
+#include "ArrowExport.h"
+
+using namespace bdtaunu;
+
+namespace {
+
+// Value UpsilonCandidate gives features that do not apply.
+const float undefined_feature = -999;
+
+// Producer data of an exported array: its buffers, and the structs of
+// its children and dictionary, which it owns.
+struct ArrayData {
+  std::vector<std::vector<char>> buffers;
+  std::vector<const void*> pointers;
+  std::vector<struct ArrowArray> children;
+  std::vector<struct ArrowArray*> child_pointers;
+  struct ArrowArray dictionary = ArrowArray();
+};
+
+// Producer data of an exported schema.
+struct SchemaData {
+  std::string format;
+  std::string name;
+  std::vector<struct ArrowSchema> children;
+  std::vector<struct ArrowSchema*> child_pointers;
+  struct ArrowSchema dictionary = ArrowSchema();
+};
+
+// Releasing a struct releases its children and dictionary first, as the
+// interface asks.
+void ReleaseArray(struct ArrowArray *array) {
+  ArrayData *d = static_cast<ArrayData*>(array->private_data);
+  for (auto &c : d->children) {
+    if (c.release) c.release(&c);
+  }
+  if (d->dictionary.release) d->dictionary.release(&d->dictionary);
+  delete d;
+  array->release = nullptr;
+}
+
+void ReleaseSchema(struct ArrowSchema *schema) {
+  SchemaData *d = static_cast<SchemaData*>(schema->private_data);
+  for (auto &c : d->children) {
+    if (c.release) c.release(&c);
+  }
+  if (d->dictionary.release) d->dictionary.release(&d->dictionary);
+  delete d;
+  schema->release = nullptr;
+}
+
+// Point `array` at the buffers, children, and dictionary of `d`, and
+// hand `d` over to it. Buffer 0 is the validity bitmap, omitted when
+// empty; other empty buffers get a valid address all the same.
+void ExportArray(struct ArrowArray *array, ArrayData *d,
+                 int64_t length, int64_t null_count) {
+  static const int64_t empty = 0;
+  for (size_t i = 0; i < d->buffers.size(); ++i) {
+    if (!d->buffers[i].empty()) d->pointers.push_back(d->buffers[i].data());
+    else d->pointers.push_back(i == 0 ? nullptr : &empty);
+  }
+  for (auto &c : d->children) d->child_pointers.push_back(&c);
+
+  array->length = length;
+  array->null_count = null_count;
+  array->offset = 0;
+  array->n_buffers = d->pointers.size();
+  array->n_children = d->children.size();
+  array->buffers = d->pointers.data();
+  array->children = d->child_pointers.empty() ? nullptr : d->child_pointers.data();
+  array->dictionary = d->dictionary.release ? &d->dictionary : nullptr;
+  array->release = &ReleaseArray;
+  array->private_data = d;
+}
+
+void ExportSchema(struct ArrowSchema *schema, SchemaData *d, int64_t flags) {
+  for (auto &c : d->children) d->child_pointers.push_back(&c);
+
+  schema->format = d->format.c_str();
+  schema->name = d->name.c_str();
+  schema->metadata = nullptr;
+  schema->flags = flags;
+  schema->n_children = d->children.size();
+  schema->children = d->child_pointers.empty() ? nullptr : d->child_pointers.data();
+  schema->dictionary = d->dictionary.release ? &d->dictionary : nullptr;
+  schema->release = &ReleaseSchema;
+  schema->private_data = d;
+}
+
+// A utf8 array of `strings`, for dictionaries.
+template <typename S>
+void ExportStrings(struct ArrowArray *array, struct ArrowSchema *schema,
+                   const std::vector<S> &strings) {
+
+  ArrayData *d = new ArrayData;
+  d->buffers.resize(3);
+  std::vector<char> &offsets = d->buffers[1];
+  std::vector<char> &data = d->buffers[2];
+
+  offsets.resize((strings.size() + 1) * sizeof(int32_t));
+  int32_t *offset = reinterpret_cast<int32_t*>(offsets.data());
+  offset[0] = 0;
+  for (size_t i = 0; i < strings.size(); ++i) {
+    std::string s(strings[i]);
+    data.insert(data.end(), s.begin(), s.end());
+    offset[i + 1] = data.size();
+  }
+  ExportArray(array, d, strings.size(), 0);
+
+  SchemaData *sd = new SchemaData;
+  sd->format = "u";
+  ExportSchema(schema, sd, 0);
+}
+
+}
+
+const ArrowCandidateBatch::EnumNames ArrowCandidateBatch::bflavor_names = {
+  0, { "NoB", "B0", "Bc" }
+};
+
+const ArrowCandidateBatch::EnumNames ArrowCandidateBatch::dtype_names = {
+  1, { "Dc_Kpipi", "Dc_Kpipipi0", "Dc_KsK", "Dc_Kspi", "Dc_Kspipi0",
+       "Dc_Kspipipi", "Dc_KKpi", "D0_Kpi", "D0_Kpipi0", "D0_Kpipipi",
+       "D0_Kpipipipi0", "D0_Kspipi", "D0_Kspipipi0", "D0_Kspi0", "D0_KK" }
+};
+
+const ArrowCandidateBatch::EnumNames ArrowCandidateBatch::dstartype_names = {
+  0, { "NoDstar", "Dstar0_D0pi0", "Dstar0_D0gamma", "Dstarc_D0pi",
+       "Dstarc_Dcpi0", "Dstarc_Dcgamma" }
+};
+
+const ArrowCandidateBatch::EnumNames ArrowCandidateBatch::tautype_names = {
+  0, { "NoTau", "tau_pi", "tau_rho", "tau_e", "tau_mu" }
+};
+
+const ArrowCandidateBatch::EnumNames ArrowCandidateBatch::bmctype_names = {
+  0, { "NoB", "Dtau", "Dstartau", "Dl", "Dstarl", "Dstarstar_res",
+       "Dstarstar_nonres", "SL", "Had" }
+};
+
+const ArrowCandidateBatch::EnumNames ArrowCandidateBatch::taumctype_names = {
+  0, { "NoTau", "tau_e", "tau_mu", "tau_k", "tau_h" }
+};
+
+const ArrowCandidateBatch::EnumNames ArrowCandidateBatch::candtype_names = {
+  0, { "DDpi", "DDstarpi", "DstarDpi", "DstarDstarpi",
+       "DDrho", "DDstarrho", "DstarDrho", "DstarDstarrho" }
+};
+
+const ArrowCandidateBatch::EnumNames ArrowCandidateBatch::sampletype_names = {
+  0, { "BcD", "BcDstar", "B0D", "B0Dstar" }
+};
+
+ArrowCandidateBatch::ArrowCandidateBatch(bool _mc_labels) :
+  mc_labels(_mc_labels), nrows(0), nevents(0),
+  continuum(-1), b1_mctype(-1), b2_mctype(-1), b1_tau_mctype(-1), b2_tau_mctype(-1) {
+
+  eventId = AddColumn("eventId", Kind::kString);
+  nTrk = AddColumn("nTrk", Kind::kInt32);
+  R2All = AddColumn("R2All", Kind::kFloat);
+  nY = AddColumn("nY", Kind::kInt32);
+
+  if (mc_labels) {
+    continuum = AddColumn("continuum", Kind::kBool);
+    b1_mctype = AddColumn("b1_mctype", Kind::kEnum, &bmctype_names);
+    b2_mctype = AddColumn("b2_mctype", Kind::kEnum, &bmctype_names);
+    b1_tau_mctype = AddColumn("b1_tau_mctype", Kind::kEnum, &taumctype_names);
+    b2_tau_mctype = AddColumn("b2_tau_mctype", Kind::kEnum, &taumctype_names);
+  }
+
+  block_index = AddColumn("block_index", Kind::kInt32);
+  reco_index = AddColumn("reco_index", Kind::kInt32);
+  truth_match = AddColumn("truth_match", Kind::kInt32);
+  bflavor = AddColumn("bflavor", Kind::kEnum, &bflavor_names);
+  cand_type = AddColumn("cand_type", Kind::kEnum, &candtype_names);
+  sample_type = AddColumn("sample_type", Kind::kEnum, &sampletype_names);
+
+  const std::vector<std::pair<const char*, float (UpsilonCandidate::*)() const>> getters = {
+    { "eextra50", &UpsilonCandidate::get_eextra50 },
+    { "mmiss_prime2", &UpsilonCandidate::get_mmiss_prime2 },
+    { "cosThetaT", &UpsilonCandidate::get_cosThetaT },
+    { "tag_lp3", &UpsilonCandidate::get_tag_lp3 },
+    { "tag_cosBY", &UpsilonCandidate::get_tag_cosBY },
+    { "tag_cosThetaDl", &UpsilonCandidate::get_tag_cosThetaDl },
+    { "tag_Dmass", &UpsilonCandidate::get_tag_Dmass },
+    { "tag_deltaM", &UpsilonCandidate::get_tag_deltaM },
+    { "tag_cosThetaDSoft", &UpsilonCandidate::get_tag_cosThetaDSoft },
+    { "tag_softP3MagCM", &UpsilonCandidate::get_tag_softP3MagCM },
+    { "sig_hp3", &UpsilonCandidate::get_sig_hp3 },
+    { "sig_cosBY", &UpsilonCandidate::get_sig_cosBY },
+    { "sig_cosThetaDtau", &UpsilonCandidate::get_sig_cosThetaDtau },
+    { "sig_vtxB", &UpsilonCandidate::get_sig_vtxB },
+    { "sig_Dmass", &UpsilonCandidate::get_sig_Dmass },
+    { "sig_deltaM", &UpsilonCandidate::get_sig_deltaM },
+    { "sig_cosThetaDSoft", &UpsilonCandidate::get_sig_cosThetaDSoft },
+    { "sig_softP3MagCM", &UpsilonCandidate::get_sig_softP3MagCM },
+    { "sig_hmass", &UpsilonCandidate::get_sig_hmass },
+    { "sig_vtxh", &UpsilonCandidate::get_sig_vtxh },
+  };
+  for (const auto &g : getters) {
+    features.push_back(std::make_pair(AddColumn(g.first, Kind::kFloat), g.second));
+  }
+
+  tag_d_mode = AddColumn("tag_d_mode", Kind::kEnum, &dtype_names);
+  tag_dstar_mode = AddColumn("tag_dstar_mode", Kind::kEnum, &dstartype_names);
+  sig_d_mode = AddColumn("sig_d_mode", Kind::kEnum, &dtype_names);
+  sig_dstar_mode = AddColumn("sig_dstar_mode", Kind::kEnum, &dstartype_names);
+  sig_tau_mode = AddColumn("sig_tau_mode", Kind::kEnum, &tautype_names);
+  l_ePidMap = AddColumn("l_ePidMap", Kind::kInt32);
+  l_muPidMap = AddColumn("l_muPidMap", Kind::kInt32);
+  h_ePidMap = AddColumn("h_ePidMap", Kind::kInt32);
+  h_muPidMap = AddColumn("h_muPidMap", Kind::kInt32);
+}
+
+int ArrowCandidateBatch::AddColumn(const std::string &name, Kind kind, const EnumNames *names) {
+  Column c;
+  c.name = name;
+  c.kind = kind;
+  c.names = names;
+  c.null_count = 0;
+  columns.push_back(std::move(c));
+  return columns.size() - 1;
+}
+
+// Row `nrows` of `c`: set its validity bit, and append `size` bytes of
+// `value`, or zeros if it is null.
+void ArrowCandidateBatch::Append(Column &c, bool valid, const void *value, size_t size) {
+  if (c.valid.size() * 8 <= static_cast<size_t>(nrows)) c.valid.push_back(0);
+  if (valid) c.valid[nrows / 8] |= 1 << (nrows % 8);
+  else ++c.null_count;
+
+  const char *bytes = static_cast<const char*>(value);
+  if (valid) c.data.insert(c.data.end(), bytes, bytes + size);
+  else c.data.resize(c.data.size() + size, 0);
+}
+
+void ArrowCandidateBatch::AppendInt(int column, int value) {
+  int32_t v = value;
+  Append(columns[column], true, &v, sizeof(v));
+}
+
+void ArrowCandidateBatch::AppendFloat(int column, float value) {
+  Append(columns[column], value != undefined_feature, &value, sizeof(value));
+}
+
+void ArrowCandidateBatch::AppendBool(int column, bool value) {
+  Column &c = columns[column];
+  if (c.valid.size() * 8 <= static_cast<size_t>(nrows)) {
+    c.valid.push_back(0);
+    c.data.push_back(0);
+  }
+  c.valid[nrows / 8] |= 1 << (nrows % 8);
+  if (value) c.data[nrows / 8] |= 1 << (nrows % 8);
+}
+
+// Every enum of BDtaunuDef has a null. The index is the position of the
+// value among the names.
+template <typename E>
+void ArrowCandidateBatch::AppendEnum(int column, E value) {
+  Column &c = columns[column];
+  int i = static_cast<int>(value) - c.names->first;
+  bool valid = value != E::null && i >= 0 && i < static_cast<int>(c.names->names.size());
+  int8_t index = valid ? i : 0;
+  Append(c, valid, &index, sizeof(index));
+}
+
+void ArrowCandidateBatch::AppendString(int column, const std::string &value) {
+  Column &c = columns[column];
+  auto it = c.index.find(value);
+  if (it == c.index.end()) {
+    it = c.index.insert(std::make_pair(value, static_cast<int32_t>(c.dictionary.size()))).first;
+    c.dictionary.push_back(value);
+  }
+  Append(c, true, &it->second, sizeof(int32_t));
+}
+
+void ArrowCandidateBatch::append(const BDtaunuReader &reader) {
+
+  const BDtaunuMcReader *mc_reader = nullptr;
+  if (mc_labels) {
+    mc_reader = dynamic_cast<const BDtaunuMcReader*>(&reader);
+    if (!mc_reader) {
+      std::cerr << "ArrowCandidateBatch: MC labels asked for, ";
+      std::cerr << "but the reader is not a BDtaunuMcReader." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  std::string id = reader.get_eventId();
+  for (const auto &cand : reader.get_upsilon_candidates()) {
+
+    AppendString(eventId, id);
+    AppendInt(nTrk, reader.get_nTrk());
+    AppendFloat(R2All, reader.get_R2All());
+    AppendInt(nY, reader.get_nY());
+
+    if (mc_reader) {
+      AppendBool(continuum, mc_reader->is_continuum());
+      AppendEnum(b1_mctype, mc_reader->get_b1_mctype());
+      AppendEnum(b2_mctype, mc_reader->get_b2_mctype());
+      AppendEnum(b1_tau_mctype, mc_reader->get_b1_tau_mctype());
+      AppendEnum(b2_tau_mctype, mc_reader->get_b2_tau_mctype());
+    }
+
+    AppendInt(block_index, cand.get_block_index());
+    AppendInt(reco_index, cand.get_reco_index());
+    AppendInt(truth_match, cand.get_truth_match());
+    AppendEnum(bflavor, cand.get_bflavor());
+    AppendEnum(cand_type, cand.get_cand_type());
+    AppendEnum(sample_type, cand.get_sample_type());
+
+    for (const auto &f : features) AppendFloat(f.first, (cand.*f.second)());
+
+    AppendEnum(tag_d_mode, cand.get_tag_d_mode());
+    AppendEnum(tag_dstar_mode, cand.get_tag_dstar_mode());
+    AppendEnum(sig_d_mode, cand.get_sig_d_mode());
+    AppendEnum(sig_dstar_mode, cand.get_sig_dstar_mode());
+    AppendEnum(sig_tau_mode, cand.get_sig_tau_mode());
+    AppendInt(l_ePidMap, cand.get_l_ePidMap());
+    AppendInt(l_muPidMap, cand.get_l_muPidMap());
+    AppendInt(h_ePidMap, cand.get_h_ePidMap());
+    AppendInt(h_muPidMap, cand.get_h_muPidMap());
+
+    ++nrows;
+  }
+  ++nevents;
+}
+
+void ArrowCandidateBatch::export_batch(struct ArrowArray *array, struct ArrowSchema *schema) {
+
+  ArrayData *d = new ArrayData;
+  d->buffers.resize(1);
+  d->children.resize(columns.size());
+
+  SchemaData *sd = new SchemaData;
+  sd->format = "+s";
+  sd->children.resize(columns.size());
+
+  for (size_t i = 0; i < columns.size(); ++i) {
+    Column &c = columns[i];
+
+    ArrayData *cd = new ArrayData;
+    cd->buffers.resize(2);
+    if (c.null_count) cd->buffers[0] = std::move(c.valid);
+    cd->buffers[1] = std::move(c.data);
+
+    SchemaData *csd = new SchemaData;
+    csd->name = c.name;
+    switch (c.kind) {
+      case Kind::kInt32: csd->format = "i"; break;
+      case Kind::kFloat: csd->format = "f"; break;
+      case Kind::kBool: csd->format = "b"; break;
+      case Kind::kEnum:
+        csd->format = "c";
+        ExportStrings(&cd->dictionary, &csd->dictionary, c.names->names);
+        break;
+      case Kind::kString:
+        csd->format = "i";
+        ExportStrings(&cd->dictionary, &csd->dictionary, c.dictionary);
+        break;
+    }
+
+    ExportArray(&d->children[i], cd, nrows, c.null_count);
+    ExportSchema(&sd->children[i], csd, ARROW_FLAG_NULLABLE);
+  }
+
+  ExportArray(array, d, nrows, 0);
+  ExportSchema(schema, sd, 0);
+
+  clear();
+}
+
+void ArrowCandidateBatch::clear() {
+  for (auto &c : columns) {
+    c.valid.clear();
+    c.data.clear();
+    c.null_count = 0;
+    c.dictionary.clear();
+    c.index.clear();
+  }
+  nrows = 0;
+  nevents = 0;
+}
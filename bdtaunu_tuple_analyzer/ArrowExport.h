@@ -0,0 +1,188 @@
+#ifndef __ARROWEXPORT_H__
+#define __ARROWEXPORT_H__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include <Rtypes.h>
+
+#include "UpsilonCandidate.h"
+
+class BDtaunuReader;
+
+// Arrow C data interface, verbatim from the Arrow specification. It is
+// an ABI; any library that implements it defines the same structs under
+// the same guard.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+  // Array type description
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowSchema*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+struct ArrowArray {
+  // Array data description
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  // Release callback
+  void (*release)(struct ArrowArray*);
+  // Opaque producer-specific data
+  void* private_data;
+};
+
+}
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+/** @brief Collects the candidates of events into an Arrow record batch.
+ *
+ * @detail
+ * # Purpose
+ * Python and other Arrow based tools read features with no copies and
+ * no parsing through the Arrow C data interface, a plain C ABI that
+ * needs no Arrow library on this side.
+ *
+ * `append()` adds one row per candidate of the current event of a
+ * reader, and `export_batch()` hands the rows over as an `ArrowArray`
+ * of type struct and its `ArrowSchema`. The columns are those of
+ * CandidateColumnWriter:
+ * * `eventId`: dictionary encoded utf8 with int32 indices. The indices
+ *   number the events of the batch in order.
+ * * `nTrk`, `nY`, `block_index`, `reco_index`, `truth_match`, and the
+ *   PID maps: int32.
+ * * `R2All` and the candidate features: float32, null where
+ *   UpsilonCandidate leaves them at -999.
+ * * `continuum`: boolean, with MC labels.
+ * * The flavor, the candidate and sample types, the modes, and the MC
+ *   types: dictionary encoded utf8 of
+ *   the enumerator names with int8 indices, null where the enum is.
+ *
+ * # Ownership
+ * The buffers are built in place and moved into the exported array, not
+ * copied. The consumer owns the array and the schema once exported, and
+ * frees them by calling their `release` callbacks, as the interface
+ * specifies; releasing the array releases its children and
+ * dictionaries. The batch is empty after an export, and can be reused.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     ArrowCandidateBatch batch(true);
+ *     while (reader.next_record() != RootReader::Status::kEOF) {
+ *       batch.append(reader);
+ *       if (batch.get_num_events() == 10000) {
+ *         struct ArrowArray array;
+ *         struct ArrowSchema schema;
+ *         batch.export_batch(&array, &schema);
+ *         consume(&array, &schema);  // e.g. pyarrow.RecordBatch._import_from_c
+ *       }
+ *     }
+ *
+ * BDtaunuReader::export_candidates() exports the current event alone.
+ */
+class ArrowCandidateBatch {
+
+  public:
+
+    //! With `mc_labels`, readers must be BDtaunuMcReaders.
+    ArrowCandidateBatch(bool mc_labels = false);
+    ArrowCandidateBatch(const ArrowCandidateBatch&) = delete;
+    ArrowCandidateBatch &operator=(const ArrowCandidateBatch&) = delete;
+    ~ArrowCandidateBatch() {};
+
+    //! Append the candidates of the current event of `reader`.
+    void append(const BDtaunuReader &reader);
+
+    //! Number of candidates appended since the last export.
+    Long64_t get_num_rows() const { return nrows; }
+
+    //! Number of events appended since the last export.
+    Long64_t get_num_events() const { return nevents; }
+
+    //! Move the rows into `array`, described by `schema`, and clear the batch.
+    void export_batch(struct ArrowArray *array, struct ArrowSchema *schema);
+
+    //! Drop the rows appended since the last export.
+    void clear();
+
+  private:
+
+    enum class Kind { kInt32, kFloat, kBool, kEnum, kString };
+
+    // Names of the values of an enum, from the value `first` up.
+    struct EnumNames {
+      int first;
+      std::vector<const char*> names;
+    };
+
+    struct Column {
+      std::string name;
+      Kind kind;
+      const EnumNames *names;
+
+      // Arrow buffers, built in place: the validity bits, and the values
+      // or dictionary indices.
+      std::vector<char> valid;
+      std::vector<char> data;
+      Long64_t null_count;
+
+      // Dictionary of a string column.
+      std::vector<std::string> dictionary;
+      std::unordered_map<std::string, std::int32_t> index;
+    };
+
+    static const EnumNames bflavor_names, dtype_names, dstartype_names;
+    static const EnumNames tautype_names, bmctype_names, taumctype_names;
+    static const EnumNames candtype_names, sampletype_names;
+
+    bool mc_labels;
+    Long64_t nrows;
+    Long64_t nevents;
+    std::vector<Column> columns;
+
+    int eventId, nTrk, R2All, nY;
+    int continuum, b1_mctype, b2_mctype, b1_tau_mctype, b2_tau_mctype;
+    int block_index, reco_index, truth_match, bflavor, cand_type, sample_type;
+    int tag_d_mode, tag_dstar_mode, sig_d_mode, sig_dstar_mode, sig_tau_mode;
+    int l_ePidMap, l_muPidMap, h_ePidMap, h_muPidMap;
+
+    // Float features, with their getters.
+    std::vector<std::pair<int, float (UpsilonCandidate::*)() const>> features;
+
+    int AddColumn(const std::string &name, Kind kind, const EnumNames *names = nullptr);
+    void Append(Column &c, bool valid, const void *value, size_t size);
+    void AppendInt(int column, int value);
+    void AppendFloat(int column, float value);
+    void AppendBool(int column, bool value);
+    template <typename E> void AppendEnum(int column, E value);
+    void AppendString(int column, const std::string &value);
+};
+
+#endif
@@ -175,7 +175,7 @@ RecoDTypeCatalogue::Alphabet RecoDTypeCatalogue::LundToAlphabet(int lund) const
 // -------
 
 McBTypeCatalogue::BMcType 
-McBTypeCatalogue::search_catalogue(std::vector<int> lund_list) const {
+McBTypeCatalogue::search_catalogue(const std::vector<int> &lund_list) const {
   std::vector<Alphabet> word;
   bool hasX = false;
   for (auto l : lund_list) {
@@ -136,7 +136,7 @@ class McBTypeCatalogue {
     };
 
     //! Given a vector of \f$B^*\f$ daughters, return its MC type or null.
-    BMcType search_catalogue(std::vector<int>) const;
+    BMcType search_catalogue(const std::vector<int>&) const;
 
     McBTypeCatalogue() { RegisterDecays(); }
     ~McBTypeCatalogue() {};
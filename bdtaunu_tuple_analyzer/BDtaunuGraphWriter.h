@@ -21,7 +21,7 @@
  *      auto lund_pm = get(vertex_lund_id, reco_graph);
  *      auto reco_idx_pm = get(vertex_reco_index, reco_graph);
  *      BDtaunuGraphvizManager<decltype(reco_graph), decltype(lund_pm), decltype(reco_idx_pm)> gv_manager(
- *          reco_graph, lund_pm, reco_idx_pm, BDtaunuMcReader::lund_to_name, truth_match);
+ *          reco_graph, lund_pm, reco_idx_pm, reader.get_context().get_lund_to_name(), truth_match);
  *
  *      // Configure graph properties. 
  *      gv_manager.set_title("Reco Graph with Truth Match");
@@ -92,7 +92,7 @@ class BDtaunuVertexWriter {
     Graph g;
     LundPM lund_pm;
     IdxPM idx_pm;
-    std::map<int, std::string> lund_map;
+    const std::map<int, std::string> &lund_map;
     std::map<int, int> tm_map;
     std::map<std::string, std::string> vertex_properties;
     std::map<std::string, std::string> tm_vertex_properties;
@@ -287,7 +287,7 @@ class BDtaunuGraphvizManager {
     Graph g;
     LundPM lund_pm;
     IdxPM idx_pm;
-    std::map<int, std::string> lund_map;
+    const std::map<int, std::string> &lund_map;
     std::map<int, int> tm_map;
     std::string title;
     std::map<std::string, std::string> vertex_properties;
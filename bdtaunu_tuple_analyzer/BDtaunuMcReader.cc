@@ -1,14 +1,15 @@
 #include <map>
+#include <memory>
 #include <string>
 #include <cmath>
 #include <cassert>
 
 #include "BDtaunuDef.h"
-#include "BDtaunuUtils.h"
 #include "BDtaunuReader.h"
 #include "BDtaunuMcReader.h"
 #include "McGraphManager.h"
 #include "TruthMatchManager.h"
+#include "ArrowExport.h"
 
 using namespace boost;
 using namespace bdtaunu;
@@ -19,13 +20,33 @@ const int BDtaunuMcReader::max_mc_length = 100;
 // and the mc graph manager.
 BDtaunuMcReader::BDtaunuMcReader(
   const char *root_fname,
-  const char *root_trname) : 
-  BDtaunuReader(root_fname, root_trname) {
+  const char *root_trname, 
+  Mode _mode, 
+  std::shared_ptr<const AnalysisContext> _context) : 
+  BDtaunuReader(root_fname, root_trname, _context), mode(_mode), 
+  result_cache(ResultCache::Default()) {
 
   AllocateBuffer();
   ClearBuffer();
-  mc_graph_manager = McGraphManager(this);
-  truth_match_manager = TruthMatchManager(this);
+  if (mode == Mode::kMcOnly) SelectMcOnlyBranches();
+  mc_graph_manager = McGraphManager(this, *context);
+  truth_match_manager = TruthMatchManager(this, *context);
+
+}
+
+BDtaunuMcReader::BDtaunuMcReader(
+  const std::vector<std::string> &root_fnames,
+  const char *root_trname, 
+  Mode _mode, 
+  std::shared_ptr<const AnalysisContext> _context) : 
+  BDtaunuReader(root_fnames, root_trname, _context), mode(_mode), 
+  result_cache(ResultCache::Default()) {
+
+  AllocateBuffer();
+  ClearBuffer();
+  if (mode == Mode::kMcOnly) SelectMcOnlyBranches();
+  mc_graph_manager = McGraphManager(this, *context);
+  truth_match_manager = TruthMatchManager(this, *context);
 
 }
 
@@ -42,7 +63,6 @@ void BDtaunuMcReader::AllocateBuffer() {
   mothIdx = new int[max_mc_length];
   dauIdx = new int[max_mc_length];
   dauLen = new int[max_mc_length];
-  mcenergy = new float[max_mc_length];
   hMCIdx = new int[maximum_h_candidates];
   lMCIdx = new int[maximum_l_candidates];
   gammaMCIdx = new int[maximum_gamma_candidates];
@@ -53,13 +73,27 @@ void BDtaunuMcReader::AllocateBuffer() {
   tr->SetBranchAddress("mothIdx", mothIdx);
   tr->SetBranchAddress("dauIdx", dauIdx);
   tr->SetBranchAddress("dauLen", dauLen);
-  tr->SetBranchAddress("mcenergy", mcenergy);
   tr->SetBranchAddress("hMCIdx", hMCIdx);
   tr->SetBranchAddress("lMCIdx", lMCIdx);
   tr->SetBranchAddress("gammaMCIdx", gammaMCIdx);
 
 }
 
+// Deactivate every branch except for the event Id and the MC truth 
+// tree. Inactive branches are not read by TTree::GetEntry(). 
+void BDtaunuMcReader::SelectMcOnlyBranches() {
+  tr->SetBranchStatus("*", 0);
+  tr->SetBranchStatus("platform", 1);
+  tr->SetBranchStatus("partition", 1);
+  tr->SetBranchStatus("upperID", 1);
+  tr->SetBranchStatus("lowerID", 1);
+  tr->SetBranchStatus("mcLen", 1);
+  tr->SetBranchStatus("mcLund", 1);
+  tr->SetBranchStatus("mothIdx", 1);
+  tr->SetBranchStatus("dauIdx", 1);
+  tr->SetBranchStatus("dauLen", 1);
+}
+
 // Zeros out buffer elements
 void BDtaunuMcReader::ClearBuffer() {
   mcLen = -999;
@@ -68,6 +102,9 @@ void BDtaunuMcReader::ClearBuffer() {
   b2_mctype = McBTypeCatalogue::BMcType::NoB;
   b1_tau_mctype = TauMcType::NoTau;
   b2_tau_mctype = TauMcType::NoTau;
+  b1_signature = 0;
+  b2_signature = 0;
+  cached_event = nullptr;
 }
 
 // Free the buffer. Used for destructor. 
@@ -76,12 +113,17 @@ void BDtaunuMcReader::DeleteBuffer() {
   delete[] mothIdx;
   delete[] dauIdx;
   delete[] dauLen;
-  delete[] mcenergy;
   delete[] hMCIdx;
   delete[] lMCIdx;
   delete[] gammaMCIdx;
 }
 
+void BDtaunuMcReader::export_candidates(struct ArrowArray *array, struct ArrowSchema *schema) const {
+  ArrowCandidateBatch batch(true);
+  batch.append(*this);
+  batch.export_batch(array, schema);
+}
+
 // Read in the next event in the ntuple and update the buffer
 // with the new information.
 RootReader::Status BDtaunuMcReader::next_record() {
@@ -89,8 +131,15 @@ RootReader::Status BDtaunuMcReader::next_record() {
   ClearBuffer();
 
   // Read next event into the buffer. Calls BDtaunuReader::next_record()
-  // first to compute reco information. 
-  RootReader::Status reader_status = BDtaunuReader::next_record();
+  // first to compute reco information. In MC only mode, the reco 
+  // information is skipped altogether. 
+  RootReader::Status reader_status;
+  if (mode == Mode::kMcOnly) {
+    reader_status = RootReader::next_record();
+    if (reader_status == RootReader::Status::kReadSucceeded) cached_event = FindCachedEvent();
+  } else {
+    reader_status = BDtaunuReader::next_record();
+  }
 
   // Derive additional mc information from the ntuple. 
   if (reader_status == RootReader::Status::kReadSucceeded) {
@@ -100,34 +149,77 @@ RootReader::Status BDtaunuMcReader::next_record() {
     // kind of event altogether. 
     if (is_max_mc_exceeded()) {
       reader_status = RootReader::Status::kMaxMcParticlesExceeded;
+      reader_stats.change_status(RootReader::Status::kReadSucceeded, reader_status);
+    } else if (cached_event) {
+      FillCachedMcInfo();
     } else {
 
       // Outsource graph operations to graph manager
+      ReaderStats::Timestamp t0 = reader_stats.start();
       mc_graph_manager.construct_graph();
+      reader_stats.stop(ReaderStats::kMcConstructGraph, t0);
+
+      t0 = reader_stats.start();
       mc_graph_manager.analyze_graph();
+      reader_stats.stop(ReaderStats::kMcAnalyzeGraph, t0);
 
       // Outsource truth match operations to truth matcher
-      truth_match_manager.update_graph(reco_graph_manager, mc_graph_manager);
-      truth_match_manager.analyze_graph();
+      if (mode != Mode::kMcOnly) {
+        t0 = reader_stats.start();
+        truth_match_manager.update_graph(reco_graph_manager, mc_graph_manager);
+        reader_stats.stop(ReaderStats::kTruthMatchUpdateGraph, t0);
+
+        t0 = reader_stats.start();
+        truth_match_manager.contract_mc_graph();
+        reader_stats.stop(ReaderStats::kTruthMatchContractGraph, t0);
+
+        t0 = reader_stats.start();
+        truth_match_manager.analyze_graph();
+        reader_stats.stop(ReaderStats::kTruthMatchAnalyzeGraph, t0);
+
+        if (ReaderStats::enabled) {
+          reader_stats.truth_match_probes += truth_match_manager.get_n_probes();
+        }
+      }
 
       // Make derived information ready for access
+      t0 = reader_stats.start();
       FillMcInfo();
+      reader_stats.stop(ReaderStats::kFillMcInfo, t0);
+
+      if (ReaderStats::enabled) {
+        const McGraph::Tree &t = mc_graph_manager.get_mc_tree();
+        reader_stats.mc_vertices += t.size();
+        for (int i = 0; i < t.size(); ++i) reader_stats.mc_edges += t.n_daughters(i);
+      }
     }
   }
+
+  if (reader_status != RootReader::Status::kEOF && !cached_event) RecordEvent(reader_status);
   
   return reader_status;
 }
 
+// Same limits as next_record(): in MC only mode the reco blocks are 
+// not checked. 
+std::string BDtaunuMcReader::RejectedSelection() const {
+  std::string mc = "mcLen>" + std::to_string(max_mc_length);
+  if (mode == Mode::kMcOnly) return mc;
+  return BDtaunuReader::RejectedSelection() + "||" + mc;
+}
+
 void BDtaunuMcReader::FillMcInfo() {
   if (mc_graph_manager.get_mcY()) 
     continuum = !(mc_graph_manager.get_mcY()->isBBbar);
   if (mc_graph_manager.get_mcB1()) {
     b1_mctype = mc_graph_manager.get_mcB1()->mc_type;
+    b1_signature = mc_graph_manager.get_mcB1()->signature;
     if (mc_graph_manager.get_mcB1()->tau) 
       b1_tau_mctype = mc_graph_manager.get_mcB1()->tau->mc_type;
   }
   if (mc_graph_manager.get_mcB2()) {
     b2_mctype = mc_graph_manager.get_mcB2()->mc_type;
+    b2_signature = mc_graph_manager.get_mcB2()->signature;
     if (mc_graph_manager.get_mcB2()->tau) 
       b2_tau_mctype = mc_graph_manager.get_mcB2()->tau->mc_type;
   }
@@ -141,3 +233,96 @@ void BDtaunuMcReader::FillMcInfo() {
 
   return;
 }
+
+
+// Result cache
+// ------------
+
+// Load the results of the file of the current record, or start 
+// recording them, when the reader has moved on to a new file. 
+void BDtaunuMcReader::UpdateResultCache() {
+  if (static_cast<long>(get_file_index()) == cache_file) return;
+  cache_file = get_file_index();
+  cache_key = ResultCache::Key(tr, static_cast<int>(mode), 
+                               mc_graph_manager.get_signature_depth(), *context);
+  cached_table = nullptr;
+  recorded_table.reset();
+  if (cache_key.empty()) return;
+  cached_table = result_cache->load(cache_key);
+  if (!cached_table) recorded_table.reset(new ResultCache::Table());
+}
+
+// Stored results of the current entry, if it was read successfully 
+// when they were recorded. 
+const ResultCache::Event *BDtaunuMcReader::FindCachedEvent() {
+  if (!result_cache) return nullptr;
+  UpdateResultCache();
+  if (!cached_table) return nullptr;
+
+  Long64_t entry = get_current_entry();
+  if (entry < 0 || entry >= static_cast<Long64_t>(cached_table->events.size())) return nullptr;
+  const ResultCache::Event &e = cached_table->events[entry];
+  if (e.status != static_cast<int>(RootReader::Status::kReadSucceeded)) return nullptr;
+  return &e;
+}
+
+bool BDtaunuMcReader::FillCachedRecoInfo() {
+  cached_event = FindCachedEvent();
+  if (!cached_event) return false;
+
+  std::string eventId = get_eventId();
+  for (int i = 0; i < cached_event->ncandidates; ++i) {
+    upsilon_candidates.push_back(ResultCache::Unpack(
+        cached_table->candidates[cached_event->first_candidate + i], eventId));
+  }
+  return true;
+}
+
+void BDtaunuMcReader::FillCachedMcInfo() {
+  continuum = cached_event->continuum;
+  b1_mctype = static_cast<McBTypeCatalogue::BMcType>(cached_event->b1_mctype);
+  b2_mctype = static_cast<McBTypeCatalogue::BMcType>(cached_event->b2_mctype);
+  b1_tau_mctype = static_cast<TauMcType>(cached_event->b1_tau_mctype);
+  b2_tau_mctype = static_cast<TauMcType>(cached_event->b2_tau_mctype);
+  b1_signature = cached_event->b1_signature;
+  b2_signature = cached_event->b2_signature;
+  for (auto s : { b1_signature, b2_signature }) {
+    if (s) mc_graph_manager.insert_decay(s, cached_table->decays.get_decay_string(s));
+  }
+}
+
+// Add the results of the current entry to the recorded table, and 
+// store it once every entry of the file has been read in order. 
+void BDtaunuMcReader::RecordEvent(RootReader::Status status) {
+  if (!result_cache) return;
+  UpdateResultCache();
+  if (!recorded_table) return;
+
+  ResultCache::Table &t = *recorded_table;
+  if (get_current_entry() != static_cast<Long64_t>(t.events.size())) {
+    recorded_table.reset();
+    return;
+  }
+
+  ResultCache::Event e = {};
+  e.status = static_cast<int>(status);
+  e.continuum = continuum;
+  e.b1_mctype = static_cast<int>(b1_mctype);
+  e.b2_mctype = static_cast<int>(b2_mctype);
+  e.b1_tau_mctype = static_cast<int>(b1_tau_mctype);
+  e.b2_tau_mctype = static_cast<int>(b2_tau_mctype);
+  e.b1_signature = b1_signature;
+  e.b2_signature = b2_signature;
+  e.first_candidate = t.candidates.size();
+  e.ncandidates = upsilon_candidates.size();
+  for (const auto &cand : upsilon_candidates) t.candidates.push_back(ResultCache::Pack(cand));
+  t.events.push_back(e);
+  for (auto s : { b1_signature, b2_signature }) {
+    if (s) t.decays.insert(s, get_decay_dictionary().get_decay_string(s));
+  }
+
+  if (static_cast<Long64_t>(t.events.size()) == tr->GetEntries()) {
+    result_cache->store(cache_key, t);
+    recorded_table.reset();
+  }
+}
@@ -3,14 +3,18 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "BDtaunuDef.h"
+#include "AnalysisContext.h"
 #include "BDtaunuReader.h"
 #include "McGraphManager.h"
+#include "DecayDictionary.h"
 
 #include "TruthMatchManager.h"
+#include "ResultCache.h"
 
 /** 
  * @brief 
@@ -29,6 +33,30 @@
  *
  * See BDtaunuReader. 
  *
+ * MC Truth Only Mode
+ * ------------------
+ *
+ * Jobs that only need the MC truth labels of each generated event 
+ * (`is_continuum()`, `get_b1_mctype()`, etc.) can construct the reader 
+ * in Mode::kMcOnly: 
+ *
+ *     BDtaunuMcReader reader("sp1235r1.root", "ntp1", BDtaunuMcReader::Mode::kMcOnly);
+ *
+ * In this mode only the event Id and the MC truth branches are read from 
+ * the TTree, and only the MC truth graph is analyzed. Reconstruction 
+ * quantities are not computed; e.g. there are no \f$\Upsilon(4S)\f$ 
+ * candidates and no truth matching. Since the reco candidate limits are not 
+ * checked, no event is rejected with RootReader::Status::kMaxRecoCandExceeded. 
+ *
+ * Result Cache
+ * ------------
+ *
+ * When a ResultCache is set, the candidates and MC labels of every file 
+ * read from start to end are stored in it, and later readers of the 
+ * same file take them from there instead of building the reco and MC 
+ * graphs and truth matching. See ResultCache for what invalidates 
+ * stored results, and for what a cached event does not provide. 
+ *
  */
 class BDtaunuMcReader : public BDtaunuReader {
 
@@ -40,9 +68,22 @@ class BDtaunuMcReader : public BDtaunuReader {
     // API
     // ---
 
+    //! Reader modes
+    enum class Mode {
+      kFull = 0,        /*!< Compute both reco and MC truth information. */
+      kMcOnly = 1,      /*!< Compute MC truth information only. */
+    };
+
     // Constructors
     BDtaunuMcReader() = delete;
-    BDtaunuMcReader(const char *root_fname, const char *root_trname = "ntp1");
+    BDtaunuMcReader(const char *root_fname, 
+                    const char *root_trname = "ntp1", 
+                    Mode mode = Mode::kFull, 
+                    std::shared_ptr<const AnalysisContext> context = AnalysisContext::Default());
+    BDtaunuMcReader(const std::vector<std::string> &root_fnames, 
+                    const char *root_trname = "ntp1", 
+                    Mode mode = Mode::kFull, 
+                    std::shared_ptr<const AnalysisContext> context = AnalysisContext::Default());
     BDtaunuMcReader(const BDtaunuMcReader&) = delete;
     BDtaunuMcReader &operator=(const BDtaunuMcReader&) = delete;
     ~BDtaunuMcReader();
@@ -50,6 +91,15 @@ class BDtaunuMcReader : public BDtaunuReader {
     //! Read in the next event. 
     virtual RootReader::Status next_record();
 
+    //! Export the candidates of the current event, with the MC labels. 
+    virtual void export_candidates(struct ArrowArray *array, struct ArrowSchema *schema) const;
+
+    //! The mode this reader was constructed with. 
+    Mode get_mode() const { return mode; }
+
+    //! Number of MC truth particles in this event. 
+    int get_mcLen() const { return mcLen; }
+
     //! Flag whether the MC truth is Continuum. 
     bool is_continuum() const { return continuum; }
 
@@ -65,6 +115,19 @@ class BDtaunuMcReader : public BDtaunuReader {
     //! MC type of the tau of the other MC truth B. 
     bdtaunu::TauMcType get_b2_tau_mctype() const { return b2_tau_mctype; }
 
+    //! Decay chain signature of one MC truth B. 0 if there is none. 
+    /*! See McGraphManager.h for the definition. */
+    DecayDictionary::Signature get_b1_signature() const { return b1_signature; }
+
+    //! Decay chain signature of the other MC truth B. 0 if there is none. 
+    DecayDictionary::Signature get_b2_signature() const { return b2_signature; }
+
+    //! Decay strings of every signature seen since the reader was opened. 
+    const DecayDictionary& get_decay_dictionary() const { return mc_graph_manager.get_decay_dictionary(); }
+
+    //! Number of generations below the B that the signatures cover. 0 disables them. 
+    void set_signature_depth(int depth) { mc_graph_manager.set_signature_depth(depth); }
+
     //! Printer
     void print_mc_graph(std::ostream &os) const { mc_graph_manager.print(os); }
     void print_contracted_mc_graph(std::ostream &os) const { truth_match_manager.print_mc(os); }
@@ -72,6 +135,19 @@ class BDtaunuMcReader : public BDtaunuReader {
 
     std::map<int, int> get_truth_map() const { return truth_match_manager.get_truth_map(); }
 
+    //! MC tree of the current event. 
+    const McGraphManager &get_mc_graph_manager() const { return mc_graph_manager; }
+
+    //! Truth matching of the current event. 
+    const TruthMatchManager &get_truth_match_manager() const { return truth_match_manager; }
+
+    //! Cache of derived results; defaults to ResultCache::Default(). 
+    /*! Null turns caching off. Call before the first record is read. */
+    void set_result_cache(std::shared_ptr<ResultCache> cache) { result_cache = cache; }
+
+    //! Whether the current event was served from the ResultCache. 
+    bool is_cached() const { return cached_event != nullptr; }
+
   private:
 
     // Static members
@@ -85,29 +161,47 @@ class BDtaunuMcReader : public BDtaunuReader {
     int *mothIdx;
     int *dauIdx;
     int *dauLen;
-    float *mcenergy;
     int *hMCIdx; 
     int *lMCIdx; 
     int *gammaMCIdx; 
 
     // Class members
     // -------------
+    Mode mode;
     bool continuum;
     bdtaunu::McBTypeCatalogue::BMcType b1_mctype, b2_mctype;
     bdtaunu::TauMcType b1_tau_mctype, b2_tau_mctype;
+    DecayDictionary::Signature b1_signature, b2_signature;
 
     McGraphManager mc_graph_manager;
     TruthMatchManager truth_match_manager;
 
+    // Results of the current file: from the cache, or recorded so far 
+    // to be stored once the last entry is read. 
+    std::shared_ptr<ResultCache> result_cache;
+    long cache_file = -1;
+    std::string cache_key;
+    std::shared_ptr<const ResultCache::Table> cached_table;
+    std::unique_ptr<ResultCache::Table> recorded_table;
+    const ResultCache::Event *cached_event = nullptr;
+
     // Helper functions
     // ----------------
     void AllocateBuffer();
     void DeleteBuffer();
     void ClearBuffer();
+    void SelectMcOnlyBranches();
 
     bool is_max_mc_exceeded() { return (mcLen > max_mc_length) ? true : false; }
     void FillMcInfo();
 
+    virtual bool FillCachedRecoInfo();
+    virtual std::string RejectedSelection() const;
+    void FillCachedMcInfo();
+    void UpdateResultCache();
+    const ResultCache::Event *FindCachedEvent();
+    void RecordEvent(RootReader::Status status);
+
 
 };
 
@@ -9,14 +9,11 @@
 #include <cassert>
 
 #include "BDtaunuDef.h"
-#include "BDtaunuUtils.h"
 #include "RootReader.h"
 #include "BDtaunuReader.h"
 #include "UpsilonCandidate.h"
 #include "RecoGraphManager.h"
-
-// Lund to particle name map needed for printing.
-const std::map<int, std::string> BDtaunuReader::lund_to_name = bdtaunu::LundToNameMap();
+#include "ArrowExport.h"
 
 // The maximum number of candidates allowed in an event. This should
 // be consistent with the number set in BtaTupleMaker. 
@@ -32,10 +29,22 @@ const int BDtaunuReader::maximum_gamma_candidates = 100;
 // and the reco graph manager.
 BDtaunuReader::BDtaunuReader(
     const char *root_fname, 
-    const char *root_trname) : RootReader(root_fname, root_trname) {
+    const char *root_trname, 
+    std::shared_ptr<const AnalysisContext> _context) : 
+  RootReader(root_fname, root_trname), context(_context) {
   AllocateBuffer();
   ClearBuffer();
-  reco_graph_manager = RecoGraphManager(this);
+  reco_graph_manager = RecoGraphManager(this, *context);
+}
+
+BDtaunuReader::BDtaunuReader(
+    const std::vector<std::string> &root_fnames, 
+    const char *root_trname, 
+    std::shared_ptr<const AnalysisContext> _context) : 
+  RootReader(root_fnames, root_trname), context(_context) {
+  AllocateBuffer();
+  ClearBuffer();
+  reco_graph_manager = RecoGraphManager(this, *context);
 }
 
 BDtaunuReader::~BDtaunuReader() {
@@ -323,20 +332,49 @@ RootReader::Status BDtaunuReader::next_record() {
     // kind of event altogether. 
     if (is_max_reco_exceeded()) {
       reader_status = RootReader::Status::kMaxRecoCandExceeded;
+      reader_stats.change_status(RootReader::Status::kReadSucceeded, reader_status);
+    } else if (FillCachedRecoInfo()) {
+      if (ReaderStats::enabled) reader_stats.candidates += upsilon_candidates.size();
     } else {
 
       // Outsource graph operations to graph manager
+      ReaderStats::Timestamp t0 = reader_stats.start();
       reco_graph_manager.construct_graph();
+      reader_stats.stop(ReaderStats::kRecoConstructGraph, t0);
+
+      t0 = reader_stats.start();
       reco_graph_manager.analyze_graph();
+      reader_stats.stop(ReaderStats::kRecoAnalyzeGraph, t0);
 
       // Make derived information ready for access
+      t0 = reader_stats.start();
       FillRecoInfo();
+      reader_stats.stop(ReaderStats::kFillRecoInfo, t0);
+
+      if (ReaderStats::enabled) {
+        const RecoGraph::Graph &g = reco_graph_manager.get_reco_graph();
+        reader_stats.reco_vertices += boost::num_vertices(g);
+        reader_stats.reco_edges += boost::num_edges(g);
+        reader_stats.candidates += upsilon_candidates.size();
+      }
     }
   } 
   
   return reader_status;
 }
 
+// Same limits as is_max_reco_exceeded(). 
+std::string BDtaunuReader::RejectedSelection() const {
+  return 
+    "nY>=" + std::to_string(maximum_Y_candidates) + 
+    "||nB>=" + std::to_string(maximum_B_candidates) + 
+    "||nD>=" + std::to_string(maximum_D_candidates) + 
+    "||nC>=" + std::to_string(maximum_C_candidates) + 
+    "||nh>=" + std::to_string(maximum_h_candidates) + 
+    "||nl>=" + std::to_string(maximum_l_candidates) + 
+    "||ngamma>=" + std::to_string(maximum_gamma_candidates);
+}
+
 bool BDtaunuReader::is_max_reco_exceeded() const {
     if ( 
         (nY < maximum_Y_candidates) &&
@@ -360,6 +398,19 @@ std::string BDtaunuReader::get_eventId() const {
          + "/" + std::to_string(lowerID);
 }
 
+bool BDtaunuReader::seek_event(const std::string &eventId) {
+  std::string fname;
+  Long64_t entry;
+  if (!event_index || !event_index->find(eventId, fname, entry)) return false;
+  return SeekEntry(fname, entry);
+}
+
+void BDtaunuReader::export_candidates(struct ArrowArray *array, struct ArrowSchema *schema) const {
+  ArrowCandidateBatch batch;
+  batch.append(*this);
+  batch.export_batch(array, schema);
+}
+
 void BDtaunuReader::FillRecoInfo() {
 
   // Derived information about Upsilon candidates. 
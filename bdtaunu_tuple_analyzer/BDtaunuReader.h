@@ -4,11 +4,17 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <iostream>
 
 #include "RootReader.h"
+#include "AnalysisContext.h"
 #include "UpsilonCandidate.h"
 #include "RecoGraphManager.h"
+#include "EventIndex.h"
+
+struct ArrowArray;
+struct ArrowSchema;
 
 
 /** 
@@ -34,10 +40,24 @@
  *       // reader.get_nTrk(); etc.
  *     }
  *
+ *     // Or read several files in turn; the next file is opened while
+ *     // the current one is processed. 
+ *     BDtaunuReader dataset_reader({"sp1235r1.root", "sp1235r2.root"});
+ *
+ *     // Jump to one event with an EventIndex of the files. 
+ *     dataset_reader.set_event_index(
+ *         std::make_shared<EventIndex>(EventIndex::Open("sp1235.evidx")));
+ *     if (dataset_reader.seek_event("1:1:0/42")) dataset_reader.next_record();
+ *
+ * Readers share the particle data table and decay catalogues through an 
+ * AnalysisContext. Unless one is passed in, AnalysisContext::Default() 
+ * is used. 
+ *
  */
 class BDtaunuReader : public RootReader {
 
   friend class RecoGraphManager;
+  friend class SkimWriter;
 
   public: 
 
@@ -48,7 +68,15 @@ class BDtaunuReader : public RootReader {
     BDtaunuReader() = delete;
 
     //! Open root file root_fname and read the TTree root_trname.
-    BDtaunuReader(const char *root_fname, const char *root_trname = "ntp1");
+    BDtaunuReader(const char *root_fname, 
+                  const char *root_trname = "ntp1", 
+                  std::shared_ptr<const AnalysisContext> context = AnalysisContext::Default());
+
+    //! Read the TTree root_trname of each file in root_fnames in turn. 
+    /*! The next files are prefetched; see RootReader. */
+    BDtaunuReader(const std::vector<std::string> &root_fnames, 
+                  const char *root_trname = "ntp1", 
+                  std::shared_ptr<const AnalysisContext> context = AnalysisContext::Default());
 
     //! No copy constructor.
     BDtaunuReader(const BDtaunuReader&) = delete;
@@ -66,6 +94,16 @@ class BDtaunuReader : public RootReader {
     //! Babar event Id. 
     std::string get_eventId() const;
 
+    //! Index used by `seek_event()`. 
+    void set_event_index(std::shared_ptr<const EventIndex> index) { event_index = index; }
+
+    //! Make the event `eventId` the next record read. 
+    /*! The event is looked up in the index set with `set_event_index()`, 
+     * and reading carries on from it. Returns false if there is no 
+     * index, or the event is not in the index or in the files of this 
+     * reader. */
+    bool seek_event(const std::string &eventId);
+
     //! nTRK defined in BtaTupleMaker. 
     int get_nTrk() const { return nTrk; }
 
@@ -78,14 +116,25 @@ class BDtaunuReader : public RootReader {
     //! Return list of \f$\Upsilon(4S)\f$ candidates in this event.
     const std::vector<UpsilonCandidate> &get_upsilon_candidates() const { return upsilon_candidates; }
 
+    //! Shared tables used by this reader. 
+    const AnalysisContext &get_context() const { return *context; }
+
     //! Prints graphviz file of the reco graph to ostream.
     void print_reco_graph(std::ostream &os) const { reco_graph_manager.print(os); }
 
+    //! Reco graph of the current event. 
+    const RecoGraphManager &get_reco_graph_manager() const { return reco_graph_manager; }
+
+    //! Export the candidates of the current event as an Arrow record batch.
+    /*! The consumer owns `array` and `schema` afterwards, and releases
+     * them; see ArrowCandidateBatch, which also batches many events. 
+     * BDtaunuMcReader adds the MC labels. */
+    virtual void export_candidates(struct ArrowArray *array, struct ArrowSchema *schema) const;
+
   protected:
 
     // Static members
     // --------------
-    static const std::map<int, std::string> lund_to_name;
     static const int maximum_h_candidates;
     static const int maximum_l_candidates;
     static const int maximum_gamma_candidates;
@@ -93,12 +142,25 @@ class BDtaunuReader : public RootReader {
     // Class members
     // -------------
 
+    // Shared tables. Owned jointly with any other reader using them. 
+    std::shared_ptr<const AnalysisContext> context;
+
     // Reco graph manager
     RecoGraphManager reco_graph_manager;
 
     // Upsilon candidates derived from the buffer candidates
     std::vector<UpsilonCandidate> upsilon_candidates;
 
+    // Fill the Upsilon candidates of the current event from stored 
+    // results instead of the reco graph. Returns false if there are 
+    // none, in which case they are derived as usual. 
+    virtual bool FillCachedRecoInfo() { return false; }
+
+    // TTree selection of the entries next_record() rejects for 
+    // exceeding a buffer limit. Used by SkimWriter to decide whether 
+    // a file can be copied whole. 
+    virtual std::string RejectedSelection() const;
+
   private: 
 
     // Static members
@@ -108,6 +170,9 @@ class BDtaunuReader : public RootReader {
     static const int maximum_D_candidates;
     static const int maximum_C_candidates;
 
+    // Event Id lookup, if set. 
+    std::shared_ptr<const EventIndex> event_index;
+
     // Buffer elements 
     // ---------------
     int platform, partition, upperID, lowerID;
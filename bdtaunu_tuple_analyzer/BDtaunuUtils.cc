@@ -1,41 +1,42 @@
 #include <string>
-#include <sstream>
-#include <fstream>
+#include <cstring>
 #include <cassert>
+#include <algorithm>
 #include <map>
 
 #include "BDtaunuUtils.h"
+#include "PdtTable.h"
 
-// Reads in __PDT_FILE_PATHNAME which contains one particle type on
-// each line in the format: "particle name" lundId, and puts the
-// information into a map with particle name : lundId.
-std::map<std::string, int> bdtaunu::NameToLundMap() {
-  std::map<std::string, int> m;
+using namespace bdtaunu;
 
-  std::ifstream pdt_file;
-  pdt_file.open(__PDT_FILE_PATHNAME);
-  if (!pdt_file.is_open()) {
-    std::stringstream ss;
-    ss << "\nError: In file " << __FILE__ << " line " << __LINE__ << ": \n"; 
-    ss << "File not found: " << __PDT_FILE_PATHNAME << "\n";
-    throw std::ios_base::failure(ss.str());
-  }
+// Binary search pdt::kByLund. 
+const char *bdtaunu::LundToName(int lund) {
+  const PdtEntry *first = pdt::kByLund;
+  const PdtEntry *last = pdt::kByLund + pdt::kNEntries;
+  const PdtEntry *it = std::lower_bound(first, last, lund, 
+      [] (const PdtEntry &e, int l) { return e.lund < l; });
+  return (it != last && it->lund == lund) ? it->name : nullptr;
+}
 
-  // Scan each line from the first character until the first space for
-  // the particle name. The remainder of the line is the lundId. 
-  std::string line, lundId_string, particle_name;
-  while (std::getline(pdt_file, line)) {
-    for (std::string::size_type i = 0; i != line.size(); ++i) {
-      if (std::isspace(line[i])) {
-        lundId_string = line.substr(i + 1);
-        particle_name = line.substr(0, i);
-        m[particle_name] = std::stoi(lundId_string);
-        break;
-      }
-    }
-  }
+// Binary search pdt::kByName. It is sorted in strcmp order by 
+// gen_pdt_table.sh. 
+bool bdtaunu::NameToLund(const char *name, int &lund) {
+  const PdtEntry *first = pdt::kByName;
+  const PdtEntry *last = pdt::kByName + pdt::kNEntries;
+  const PdtEntry *it = std::lower_bound(first, last, name, 
+      [] (const PdtEntry &e, const char *n) { return std::strcmp(e.name, n) < 0; });
+  if (it == last || std::strcmp(it->name, name) != 0) return false;
+  lund = it->lund;
+  return true;
+}
 
-  pdt_file.close();
+// The maps are built from the compiled table and kept for existing 
+// callers; new code can use LundToName and NameToLund directly. 
+std::map<std::string, int> bdtaunu::NameToLundMap() {
+  std::map<std::string, int> m;
+  for (int i = 0; i < pdt::kNEntries; ++i) {
+    m.emplace_hint(m.end(), pdt::kByName[i].name, pdt::kByName[i].lund);
+  }
 
   assert(!m.empty());
   assert(m["B0"] == 511);
@@ -43,40 +44,14 @@ std::map<std::string, int> bdtaunu::NameToLundMap() {
   return m;
 }
 
-// Reads in __PDT_FILE_PATHNAME which contains one particle type on
-// each line in the format: "particle name" lundId, and puts the
-// information into a map with lundId : particle name
 std::map<int, std::string> bdtaunu::LundToNameMap() {
   std::map<int, std::string> m;
-
-  std::ifstream pdt_file;
-  pdt_file.open(__PDT_FILE_PATHNAME);
-  if (!pdt_file.is_open()) {
-    std::stringstream ss;
-    ss << "\nError: In file " << __FILE__ << " line " << __LINE__ << ": \n"; 
-    ss << "File not found: " << __PDT_FILE_PATHNAME << "\n";
-    throw std::ios_base::failure(ss.str());
+  for (int i = 0; i < pdt::kNEntries; ++i) {
+    m.emplace_hint(m.end(), pdt::kByLund[i].lund, pdt::kByLund[i].name);
   }
 
-  // Scan each line from the first character until the first space for
-  // the particle name. The remainder of the line is the lundId. 
-  std::string line, lundId_string, particle_name;
-  while (std::getline(pdt_file, line)) {
-    for (std::string::size_type i = 0; i != line.size(); ++i) {
-      if (std::isspace(line[i])) {
-        lundId_string = line.substr(i + 1);
-        particle_name = line.substr(0, i);
-        m[std::stoi(lundId_string)] = particle_name;
-        break;
-      }
-    }
-  }
-
-  pdt_file.close();
-
   assert(!m.empty());
   assert(m[511] == "B0");
 
   return m;
 }
-
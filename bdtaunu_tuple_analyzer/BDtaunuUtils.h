@@ -10,6 +10,21 @@
 
 namespace bdtaunu {
 
+//! One line of the particle data table. 
+/*! The table itself is compiled from `cached/pdt.dat` into the 
+ * generated header PdtTable.h when the library is built, so no file is 
+ * read at run time. */
+struct PdtEntry {
+  int lund;
+  const char *name;
+};
+
+//! Particle name of lundId, or nullptr if it is not in the table. O(log n). 
+const char *LundToName(int lund);
+
+//! Looks up the lundId of particle name. Returns false if it is not in the table. O(log n). 
+bool NameToLund(const char *name, int &lund);
+
 //! Builds particle name : lundId map
 std::map<std::string, int> NameToLundMap();
 
@@ -0,0 +1,200 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include <TTree.h>
+#include <TBranch.h>
+#include <TObjArray.h>
+#include <TTreePerfStats.h>
+#include <TVirtualPerfStats.h>
+
+#include "BranchIoProfile.h"
+
+BranchIoProfile::~BranchIoProfile() {
+  detach();
+}
+
+// Classify every top level branch and attach a TTreePerfStats.
+void BranchIoProfile::attach(TTree *_tree) {
+
+  detach();
+  tree = _tree;
+
+  branches.clear();
+  costs.clear();
+  active.clear();
+
+  TObjArray *list = tree->GetListOfBranches();
+  for (int i = 0; list && i < list->GetEntriesFast(); ++i) {
+    TBranch *b = static_cast<TBranch*>(list->At(i));
+
+    BranchCost cost;
+    cost.name = b->GetName();
+    if (!tree->GetBranchStatus(b->GetName())) {
+      cost.usage = Usage::kDisabled;
+    } else if (b->GetAddress()) {
+      cost.usage = Usage::kBound;
+    } else {
+      cost.usage = Usage::kUnbound;
+    }
+    cost.tot_bytes = b->GetTotBytes();
+    cost.zip_bytes = b->GetZipBytes();
+
+    if (cost.usage != Usage::kDisabled) active.push_back(branches.size());
+    branches.push_back(b);
+    costs.push_back(cost);
+  }
+
+  // The constructor registers itself with the tree and as gPerfStats.
+  perf_stats = new TTreePerfStats("bdtaunu_io_profile", tree);
+}
+
+// Keep the file level counters of the perf stats before deleting it.
+void BranchIoProfile::detach() {
+  if (!perf_stats) return;
+  AddPerfStats(file_cost);
+  tree->SetPerfStats(nullptr);
+  if (gPerfStats == perf_stats) gPerfStats = nullptr;
+  delete perf_stats;
+  perf_stats = nullptr;
+  for (auto &b : branches) b = nullptr;
+  active.clear();
+  tree = nullptr;
+}
+
+// Same as TTree::GetEntry(), except that each branch is timed.
+int BranchIoProfile::read_entry(Long64_t entry) {
+
+  Long64_t local_entry = tree->LoadTree(entry);
+  if (local_entry < 0) return 0;
+
+  int nbytes = 0;
+  for (int i : active) {
+    auto t0 = std::chrono::steady_clock::now();
+    int n = branches[i]->GetEntry(local_entry);
+    auto t1 = std::chrono::steady_clock::now();
+    if (n < 0) return n;
+
+    BranchCost &cost = costs[i];
+    ++cost.calls;
+    cost.bytes += n;
+    cost.seconds += std::chrono::duration<double>(t1 - t0).count();
+    nbytes += n;
+  }
+  return nbytes;
+}
+
+void BranchIoProfile::merge(const BranchIoProfile &other) {
+
+  for (const auto &c : other.costs) {
+    auto it = std::find_if(costs.begin(), costs.end(),
+        [&c] (const BranchCost &x) { return x.name == c.name; });
+    if (it == costs.end()) {
+      branches.push_back(nullptr);
+      costs.push_back(c);
+      continue;
+    }
+
+    // A branch counts as used if any file used it.
+    it->usage = std::min(it->usage, c.usage);
+    it->calls += c.calls;
+    it->bytes += c.bytes;
+    it->seconds += c.seconds;
+    it->tot_bytes += c.tot_bytes;
+    it->zip_bytes += c.zip_bytes;
+  }
+
+  FileCost f = other.get_file_cost();
+  file_cost.bytes_read += f.bytes_read;
+  file_cost.read_calls += f.read_calls;
+  file_cost.disk_seconds += f.disk_seconds;
+  file_cost.unzip_seconds += f.unzip_seconds;
+  file_cost.cache_size = std::max(file_cost.cache_size, f.cache_size);
+}
+
+std::vector<BranchIoProfile::BranchCost> BranchIoProfile::ranked() const {
+  std::vector<BranchCost> r = costs;
+  std::stable_sort(r.begin(), r.end(),
+      [] (const BranchCost &a, const BranchCost &b) { return a.seconds > b.seconds; });
+  return r;
+}
+
+BranchIoProfile::FileCost BranchIoProfile::get_file_cost() const {
+  FileCost cost = file_cost;
+  AddPerfStats(cost);
+  return cost;
+}
+
+// Bytes read and read calls are only filled in by Finish(); disk and
+// unzip time accumulate as the file is read.
+void BranchIoProfile::AddPerfStats(FileCost &cost) const {
+  if (!perf_stats) return;
+  perf_stats->Finish();
+  cost.bytes_read += perf_stats->GetBytesRead();
+  cost.read_calls += perf_stats->GetReadCalls();
+  cost.disk_seconds += perf_stats->GetDiskTime();
+  cost.unzip_seconds += perf_stats->GetUnzipTime();
+  cost.cache_size = std::max(cost.cache_size, static_cast<Long64_t>(perf_stats->GetTreeCacheSize()));
+}
+
+// File level counters, then one line per branch from the most to the
+// least expensive, then the branches that are read for nothing.
+void BranchIoProfile::print(std::ostream &os) const {
+
+  static const char *usage_names[] = { "bound", "UNBOUND", "disabled" };
+
+  FileCost f = get_file_cost();
+  os << "file bytes read: " << f.bytes_read;
+  os << ", read calls: " << f.read_calls;
+  os << ", disk time(s): " << f.disk_seconds;
+  os << ", unzip time(s): " << f.unzip_seconds;
+  os << ", tree cache size: " << f.cache_size << std::endl;
+
+  std::vector<BranchCost> r = ranked();
+  double total_seconds = 0;
+  for (const auto &c : r) total_seconds += c.seconds;
+
+  os << std::right << std::setw(4) << "rank" << "  ";
+  os << std::left << std::setw(24) << "branch";
+  os << std::setw(10) << "usage";
+  os << std::right << std::setw(12) << "time(s)";
+  os << std::setw(8) << "time%";
+  os << std::setw(14) << "bytes";
+  os << std::setw(12) << "bytes/entry";
+  os << std::setw(10) << "zip ratio" << std::endl;
+
+  for (size_t i = 0; i < r.size(); ++i) {
+    const BranchCost &c = r[i];
+    os << std::right << std::setw(4) << i + 1 << "  ";
+    os << std::left << std::setw(24) << c.name;
+    os << std::setw(10) << usage_names[static_cast<int>(c.usage)];
+    os << std::right << std::setw(12) << c.seconds;
+    os << std::setw(8) << std::fixed << std::setprecision(1);
+    os << (total_seconds > 0 ? 100 * c.seconds / total_seconds : 0.0);
+    os.unsetf(std::ios_base::floatfield);
+    os << std::setprecision(6);
+    os << std::setw(14) << c.bytes;
+    os << std::setw(12) << (c.calls > 0 ? c.bytes / c.calls : 0);
+    os << std::setw(10) << (c.zip_bytes > 0 ? double(c.tot_bytes) / c.zip_bytes : 0.0);
+    os << std::endl;
+  }
+
+  int nunbound = 0;
+  double unbound_seconds = 0;
+  unsigned long long unbound_bytes = 0;
+  for (const auto &c : r) {
+    if (c.usage != Usage::kUnbound) continue;
+    ++nunbound;
+    unbound_seconds += c.seconds;
+    unbound_bytes += c.bytes;
+  }
+  os << nunbound << " branches are read but never bound";
+  if (nunbound > 0) {
+    os << "; disabling them would save " << unbound_seconds << " s and ";
+    os << unbound_bytes << " unzipped bytes";
+  }
+  os << "." << std::endl;
+}
@@ -0,0 +1,122 @@
+#ifndef __BRANCHIOPROFILE_H__
+#define __BRANCHIOPROFILE_H__
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <TTree.h>
+#include <TBranch.h>
+
+class TTreePerfStats;
+
+/** @brief Per branch read cost of a TTree.
+ *
+ * @detail
+ * # Purpose
+ * Reports which branches dominate read and decompression time, so that
+ * we can decide which ones to prune, re-basket, or cache.
+ *
+ * Once attached to a tree, `read_entry()` takes the place of
+ * `TTree::GetEntry()`: it reads the active branches one at a time and
+ * counts the time and unzipped bytes of each. A `TTreePerfStats` is
+ * attached to the tree at the same time and records the file level
+ * view: read calls, disk and unzip time, and the TTreeCache.
+ *
+ * Each branch is classified by how the reader uses it:
+ * * Bound: active and read into a buffer set with `SetBranchAddress()`.
+ * * Unbound: active but never bound. `TTree::GetEntry()` still reads
+ *   and unzips it, but no feature of the reader looks at it.
+ * * Disabled: turned off with `SetBranchStatus()`; costs nothing.
+ *
+ * Timing every branch adds a clock read per branch and event, so this
+ * is opt in; see `RootReader::enable_io_profile()`. ROOT reports file
+ * reads to a single global `gPerfStats`, so profile one reader at a time
+ * per process; profiles of several files are combined with `merge()`.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     BDtaunuMcReader reader("sp1235r1.root");
+ *     reader.enable_io_profile();
+ *     while (reader.next_record() != RootReader::Status::kEOF) { ... }
+ *     reader.get_io_profile()->print(std::cout);
+ */
+class BranchIoProfile {
+
+  public:
+
+    //! How the reader uses a branch.
+    enum class Usage {
+      kBound = 0,
+      kUnbound = 1,
+      kDisabled = 2,
+    };
+
+    //! Read cost of one branch.
+    struct BranchCost {
+      std::string name;
+      Usage usage = Usage::kDisabled;
+      unsigned long long calls = 0;   //!< entries read
+      unsigned long long bytes = 0;   //!< unzipped bytes read
+      double seconds = 0;             //!< time in TBranch::GetEntry()
+      Long64_t tot_bytes = 0;         //!< uncompressed size on disk
+      Long64_t zip_bytes = 0;         //!< compressed size on disk
+    };
+
+    //! File level counters from TTreePerfStats.
+    struct FileCost {
+      Long64_t bytes_read = 0;
+      Long64_t read_calls = 0;
+      double disk_seconds = 0;
+      double unzip_seconds = 0;
+      Long64_t cache_size = 0;
+    };
+
+    BranchIoProfile() = default;
+    BranchIoProfile(const BranchIoProfile&) = delete;
+    BranchIoProfile &operator=(const BranchIoProfile&) = delete;
+    ~BranchIoProfile();
+
+    //! Start profiling `tree`. Call after the branch addresses and
+    //! statuses are set, so that the usage of each branch is known.
+    void attach(TTree *tree);
+
+    //! Stop profiling and release the TTreePerfStats.
+    void detach();
+
+    //! Read `entry` branch by branch. Returns the bytes read, like
+    //! `TTree::GetEntry()`. Only valid while attached.
+    int read_entry(Long64_t entry);
+
+    //! Add the counts of a profile of another file of the same tree.
+    /*! Branches are matched by name. */
+    void merge(const BranchIoProfile &other);
+
+    //! Branch costs, most expensive first.
+    std::vector<BranchCost> ranked() const;
+
+    //! File level counters, including those of merged profiles.
+    FileCost get_file_cost() const;
+
+    //! Write a report ranking the branches by time.
+    void print(std::ostream &os) const;
+
+  private:
+    TTree *tree = nullptr;
+    TTreePerfStats *perf_stats = nullptr;
+
+    // costs[i] is the cost of branches[i]; `active` indexes the
+    // branches read_entry() reads. Branches only seen in merged
+    // profiles have a null TBranch.
+    std::vector<TBranch*> branches;
+    std::vector<BranchCost> costs;
+    std::vector<int> active;
+
+    // Counters of merged profiles and of detached perf stats.
+    FileCost file_cost;
+
+    void AddPerfStats(FileCost &cost) const;
+};
+
+#endif
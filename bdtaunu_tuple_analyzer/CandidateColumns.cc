@@ -0,0 +1,223 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "BDtaunuDef.h"
+#include "BDtaunuReader.h"
+#include "BDtaunuMcReader.h"
+#include "UpsilonCandidate.h"
+#include "ColumnarFile.h"
+#include "CandidateColumns.h"
+
+using namespace bdtaunu;
+
+namespace {
+
+// Value UpsilonCandidate gives features that do not apply.
+const float undefined_feature = -999;
+
+// Every enum of BDtaunuDef has a null.
+template <typename E> void SetEnum(ColumnarWriter &w, int column, E value) {
+  if (value == E::null) w.set_null(column);
+  else w.set(column, static_cast<int>(value));
+}
+
+}
+
+CandidateColumnWriter::CandidateColumnWriter(
+    const std::string &fname, bool _mc_labels, Long64_t chunk_rows) :
+  candidates(fname, chunk_rows), mc_labels(_mc_labels),
+  continuum(-1), b1_mctype(-1), b2_mctype(-1), b1_tau_mctype(-1), b2_tau_mctype(-1),
+  first_candidate(-1), ncandidates(-1), event_row(-1) {
+  AddEventColumns(candidates);
+  AddCandidateColumns();
+}
+
+CandidateColumnWriter::CandidateColumnWriter(
+    const std::string &event_fname, const std::string &candidate_fname,
+    bool _mc_labels, Long64_t chunk_rows) :
+  events(new ColumnarWriter(event_fname, chunk_rows)),
+  candidates(candidate_fname, chunk_rows), mc_labels(_mc_labels),
+  continuum(-1), b1_mctype(-1), b2_mctype(-1), b1_tau_mctype(-1), b2_tau_mctype(-1) {
+  AddEventColumns(*events);
+  first_candidate = events->add_column("first_candidate", ColumnType::kInt64);
+  ncandidates = events->add_column("ncandidates", ColumnType::kInt32);
+  event_row = candidates.add_column("event_row", ColumnType::kInt64);
+  AddCandidateColumns();
+}
+
+void CandidateColumnWriter::AddEventColumns(ColumnarWriter &w) {
+
+  const auto dict = ColumnarWriter::Encoding::kDictionary;
+
+  eventId = w.add_column("eventId", ColumnType::kString);
+  nTrk = w.add_column("nTrk", ColumnType::kInt32);
+  R2All = w.add_column("R2All", ColumnType::kFloat);
+  nY = w.add_column("nY", ColumnType::kInt32);
+
+  if (mc_labels) {
+    continuum = w.add_column("continuum", ColumnType::kInt32, dict);
+    b1_mctype = w.add_column("b1_mctype", ColumnType::kInt32, dict);
+    b2_mctype = w.add_column("b2_mctype", ColumnType::kInt32, dict);
+    b1_tau_mctype = w.add_column("b1_tau_mctype", ColumnType::kInt32, dict);
+    b2_tau_mctype = w.add_column("b2_tau_mctype", ColumnType::kInt32, dict);
+  }
+}
+
+void CandidateColumnWriter::AddCandidateColumns() {
+
+  ColumnarWriter &writer = candidates;
+  const auto dict = ColumnarWriter::Encoding::kDictionary;
+
+  block_index = writer.add_column("block_index", ColumnType::kInt32);
+  reco_index = writer.add_column("reco_index", ColumnType::kInt32);
+  truth_match = writer.add_column("truth_match", ColumnType::kInt32, dict);
+  bflavor = writer.add_column("bflavor", ColumnType::kInt32, dict);
+  cand_type = writer.add_column("cand_type", ColumnType::kInt32, dict);
+  sample_type = writer.add_column("sample_type", ColumnType::kInt32, dict);
+
+  const std::vector<std::pair<const char*, float (UpsilonCandidate::*)() const>> getters = {
+    { "eextra50", &UpsilonCandidate::get_eextra50 },
+    { "mmiss_prime2", &UpsilonCandidate::get_mmiss_prime2 },
+    { "cosThetaT", &UpsilonCandidate::get_cosThetaT },
+    { "tag_lp3", &UpsilonCandidate::get_tag_lp3 },
+    { "tag_cosBY", &UpsilonCandidate::get_tag_cosBY },
+    { "tag_cosThetaDl", &UpsilonCandidate::get_tag_cosThetaDl },
+    { "tag_Dmass", &UpsilonCandidate::get_tag_Dmass },
+    { "tag_deltaM", &UpsilonCandidate::get_tag_deltaM },
+    { "tag_cosThetaDSoft", &UpsilonCandidate::get_tag_cosThetaDSoft },
+    { "tag_softP3MagCM", &UpsilonCandidate::get_tag_softP3MagCM },
+    { "sig_hp3", &UpsilonCandidate::get_sig_hp3 },
+    { "sig_cosBY", &UpsilonCandidate::get_sig_cosBY },
+    { "sig_cosThetaDtau", &UpsilonCandidate::get_sig_cosThetaDtau },
+    { "sig_vtxB", &UpsilonCandidate::get_sig_vtxB },
+    { "sig_Dmass", &UpsilonCandidate::get_sig_Dmass },
+    { "sig_deltaM", &UpsilonCandidate::get_sig_deltaM },
+    { "sig_cosThetaDSoft", &UpsilonCandidate::get_sig_cosThetaDSoft },
+    { "sig_softP3MagCM", &UpsilonCandidate::get_sig_softP3MagCM },
+    { "sig_hmass", &UpsilonCandidate::get_sig_hmass },
+    { "sig_vtxh", &UpsilonCandidate::get_sig_vtxh },
+  };
+  for (const auto &g : getters) {
+    features.push_back(std::make_pair(writer.add_column(g.first, ColumnType::kFloat), g.second));
+  }
+
+  tag_d_mode = writer.add_column("tag_d_mode", ColumnType::kInt32, dict);
+  tag_dstar_mode = writer.add_column("tag_dstar_mode", ColumnType::kInt32, dict);
+  sig_d_mode = writer.add_column("sig_d_mode", ColumnType::kInt32, dict);
+  sig_dstar_mode = writer.add_column("sig_dstar_mode", ColumnType::kInt32, dict);
+  sig_tau_mode = writer.add_column("sig_tau_mode", ColumnType::kInt32, dict);
+  l_ePidMap = writer.add_column("l_ePidMap", ColumnType::kInt32);
+  l_muPidMap = writer.add_column("l_muPidMap", ColumnType::kInt32);
+  h_ePidMap = writer.add_column("h_ePidMap", ColumnType::kInt32);
+  h_muPidMap = writer.add_column("h_muPidMap", ColumnType::kInt32);
+}
+
+void CandidateColumnWriter::SetFeature(int column, float value) {
+  if (value == undefined_feature) candidates.set_null(column);
+  else candidates.set(column, value);
+}
+
+void CandidateColumnWriter::SetEvent(Event &event, const BDtaunuReader &reader) {
+
+  event.eventId = reader.get_eventId();
+  event.nTrk = reader.get_nTrk();
+  event.R2All = reader.get_R2All();
+  event.nY = reader.get_nY();
+
+  const BDtaunuMcReader *mc_reader = dynamic_cast<const BDtaunuMcReader*>(&reader);
+  event.has_mc_labels = mc_reader != nullptr;
+  event.continuum = mc_reader && mc_reader->is_continuum();
+  event.b1_mctype = mc_reader ? mc_reader->get_b1_mctype() : McBTypeCatalogue::BMcType::null;
+  event.b2_mctype = mc_reader ? mc_reader->get_b2_mctype() : McBTypeCatalogue::BMcType::null;
+  event.b1_tau_mctype = mc_reader ? mc_reader->get_b1_tau_mctype() : TauMcType::null;
+  event.b2_tau_mctype = mc_reader ? mc_reader->get_b2_tau_mctype() : TauMcType::null;
+}
+
+CandidateColumnWriter::Event CandidateColumnWriter::Snapshot(const BDtaunuReader &reader) {
+  Event event;
+  SetEvent(event, reader);
+  event.candidates = reader.get_upsilon_candidates();
+  return event;
+}
+
+void CandidateColumnWriter::SetEventColumns(ColumnarWriter &w, const Event &event) {
+
+  w.set(eventId, event.eventId);
+  w.set(nTrk, event.nTrk);
+  w.set(R2All, event.R2All);
+  w.set(nY, event.nY);
+
+  if (mc_labels) {
+    w.set(continuum, event.continuum ? 1 : 0);
+    SetEnum(w, b1_mctype, event.b1_mctype);
+    SetEnum(w, b2_mctype, event.b2_mctype);
+    SetEnum(w, b1_tau_mctype, event.b1_tau_mctype);
+    SetEnum(w, b2_tau_mctype, event.b2_tau_mctype);
+  }
+}
+
+// The candidates are passed apart from the event so that those of a
+// reader are not copied.
+void CandidateColumnWriter::Write(const Event &event, const std::vector<UpsilonCandidate> &cands) {
+
+  if (mc_labels && !event.has_mc_labels) {
+    std::cerr << "CandidateColumnWriter: MC labels asked for, ";
+    std::cerr << "but the reader is not a BDtaunuMcReader." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  Long64_t row = 0;
+  if (events) {
+    row = events->get_num_rows();
+    SetEventColumns(*events, event);
+    events->set(first_candidate, candidates.get_num_rows());
+    events->set(ncandidates, static_cast<int>(cands.size()));
+    events->end_row();
+  }
+
+  ColumnarWriter &writer = candidates;
+  for (const auto &cand : cands) {
+
+    // In one table, the event columns are repeated for every candidate.
+    if (events) writer.set(event_row, row);
+    else SetEventColumns(writer, event);
+
+    writer.set(block_index, cand.get_block_index());
+    writer.set(reco_index, cand.get_reco_index());
+    writer.set(truth_match, cand.get_truth_match());
+    SetEnum(writer, bflavor, cand.get_bflavor());
+    SetEnum(writer, cand_type, cand.get_cand_type());
+    SetEnum(writer, sample_type, cand.get_sample_type());
+
+    for (const auto &f : features) SetFeature(f.first, (cand.*f.second)());
+
+    SetEnum(writer, tag_d_mode, cand.get_tag_d_mode());
+    SetEnum(writer, tag_dstar_mode, cand.get_tag_dstar_mode());
+    SetEnum(writer, sig_d_mode, cand.get_sig_d_mode());
+    SetEnum(writer, sig_dstar_mode, cand.get_sig_dstar_mode());
+    SetEnum(writer, sig_tau_mode, cand.get_sig_tau_mode());
+    writer.set(l_ePidMap, cand.get_l_ePidMap());
+    writer.set(l_muPidMap, cand.get_l_muPidMap());
+    writer.set(h_ePidMap, cand.get_h_ePidMap());
+    writer.set(h_muPidMap, cand.get_h_muPidMap());
+
+    writer.end_row();
+  }
+}
+
+void CandidateColumnWriter::write(const BDtaunuReader &reader) {
+  Event event;
+  SetEvent(event, reader);
+  Write(event, reader.get_upsilon_candidates());
+}
+
+void CandidateColumnWriter::write(const Event &event) {
+  Write(event, event.candidates);
+}
+
+void CandidateColumnWriter::close() {
+  if (events) events->close();
+  candidates.close();
+}
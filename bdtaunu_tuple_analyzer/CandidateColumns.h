@@ -0,0 +1,146 @@
+#ifndef __CANDIDATECOLUMNS_H__
+#define __CANDIDATECOLUMNS_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <Rtypes.h>
+
+#include "BDtaunuDef.h"
+#include "BDtaunuReader.h"
+#include "ColumnarFile.h"
+
+/** @brief Writes the \f$\Upsilon(4S)\f$ candidates a reader derives to a
+ * columnar file.
+ *
+ * @detail
+ * Each call to `write()` appends one row per candidate of the current
+ * event of a reader to a ColumnarWriter. A row holds the event Id and
+ * `nTrk`, `R2All`, and `nY` of its event, the MC labels of the event if
+ * asked for, and every feature of UpsilonCandidate, under the name of
+ * its getter without `get_`.
+ *
+ * Features UpsilonCandidate leaves at -999, and modes and MC types that
+ * are null, are written as nulls, so that they do not widen the zone
+ * maps. Modes, flavors, candidate and sample types, and MC types are
+ * dictionary encoded.
+ *
+ * # Event and candidate tables
+ * Constructed with two file names, the writer instead normalizes the
+ * output into two tables. The event table has one row per call to
+ * `write()`, with the event Id, `nTrk`, `R2All`, `nY`, and MC labels,
+ * and `first_candidate` and `ncandidates`, the rows of its candidates.
+ * The candidate table holds the candidate features and `event_row`, the
+ * row of their event in the event table. Event quantities are stored
+ * once rather than once per candidate, and cuts on them only read the
+ * event table.
+ *
+ * Both columns that link the tables only grow, so their zone maps are
+ * narrow: a cut on `event_row` reads the candidates of a range of
+ * events, and one on `first_candidate` the events of a range of
+ * candidates, without reading the rest of the other table.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     BDtaunuMcReader reader("sp1235r1.root");
+ *     CandidateColumnWriter out("sp1235r1.col", true);
+ *     while (reader.next_record() != RootReader::Status::kEOF) out.write(reader);
+ *     out.close();
+ *
+ *     // Later, only the chunks that may have eextra50 < 0.5 are read.
+ *     ColumnarReader in("sp1235r1.col");
+ *     in.add_range("eextra50", 0, 0.5);
+ *     while (in.next_row()) { ... }
+ *
+ *     // Or as two tables.
+ *     CandidateColumnWriter out2("sp1235r1.events.col", "sp1235r1.cands.col", true);
+ *
+ * # Snapshots
+ * `Snapshot()` copies an event and its candidates out of a reader, so
+ * that it can be written after the reader has moved on, or on another
+ * thread; see OutputRouter.
+ */
+class CandidateColumnWriter {
+
+  public:
+
+    CandidateColumnWriter() = delete;
+
+    //! Write to `fname`; with `mc_labels`, readers must be BDtaunuMcReaders.
+    CandidateColumnWriter(const std::string &fname, bool mc_labels = false,
+                          Long64_t chunk_rows = 16384);
+
+    //! Write events to `event_fname`, and their candidates to `candidate_fname`.
+    CandidateColumnWriter(const std::string &event_fname,
+                          const std::string &candidate_fname,
+                          bool mc_labels = false, Long64_t chunk_rows = 16384);
+
+    //! Same; keeps a string literal `candidate_fname` from converting to bool.
+    CandidateColumnWriter(const std::string &event_fname, const char *candidate_fname,
+                          bool mc_labels = false, Long64_t chunk_rows = 16384) :
+      CandidateColumnWriter(event_fname, std::string(candidate_fname), mc_labels, chunk_rows) {}
+    CandidateColumnWriter(const CandidateColumnWriter&) = delete;
+    CandidateColumnWriter &operator=(const CandidateColumnWriter&) = delete;
+    ~CandidateColumnWriter() {};
+
+    //! An event and its candidates, detached from the reader that read it.
+    struct Event {
+      std::string eventId;
+      int nTrk;
+      float R2All;
+      int nY;
+      bool has_mc_labels;
+      bool continuum;
+      bdtaunu::McBTypeCatalogue::BMcType b1_mctype, b2_mctype;
+      bdtaunu::TauMcType b1_tau_mctype, b2_tau_mctype;
+      std::vector<UpsilonCandidate> candidates;
+    };
+
+    //! Copy the current event of `reader`, with the MC labels of a BDtaunuMcReader.
+    static Event Snapshot(const BDtaunuReader &reader);
+
+    //! Append the current event of `reader`, and its candidates.
+    void write(const BDtaunuReader &reader);
+
+    //! Append an event copied with `Snapshot()`.
+    void write(const Event &event);
+
+    //! Write the last chunks and close the files.
+    void close();
+
+    //! Writer of the candidates.
+    ColumnarWriter &get_writer() { return candidates; }
+
+    //! Writer of the events; null unless there are two tables.
+    ColumnarWriter *get_event_writer() { return events.get(); }
+
+  private:
+    std::unique_ptr<ColumnarWriter> events;
+    ColumnarWriter candidates;
+    bool mc_labels;
+
+    // Event columns, in the event table if there is one.
+    int eventId, nTrk, R2All, nY;
+    int continuum, b1_mctype, b2_mctype, b1_tau_mctype, b2_tau_mctype;
+    int first_candidate, ncandidates;
+
+    // Candidate columns.
+    int event_row;
+    int block_index, reco_index, truth_match, bflavor, cand_type, sample_type;
+    int tag_d_mode, tag_dstar_mode, sig_d_mode, sig_dstar_mode, sig_tau_mode;
+    int l_ePidMap, l_muPidMap, h_ePidMap, h_muPidMap;
+
+    // Float features, with their getters.
+    std::vector<std::pair<int, float (UpsilonCandidate::*)() const>> features;
+
+    void AddEventColumns(ColumnarWriter &w);
+    void AddCandidateColumns();
+    static void SetEvent(Event &event, const BDtaunuReader &reader);
+    void SetEventColumns(ColumnarWriter &w, const Event &event);
+    void SetFeature(int column, float value);
+    void Write(const Event &event, const std::vector<UpsilonCandidate> &cands);
+};
+
+#endif
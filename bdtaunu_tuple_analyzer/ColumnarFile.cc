@@ -0,0 +1,709 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <RZip.h>
+#include <Compression.h>
+
+#include "ColumnarFile.h"
+
+namespace {
+
+const char magic[8] = { 'B', 'D', 'T', 'C', 'O', 'L', '0', '1' };
+
+// ROOT compresses at most this many bytes per call.
+const int max_zip_block = 0xffffff;
+
+size_t Width(ColumnType type) {
+  switch (type) {
+    case ColumnType::kInt32: return 4;
+    case ColumnType::kInt64: return 8;
+    case ColumnType::kFloat: return 4;
+    case ColumnType::kDouble: return 8;
+    default: return 0;
+  }
+}
+
+const char *TypeName(ColumnType type) {
+  switch (type) {
+    case ColumnType::kInt32: return "int32";
+    case ColumnType::kInt64: return "int64";
+    case ColumnType::kFloat: return "float";
+    case ColumnType::kDouble: return "double";
+    default: return "string";
+  }
+}
+
+template <typename T> void Put(std::vector<char> &buf, T v) {
+  const char *p = reinterpret_cast<const char*>(&v);
+  buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+void PutString(std::vector<char> &buf, const std::string &s) {
+  Put<std::uint32_t>(buf, s.size());
+  buf.insert(buf.end(), s.begin(), s.end());
+}
+
+// Reads what Put() and PutString() wrote. On overrun, reads zeros and
+// empty strings from then on, and ok() is false.
+class Cursor {
+  public:
+    Cursor(const char *_p, size_t _n) : p(_p), end(_p + _n), good(true) {}
+    template <typename T> T get() {
+      T v = T();
+      if (!need(sizeof(T))) return v;
+      std::memcpy(&v, p, sizeof(T));
+      p += sizeof(T);
+      return v;
+    }
+    std::string get_string() {
+      std::uint32_t n = get<std::uint32_t>();
+      if (!need(n)) return "";
+      std::string s(p, n);
+      p += n;
+      return s;
+    }
+    const char *take(size_t n) {
+      if (!need(n)) return nullptr;
+      const char *q = p;
+      p += n;
+      return q;
+    }
+    bool ok() const { return good; }
+  private:
+    const char *p, *end;
+    bool good;
+    bool need(size_t n) {
+      good = good && static_cast<size_t>(end - p) >= n;
+      return good;
+    }
+};
+
+void PutStats(std::vector<char> &buf, const ColumnStats &s, ColumnType type) {
+  Put<std::int64_t>(buf, s.null_count);
+  Put<std::uint8_t>(buf, s.has_range);
+  Put<double>(buf, s.min);
+  Put<double>(buf, s.max);
+  if (type == ColumnType::kString) {
+    PutString(buf, s.min_string);
+    PutString(buf, s.max_string);
+  }
+}
+
+ColumnStats GetStats(Cursor &c, ColumnType type) {
+  ColumnStats s;
+  s.null_count = c.get<std::int64_t>();
+  s.has_range = c.get<std::uint8_t>();
+  s.min = c.get<double>();
+  s.max = c.get<double>();
+  if (type == ColumnType::kString) {
+    s.min_string = c.get_string();
+    s.max_string = c.get_string();
+  }
+  return s;
+}
+
+// LZ4 through ROOT, in blocks of at most max_zip_block bytes. Returns
+// false if the result would not be smaller than the input.
+bool Compress(int level, const std::vector<char> &raw, std::vector<char> &out) {
+  out.resize(raw.size());
+  size_t in = 0, used = 0;
+  while (in < raw.size()) {
+    int srcsize = std::min<size_t>(raw.size() - in, max_zip_block);
+    int tgtsize = std::min<size_t>(out.size() - used, max_zip_block);
+    int irep = 0;
+    if (tgtsize > 0) {
+      R__zipMultipleAlgorithm(level, &srcsize, const_cast<char*>(raw.data()) + in,
+                              &tgtsize, out.data() + used, &irep,
+                              ROOT::RCompressionSetting::EAlgorithm::kLZ4);
+    }
+    if (irep <= 0) return false;
+    in += srcsize;
+    used += irep;
+  }
+  out.resize(used);
+  return used < raw.size();
+}
+
+bool Decompress(const std::vector<char> &in, size_t raw_size, std::vector<char> &out) {
+  out.resize(raw_size);
+  size_t pos = 0, produced = 0;
+  while (pos < in.size()) {
+    int srcsize = 0, tgtsize = 0;
+    unsigned char *src = reinterpret_cast<unsigned char*>(const_cast<char*>(in.data())) + pos;
+    if (in.size() - pos < 9 || R__unzip_header(&srcsize, src, &tgtsize) != 0) return false;
+    if (srcsize <= 0 || static_cast<size_t>(srcsize) > in.size() - pos) return false;
+    if (tgtsize <= 0 || static_cast<size_t>(tgtsize) > raw_size - produced) return false;
+    int irep = 0;
+    R__unzip(&srcsize, src, &tgtsize, reinterpret_cast<unsigned char*>(out.data()) + produced, &irep);
+    if (irep != tgtsize) return false;
+    pos += srcsize;
+    produced += irep;
+  }
+  return produced == raw_size;
+}
+
+}
+
+
+// ColumnarWriter
+// --------------
+
+ColumnarWriter::ColumnarWriter(const std::string &_fname, Long64_t _chunk_rows) :
+  fname(_fname), os(_fname, std::ios::binary),
+  chunk_rows(std::max(1LL, _chunk_rows)), compression_level(1),
+  nrows(0), rows_in_chunk(0), closed(false) {
+  if (!os) {
+    std::cerr << "ColumnarWriter: cannot open " << fname << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  os.write(magic, sizeof(magic));
+}
+
+ColumnarWriter::~ColumnarWriter() {
+  if (!closed) close();
+}
+
+int ColumnarWriter::add_column(const std::string &name, ColumnType type, Encoding encoding) {
+  if (nrows > 0 || rows_in_chunk > 0) {
+    std::cerr << "ColumnarWriter: column " << name << " added after the first row." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  for (const auto &c : columns) {
+    if (c.name == name) {
+      std::cerr << "ColumnarWriter: duplicate column " << name << "." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  Column c;
+  c.name = name;
+  c.type = type;
+  c.encoding = (type == ColumnType::kString) ? Encoding::kDictionary : encoding;
+  columns.push_back(c);
+  return columns.size() - 1;
+}
+
+ColumnarWriter::Column &ColumnarWriter::GetColumn(int column, ColumnType type, ColumnType alt) {
+  if (column < 0 || column >= static_cast<int>(columns.size())) {
+    std::cerr << "ColumnarWriter: no column " << column << "." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  Column &c = columns[column];
+  if (c.type != type && c.type != alt) {
+    std::cerr << "ColumnarWriter: column " << c.name << " is " << TypeName(c.type);
+    std::cerr << ", not " << TypeName(type) << "." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  c.pending_set = true;
+  return c;
+}
+
+void ColumnarWriter::set(int column, int value) {
+  GetColumn(column, ColumnType::kInt32, ColumnType::kInt64).pending_int = value;
+}
+
+void ColumnarWriter::set(int column, Long64_t value) {
+  GetColumn(column, ColumnType::kInt64, ColumnType::kInt64).pending_int = value;
+}
+
+void ColumnarWriter::set(int column, float value) {
+  GetColumn(column, ColumnType::kFloat, ColumnType::kDouble).pending_double = value;
+}
+
+void ColumnarWriter::set(int column, double value) {
+  GetColumn(column, ColumnType::kDouble, ColumnType::kDouble).pending_double = value;
+}
+
+void ColumnarWriter::set(int column, const std::string &value) {
+  GetColumn(column, ColumnType::kString, ColumnType::kString).pending_string = value;
+}
+
+void ColumnarWriter::set_null(int column) {
+  if (column >= 0 && column < static_cast<int>(columns.size())) columns[column].pending_set = false;
+}
+
+void ColumnarWriter::end_row() {
+
+  for (auto &c : columns) {
+    bool valid = c.pending_set;
+    c.valid.push_back(valid);
+    c.pending_set = false;
+
+    if (!valid) {
+      ++c.stats.null_count;
+      c.values.resize(c.values.size() + (c.type == ColumnType::kString ? 4 : Width(c.type)), 0);
+      continue;
+    }
+
+    double v = 0;
+    switch (c.type) {
+      case ColumnType::kInt32: {
+        std::int32_t x = c.pending_int;
+        Put(c.values, x);
+        v = x;
+        break;
+      }
+      case ColumnType::kInt64: {
+        std::int64_t x = c.pending_int;
+        Put(c.values, x);
+        v = x;
+        break;
+      }
+      case ColumnType::kFloat: {
+        float x = c.pending_double;
+        Put(c.values, x);
+        v = x;
+        break;
+      }
+      case ColumnType::kDouble: {
+        Put(c.values, c.pending_double);
+        v = c.pending_double;
+        break;
+      }
+      case ColumnType::kString: {
+        auto it = c.codes.find(c.pending_string);
+        if (it == c.codes.end()) {
+          it = c.codes.emplace(c.pending_string, c.dictionary.size()).first;
+          c.dictionary.push_back(c.pending_string);
+        }
+        Put<std::uint32_t>(c.values, it->second);
+        if (!c.stats.has_range || c.pending_string < c.stats.min_string) c.stats.min_string = c.pending_string;
+        if (!c.stats.has_range || c.pending_string > c.stats.max_string) c.stats.max_string = c.pending_string;
+        c.stats.has_range = true;
+        continue;
+      }
+    }
+
+    if (std::isnan(v)) continue;
+    if (!c.stats.has_range || v < c.stats.min) c.stats.min = v;
+    if (!c.stats.has_range || v > c.stats.max) c.stats.max = v;
+    c.stats.has_range = true;
+  }
+
+  ++nrows;
+  if (++rows_in_chunk == chunk_rows) FlushChunk();
+}
+
+// Validity flags if any value is null, then either the values, or the
+// dictionary and the codes.
+std::vector<char> ColumnarWriter::EncodeColumn(const Column &c) const {
+
+  std::vector<char> buf;
+  bool nulls = c.stats.null_count > 0;
+  Put<std::uint8_t>(buf, nulls);
+  if (nulls) buf.insert(buf.end(), c.valid.begin(), c.valid.end());
+
+  if (c.encoding == Encoding::kPlain) {
+    buf.insert(buf.end(), c.values.begin(), c.values.end());
+    return buf;
+  }
+
+  std::vector<std::uint32_t> codes(c.valid.size(), 0);
+  size_t ndict = c.dictionary.size();
+  if (c.type == ColumnType::kString) {
+    Put<std::uint32_t>(buf, c.dictionary.size());
+    for (const auto &s : c.dictionary) PutString(buf, s);
+    std::memcpy(codes.data(), c.values.data(), codes.size() * 4);
+  } else {
+    // Distinct values in order of first appearance.
+    size_t w = Width(c.type);
+    std::vector<std::int64_t> dictionary;
+    std::unordered_map<std::int64_t, std::uint32_t> index;
+    for (size_t r = 0; r < c.valid.size(); ++r) {
+      if (!c.valid[r]) continue;
+      std::int64_t v = 0;
+      if (w == 4) {
+        std::int32_t x;
+        std::memcpy(&x, &c.values[r * 4], 4);
+        v = x;
+      } else {
+        std::memcpy(&v, &c.values[r * 8], 8);
+      }
+      auto it = index.find(v);
+      if (it == index.end()) {
+        it = index.emplace(v, dictionary.size()).first;
+        dictionary.push_back(v);
+      }
+      codes[r] = it->second;
+    }
+    ndict = dictionary.size();
+    Put<std::uint32_t>(buf, ndict);
+    for (auto v : dictionary) {
+      if (w == 4) Put<std::int32_t>(buf, v);
+      else Put<std::int64_t>(buf, v);
+    }
+  }
+
+  std::uint8_t code_width = (ndict <= 0x100) ? 1 : (ndict <= 0x10000) ? 2 : 4;
+  Put<std::uint8_t>(buf, code_width);
+  for (auto code : codes) {
+    if (code_width == 1) Put<std::uint8_t>(buf, code);
+    else if (code_width == 2) Put<std::uint16_t>(buf, code);
+    else Put<std::uint32_t>(buf, code);
+  }
+  return buf;
+}
+
+void ColumnarWriter::FlushChunk() {
+
+  if (rows_in_chunk == 0) return;
+
+  std::vector<Block> chunk_blocks;
+  for (auto &c : columns) {
+    std::vector<char> raw = EncodeColumn(c);
+    std::vector<char> zipped;
+    Block b;
+    b.offset = os.tellp();
+    b.raw_size = raw.size();
+    b.compressed = compression_level > 0 && Compress(compression_level, raw, zipped);
+    const std::vector<char> &stored = b.compressed ? zipped : raw;
+    b.stored_size = stored.size();
+    b.stats = c.stats;
+    os.write(stored.data(), stored.size());
+    chunk_blocks.push_back(b);
+
+    c.values.clear();
+    c.valid.clear();
+    c.dictionary.clear();
+    c.codes.clear();
+    c.stats = ColumnStats();
+  }
+
+  blocks.push_back(chunk_blocks);
+  chunk_nrows.push_back(rows_in_chunk);
+  rows_in_chunk = 0;
+}
+
+void ColumnarWriter::close() {
+
+  if (closed) return;
+  closed = true;
+  FlushChunk();
+
+  std::vector<char> footer;
+  Put<std::uint64_t>(footer, columns.size());
+  for (const auto &c : columns) {
+    PutString(footer, c.name);
+    Put<std::uint8_t>(footer, static_cast<int>(c.type));
+    Put<std::uint8_t>(footer, static_cast<int>(c.encoding));
+  }
+  Put<std::uint64_t>(footer, chunk_nrows.size());
+  for (size_t i = 0; i < chunk_nrows.size(); ++i) {
+    Put<std::int64_t>(footer, chunk_nrows[i]);
+    for (size_t j = 0; j < columns.size(); ++j) {
+      const Block &b = blocks[i][j];
+      Put<std::uint64_t>(footer, b.offset);
+      Put<std::uint64_t>(footer, b.stored_size);
+      Put<std::uint64_t>(footer, b.raw_size);
+      Put<std::uint8_t>(footer, b.compressed);
+      PutStats(footer, b.stats, columns[j].type);
+    }
+  }
+  Put<std::uint64_t>(footer, footer.size());
+  footer.insert(footer.end(), magic, magic + sizeof(magic));
+
+  os.write(footer.data(), footer.size());
+  os.close();
+  if (!os) {
+    std::cerr << "ColumnarWriter: cannot write " << fname << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+
+// ColumnarReader
+// --------------
+
+ColumnarReader::ColumnarReader(const std::string &_fname) :
+  fname(_fname), is(_fname, std::ios::binary), nrows(0),
+  next(0), chunk(0), chunk_first_row(0), chunk_row(-1), chunk_loaded(false),
+  chunks_read(0), chunks_skipped(0) {
+  ReadFooter();
+}
+
+void ColumnarReader::ReadFooter() {
+
+  char head[sizeof(magic)], tail[sizeof(magic)];
+  std::uint64_t footer_size = 0;
+  std::uint64_t file_size = 0;
+
+  bool ok = is.read(head, sizeof(head)) && std::memcmp(head, magic, sizeof(magic)) == 0;
+  if (ok) {
+    is.seekg(0, std::ios::end);
+    file_size = is.tellg();
+    ok = file_size >= 2 * sizeof(magic) + 8;
+  }
+  if (ok) {
+    is.seekg(file_size - sizeof(magic) - 8);
+    ok = is.read(reinterpret_cast<char*>(&footer_size), 8) && is.read(tail, sizeof(tail))
+      && std::memcmp(tail, magic, sizeof(magic)) == 0
+      && footer_size <= file_size - 2 * sizeof(magic) - 8;
+  }
+
+  std::vector<char> footer;
+  if (ok) {
+    footer.resize(footer_size);
+    is.seekg(file_size - sizeof(magic) - 8 - footer_size);
+    ok = static_cast<bool>(is.read(footer.data(), footer_size));
+  }
+
+  if (ok) {
+    Cursor c(footer.data(), footer.size());
+    std::uint64_t ncolumns = c.get<std::uint64_t>();
+    for (std::uint64_t i = 0; c.ok() && i < ncolumns && i < footer_size; ++i) {
+      Column col;
+      col.name = c.get_string();
+      std::uint8_t type = c.get<std::uint8_t>();
+      col.encoding = c.get<std::uint8_t>();
+      ok = ok && type <= static_cast<int>(ColumnType::kString) && col.encoding <= 1;
+      col.type = static_cast<ColumnType>(type);
+      columns.push_back(col);
+    }
+    std::uint64_t nchunks = c.get<std::uint64_t>();
+    for (std::uint64_t i = 0; c.ok() && ok && i < nchunks && i < footer_size; ++i) {
+      chunk_nrows.push_back(c.get<std::int64_t>());
+      nrows += chunk_nrows.back();
+      std::vector<Block> chunk_blocks;
+      for (const auto &col : columns) {
+        Block b;
+        b.offset = c.get<std::uint64_t>();
+        b.stored_size = c.get<std::uint64_t>();
+        b.raw_size = c.get<std::uint64_t>();
+        b.compressed = c.get<std::uint8_t>();
+        b.stats = GetStats(c, col.type);
+        ok = ok && b.offset + b.stored_size <= file_size;
+        chunk_blocks.push_back(b);
+      }
+      blocks.push_back(chunk_blocks);
+    }
+    ok = ok && c.ok() && columns.size() == ncolumns && chunk_nrows.size() == nchunks;
+  }
+
+  if (!ok) {
+    std::cerr << "ColumnarReader: " << fname << " is not a columnar file." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+int ColumnarReader::find_column(const std::string &name) const {
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (columns[i].name == name) return i;
+  }
+  return -1;
+}
+
+void ColumnarReader::select_columns(const std::vector<std::string> &names) {
+  for (auto &c : columns) c.selected = false;
+  for (const auto &name : names) {
+    int i = find_column(name);
+    if (i < 0) {
+      std::cerr << "ColumnarReader: no column " << name << " in " << fname << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    columns[i].selected = true;
+  }
+  for (const auto &r : ranges) columns[r.column].selected = true;
+}
+
+void ColumnarReader::add_range(const std::string &name, double lo, double hi) {
+  int i = find_column(name);
+  if (i < 0 || columns[i].type == ColumnType::kString) {
+    std::cerr << "ColumnarReader: no numeric column " << name << " in " << fname << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  ranges.push_back({ i, lo, hi });
+  columns[i].selected = true;
+}
+
+// Whether the zone maps allow a row of the chunk to pass every cut.
+bool ColumnarReader::MayPass(size_t c) const {
+  for (const auto &r : ranges) {
+    const ColumnStats &s = blocks[c][r.column].stats;
+    if (!s.has_range || s.max < r.lo || s.min > r.hi) return false;
+  }
+  return true;
+}
+
+bool ColumnarReader::Passes() const {
+  for (const auto &r : ranges) {
+    if (is_null(r.column)) return false;
+    double v = get_double(r.column);
+    if (!(v >= r.lo && v <= r.hi)) return false;
+  }
+  return true;
+}
+
+bool ColumnarReader::next_chunk() {
+
+  if (chunk_loaded) {
+    chunk_first_row += chunk_nrows[chunk];
+    chunk_loaded = false;
+  }
+
+  for (; next < chunk_nrows.size(); ++next) {
+    if (MayPass(next)) break;
+    chunk_first_row += chunk_nrows[next];
+    ++chunks_skipped;
+  }
+  if (next == chunk_nrows.size()) return false;
+
+  chunk = next++;
+  chunk_row = -1;
+  chunk_loaded = true;
+  ++chunks_read;
+  for (size_t i = 0; i < columns.size(); ++i) {
+    columns[i].loaded = false;
+    if (columns[i].selected) LoadColumn(i);
+  }
+  return true;
+}
+
+bool ColumnarReader::next_row() {
+  while (true) {
+    if (chunk_loaded && chunk_row + 1 < chunk_nrows[chunk]) {
+      ++chunk_row;
+      if (Passes()) return true;
+      continue;
+    }
+    if (!next_chunk()) return false;
+  }
+}
+
+void ColumnarReader::rewind() {
+  next = 0;
+  chunk = 0;
+  chunk_first_row = 0;
+  chunk_row = -1;
+  chunk_loaded = false;
+}
+
+// Read, decompress, and decode one column of the current chunk.
+void ColumnarReader::LoadColumn(int i) {
+
+  Column &col = columns[i];
+  const Block &b = blocks[chunk][i];
+  Long64_t rows = chunk_nrows[chunk];
+
+  std::vector<char> stored(b.stored_size), raw;
+  is.clear();
+  is.seekg(b.offset);
+  bool ok = static_cast<bool>(is.read(stored.data(), stored.size()));
+  if (ok && b.compressed) ok = Decompress(stored, b.raw_size, raw);
+  else raw.swap(stored);
+
+  Cursor c(raw.data(), raw.size());
+  bool nulls = ok && c.get<std::uint8_t>();
+  col.valid.assign(rows, 1);
+  if (nulls) {
+    const char *v = c.take(rows);
+    if (c.ok()) col.valid.assign(v, v + rows);
+  }
+
+  size_t w = Width(col.type);
+  col.dictionary.clear();
+  col.codes.clear();
+  if (col.encoding == static_cast<int>(ColumnarWriter::Encoding::kPlain)) {
+    const char *v = c.take(rows * w);
+    if (c.ok()) col.values.assign(v, v + rows * w);
+  } else {
+    std::uint32_t n = c.get<std::uint32_t>();
+    std::vector<std::int64_t> numbers;
+    for (std::uint32_t k = 0; c.ok() && k < n; ++k) {
+      if (col.type == ColumnType::kString) col.dictionary.push_back(c.get_string());
+      else if (w == 4) numbers.push_back(c.get<std::int32_t>());
+      else numbers.push_back(c.get<std::int64_t>());
+    }
+    std::uint8_t code_width = c.get<std::uint8_t>();
+    const char *p = c.take(rows * code_width);
+    ok = ok && c.ok() && (code_width == 1 || code_width == 2 || code_width == 4);
+    col.codes.assign(rows, 0);
+    for (Long64_t r = 0; ok && r < rows; ++r) {
+      std::uint32_t code = 0;
+      std::memcpy(&code, p + r * code_width, code_width);
+      col.codes[r] = code;
+      ok = !col.valid[r] || code < n;
+    }
+    if (col.type != ColumnType::kString) {
+      col.values.assign(rows * w, 0);
+      for (Long64_t r = 0; ok && r < rows; ++r) {
+        if (!col.valid[r]) continue;
+        if (w == 4) {
+          std::int32_t x = numbers[col.codes[r]];
+          std::memcpy(&col.values[r * 4], &x, 4);
+        } else {
+          std::memcpy(&col.values[r * 8], &numbers[col.codes[r]], 8);
+        }
+      }
+    }
+  }
+
+  if (!ok || !c.ok()) {
+    std::cerr << "ColumnarReader: column " << col.name << " of chunk " << chunk;
+    std::cerr << " of " << fname << " is corrupt." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  col.loaded = true;
+}
+
+const ColumnarReader::Column &ColumnarReader::GetColumn(int column, ColumnType type, ColumnType alt) const {
+  const Column &c = columns[column];
+  if (!c.loaded || (c.type != type && c.type != alt)) {
+    std::cerr << "ColumnarReader: column " << c.name << " is " << TypeName(c.type);
+    std::cerr << (c.loaded ? "" : " and not read") << "; cannot get " << TypeName(type) << "." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return c;
+}
+
+bool ColumnarReader::is_null(int column) const {
+  const Column &c = columns[column];
+  return !c.loaded || !c.valid[chunk_row];
+}
+
+int ColumnarReader::get_int32(int column) const {
+  const Column &c = GetColumn(column, ColumnType::kInt32, ColumnType::kInt32);
+  std::int32_t x;
+  std::memcpy(&x, &c.values[chunk_row * 4], 4);
+  return x;
+}
+
+Long64_t ColumnarReader::get_int64(int column) const {
+  const Column &c = GetColumn(column, ColumnType::kInt64, ColumnType::kInt32);
+  if (c.type == ColumnType::kInt32) return get_int32(column);
+  std::int64_t x;
+  std::memcpy(&x, &c.values[chunk_row * 8], 8);
+  return x;
+}
+
+float ColumnarReader::get_float(int column) const {
+  const Column &c = GetColumn(column, ColumnType::kFloat, ColumnType::kFloat);
+  float x;
+  std::memcpy(&x, &c.values[chunk_row * 4], 4);
+  return x;
+}
+
+double ColumnarReader::get_double(int column) const {
+  const Column &c = columns[column];
+  switch (c.type) {
+    case ColumnType::kInt32: return get_int32(column);
+    case ColumnType::kInt64: return get_int64(column);
+    case ColumnType::kFloat: return get_float(column);
+    default: break;
+  }
+  GetColumn(column, ColumnType::kDouble, ColumnType::kDouble);
+  double x;
+  std::memcpy(&x, &c.values[chunk_row * 8], 8);
+  return x;
+}
+
+const std::string &ColumnarReader::get_string(int column) const {
+  static const std::string empty;
+  const Column &c = GetColumn(column, ColumnType::kString, ColumnType::kString);
+  return c.valid[chunk_row] ? c.dictionary[c.codes[chunk_row]] : empty;
+}
@@ -0,0 +1,327 @@
+#ifndef __COLUMNARFILE_H__
+#define __COLUMNARFILE_H__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <cstdint>
+
+#include <Rtypes.h>
+
+//! Value type of a column of a columnar file.
+enum class ColumnType {
+  kInt32 = 0,
+  kInt64 = 1,
+  kFloat = 2,
+  kDouble = 3,
+  kString = 4,
+};
+
+//! Zone map of one column of one chunk.
+struct ColumnStats {
+  Long64_t null_count = 0;
+
+  //! Whether the chunk has a non-null value other than NaN.
+  bool has_range = false;
+
+  //! Range of the numeric values.
+  /*! 64 bit integers beyond \f$2^{53}\f$ are rounded. */
+  double min = 0, max = 0;
+
+  //! Range of the string values.
+  std::string min_string, max_string;
+};
+
+/** @brief Writes a table to a chunked columnar file.
+ *
+ * @detail
+ * # Purpose
+ * Derived tables of candidates and events are read many times over with
+ * different cuts. This class writes them column by column, in chunks of
+ * a fixed number of rows, and keeps a zone map of every column of every
+ * chunk: its null count and the range of its values. ColumnarReader
+ * uses the zone maps to skip every chunk that cannot satisfy a range
+ * cut, and only reads the columns asked for.
+ *
+ * # Encoding
+ * Every value may be null; rows start out all null, and `set()` fills
+ * in values. Columns declared with Encoding::kDictionary, e.g. the
+ * modes of a candidate, are stored per chunk as a dictionary of the
+ * distinct values and one code per row, of 1, 2 or 4 bytes depending on
+ * the size of the dictionary. String columns, e.g. event Ids, are
+ * always dictionary encoded.
+ *
+ * Each column of a chunk is then compressed with ROOT's LZ4 codec, or
+ * stored as is if that does not make it smaller.
+ *
+ * # Format
+ *     "BDTCOL01"
+ *     column blocks, chunk by chunk
+ *     footer: schema, rows of each chunk, and for every column of every
+ *             chunk its offset, sizes, and zone map
+ *     footer size (uint64), "BDTCOL01"
+ *
+ * Numbers are little endian, as laid out in memory on the machines we
+ * run on.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     ColumnarWriter w("cands.col");
+ *     int eid = w.add_column("eventId", ColumnType::kString);
+ *     int ee = w.add_column("eextra50", ColumnType::kFloat);
+ *     int mode = w.add_column("sig_d_mode", ColumnType::kInt32,
+ *                             ColumnarWriter::Encoding::kDictionary);
+ *     for (...) {
+ *       w.set(eid, cand.get_eventId());
+ *       w.set(ee, cand.get_eextra50());
+ *       w.set(mode, static_cast<int>(cand.get_sig_d_mode()));
+ *       w.end_row();
+ *     }
+ *     w.close();
+ */
+class ColumnarWriter {
+
+  public:
+
+    //! How the values of a column are stored.
+    enum class Encoding {
+      kPlain = 0,
+      kDictionary = 1,
+    };
+
+    ColumnarWriter() = delete;
+
+    //! Write to `fname`, `chunk_rows` rows per chunk.
+    ColumnarWriter(const std::string &fname, Long64_t chunk_rows = 16384);
+    ColumnarWriter(const ColumnarWriter&) = delete;
+    ColumnarWriter &operator=(const ColumnarWriter&) = delete;
+
+    //! Closes the file if not closed yet.
+    ~ColumnarWriter();
+
+    //! Add a column and return its index. Call before the first row.
+    int add_column(const std::string &name, ColumnType type,
+                   Encoding encoding = Encoding::kPlain);
+
+    //! ROOT compression level of the LZ4 codec; 0 stores columns as is.
+    /*! Defaults to 1. */
+    void set_compression_level(int level) { compression_level = level; }
+
+    //! Set a value of the current row.
+    /*! An int may be stored in a 32 or 64 bit integer column, and a
+     * float in a float or double column. Any other mismatch of value and
+     * column type is an error. */
+    void set(int column, int value);
+    void set(int column, Long64_t value);
+    void set(int column, float value);
+    void set(int column, double value);
+    void set(int column, const std::string &value);
+
+    //! Make a value of the current row null; values are null unless set.
+    void set_null(int column);
+
+    //! Append the current row, and start a new one.
+    void end_row();
+
+    //! Write the last chunk and the footer, and close the file.
+    void close();
+
+    //! Number of rows appended.
+    Long64_t get_num_rows() const { return nrows; }
+
+    const std::string &get_fname() const { return fname; }
+
+  private:
+
+    struct Column {
+      std::string name;
+      ColumnType type;
+      Encoding encoding;
+
+      // Value of the current row.
+      bool pending_set = false;
+      std::int64_t pending_int = 0;
+      double pending_double = 0;
+      std::string pending_string;
+
+      // Current chunk. Numbers are stored at their width; strings as
+      // codes into the chunk dictionary.
+      std::vector<char> values;
+      std::vector<std::uint8_t> valid;
+      std::vector<std::string> dictionary;
+      std::unordered_map<std::string, std::uint32_t> codes;
+      ColumnStats stats;
+    };
+
+    // Where one column of one chunk is stored, and its zone map.
+    struct Block {
+      std::uint64_t offset, stored_size, raw_size;
+      bool compressed;
+      ColumnStats stats;
+    };
+
+    std::string fname;
+    std::ofstream os;
+    Long64_t chunk_rows;
+    int compression_level;
+    Long64_t nrows;
+    Long64_t rows_in_chunk;
+    bool closed;
+
+    std::vector<Column> columns;
+    std::vector<Long64_t> chunk_nrows;
+    std::vector<std::vector<Block>> blocks;
+
+    Column &GetColumn(int column, ColumnType type, ColumnType alt);
+    void FlushChunk();
+    std::vector<char> EncodeColumn(const Column &c) const;
+};
+
+
+/** @brief Reads a table written by ColumnarWriter, skipping chunks with
+ * zone maps.
+ *
+ * @detail
+ * The footer is read on construction. `select_columns()` restricts the
+ * columns that are read, and `add_range()` adds a cut
+ * \f$lo \le x \le hi\f$ on a numeric column; all cuts must hold.
+ *
+ * `next_chunk()` loads the next chunk whose zone maps allow every cut to
+ * hold, and skips the rest without reading them. `next_row()` moves to
+ * the next row that passes the cuts, loading chunks as needed. A row
+ * with a null or NaN value never passes a cut on that column.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     ColumnarReader r("cands.col");
+ *     r.select_columns({"eventId", "mmiss_prime2"});
+ *     r.add_range("eextra50", 0, 0.5);
+ *     int eid = r.find_column("eventId");
+ *     int mm = r.find_column("mmiss_prime2");
+ *     while (r.next_row()) {
+ *       if (!r.is_null(mm)) std::cout << r.get_string(eid) << " " << r.get_float(mm) << std::endl;
+ *     }
+ */
+class ColumnarReader {
+
+  public:
+
+    ColumnarReader() = delete;
+    ColumnarReader(const std::string &fname);
+    ColumnarReader(const ColumnarReader&) = delete;
+    ColumnarReader &operator=(const ColumnarReader&) = delete;
+    ~ColumnarReader() {};
+
+    size_t get_num_columns() const { return columns.size(); }
+    const std::string &get_column_name(int column) const { return columns[column].name; }
+    ColumnType get_column_type(int column) const { return columns[column].type; }
+
+    //! Index of the column named `name`, or -1.
+    int find_column(const std::string &name) const;
+
+    Long64_t get_num_rows() const { return nrows; }
+    size_t get_num_chunks() const { return chunk_nrows.size(); }
+    Long64_t get_chunk_rows(size_t chunk) const { return chunk_nrows[chunk]; }
+
+    //! Zone map of a column of a chunk.
+    const ColumnStats &get_stats(size_t chunk, int column) const { return blocks[chunk][column].stats; }
+
+    //! Only read the named columns, and the ones cut on.
+    /*! Defaults to all columns. Call before the first chunk is read. */
+    void select_columns(const std::vector<std::string> &names);
+
+    //! Only keep rows with `lo <= value <= hi` in the named column.
+    /*! Call before the first chunk is read. */
+    void add_range(const std::string &name, double lo, double hi);
+
+    //! Load the next chunk that may hold rows that pass the cuts.
+    /*! Returns false when there are no more. Rows of the chunk are then
+     * read with `set_row()`, without regard to the cuts. */
+    bool next_chunk();
+
+    //! Move to the next row that passes the cuts.
+    /*! Returns false when there are no more. */
+    bool next_row();
+
+    //! Move to row `row` of the loaded chunk.
+    void set_row(Long64_t row) { chunk_row = row; }
+
+    //! Index of the loaded chunk.
+    size_t get_chunk_index() const { return chunk; }
+
+    //! Index in the file of the current row.
+    Long64_t get_row_index() const { return chunk_first_row + chunk_row; }
+
+    //! Start over from the first chunk.
+    void rewind();
+
+    //! Values of the current row.
+    /*! The column must have been read, and the getter must match its
+     * type; get_int64() and get_double() also read 32 bit integer and
+     * float columns. The value of a null is 0 or "". */
+    bool is_null(int column) const;
+    int get_int32(int column) const;
+    Long64_t get_int64(int column) const;
+    float get_float(int column) const;
+    double get_double(int column) const;
+    const std::string &get_string(int column) const;
+
+    //! Number of chunks loaded, and skipped by their zone maps.
+    size_t get_chunks_read() const { return chunks_read; }
+    size_t get_chunks_skipped() const { return chunks_skipped; }
+
+  private:
+
+    struct Column {
+      std::string name;
+      ColumnType type;
+      int encoding;
+      bool selected = true;
+
+      // Loaded chunk, decoded. Strings are kept as codes into the
+      // chunk dictionary.
+      bool loaded = false;
+      std::vector<char> values;
+      std::vector<std::uint8_t> valid;
+      std::vector<std::string> dictionary;
+      std::vector<std::uint32_t> codes;
+    };
+
+    struct Block {
+      std::uint64_t offset, stored_size, raw_size;
+      bool compressed;
+      ColumnStats stats;
+    };
+
+    struct Range {
+      int column;
+      double lo, hi;
+    };
+
+    std::string fname;
+    std::ifstream is;
+    Long64_t nrows;
+    std::vector<Column> columns;
+    std::vector<Long64_t> chunk_nrows;
+    std::vector<std::vector<Block>> blocks;
+    std::vector<Range> ranges;
+
+    size_t next;
+    size_t chunk;
+    Long64_t chunk_first_row;
+    Long64_t chunk_row;
+    bool chunk_loaded;
+    size_t chunks_read;
+    size_t chunks_skipped;
+
+    void ReadFooter();
+    bool MayPass(size_t chunk) const;
+    bool Passes() const;
+    void LoadColumn(int column);
+    const Column &GetColumn(int column, ColumnType type, ColumnType alt) const;
+};
+
+#endif
@@ -0,0 +1,229 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+
+#include <sys/stat.h>
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TObjArray.h>
+
+#include "DatasetManifest.h"
+#include "FilePrefetcher.h"
+
+const char *DatasetManifest::count_name(int c) {
+  static const char *names[] = {
+    "nY", "nB", "nD", "nC", "nh", "nl", "ngamma", "mcLen",
+  };
+  return names[c];
+}
+
+// Open the file once and read only the block counts.
+DatasetManifest::FileEntry DatasetManifest::ScanFile(
+    const std::string &root_fname, const char *root_trname,
+    std::vector<std::string> &branches) {
+
+  FileEntry f;
+  f.fname = root_fname;
+  branches.clear();
+
+  struct stat st;
+  if (stat(root_fname.c_str(), &st) == 0) {
+    f.file_size = st.st_size;
+    f.mtime = st.st_mtime;
+  }
+
+  TFile *tfile = nullptr;
+  TTree *tr = nullptr;
+  f.error = FilePrefetcher::OpenTree(root_fname, root_trname, tfile, tr);
+  if (!f.error.empty()) return f;
+
+  f.entries = tr->GetEntries();
+
+  TTree::TClusterIterator clusters = tr->GetClusterIterator(0);
+  Long64_t start;
+  while ((start = clusters.Next()) < f.entries) {
+    if (!f.cluster_starts.empty() && start <= f.cluster_starts.back()) break;
+    f.cluster_starts.push_back(start);
+  }
+
+  TObjArray *list = tr->GetListOfBranches();
+  for (int i = 0; list && i < list->GetEntriesFast(); ++i) {
+    branches.push_back(list->At(i)->GetName());
+  }
+
+  int count[kNCounts];
+  tr->SetBranchStatus("*", 0);
+  for (int c = 0; c < kNCounts; ++c) {
+    count[c] = 0;
+    if (std::find(branches.begin(), branches.end(), count_name(c)) == branches.end()) {
+      f.max_count[c] = -1;
+      continue;
+    }
+    tr->SetBranchStatus(count_name(c), 1);
+    tr->SetBranchAddress(count_name(c), &count[c]);
+  }
+
+  for (Long64_t i = 0; i < f.entries; ++i) {
+    tr->GetEntry(i);
+    for (int c = 0; c < kNCounts; ++c) {
+      if (f.max_count[c] >= 0) f.max_count[c] = std::max(f.max_count[c], count[c]);
+    }
+  }
+
+  tfile->Close();
+  delete tfile;
+  return f;
+}
+
+DatasetManifest DatasetManifest::Build(
+    const std::vector<std::string> &root_fnames,
+    const char *root_trname, int nthreads) {
+
+  DatasetManifest m;
+  m.root_trname = root_trname;
+  m.files.resize(root_fnames.size());
+  std::vector<std::vector<std::string>> branches(root_fnames.size());
+
+  int n = nthreads;
+  if (n <= 0) n = std::thread::hardware_concurrency();
+  if (n <= 0) n = 1;
+  n = std::min<int>(n, root_fnames.size());
+
+  // Same scheme as McYieldTally: each thread takes the next file.
+  if (n > 1) ROOT::EnableThreadSafety();
+  std::atomic<int> next_file(0);
+  auto scan = [&] () {
+    int f;
+    while ((f = next_file++) < static_cast<int>(root_fnames.size())) {
+      m.files[f] = ScanFile(root_fnames[f], root_trname, branches[f]);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int i = 1; i < n; ++i) workers.push_back(std::thread(scan));
+  scan();
+  for (auto &w : workers) w.join();
+
+  for (size_t f = 0; f < m.files.size(); ++f) {
+    if (m.files[f].error.empty()) m.files[f].schema = m.AddSchema(branches[f]);
+  }
+
+  return m;
+}
+
+int DatasetManifest::AddSchema(const std::vector<std::string> &branches) {
+  auto it = std::find(schemas.begin(), schemas.end(), branches);
+  if (it != schemas.end()) return it - schemas.begin();
+  schemas.push_back(branches);
+  return schemas.size() - 1;
+}
+
+void DatasetManifest::write(std::ostream &os) const {
+
+  os << "# bdtaunu dataset manifest 1\n";
+  os << "tree " << root_trname << "\n";
+
+  for (size_t s = 0; s < schemas.size(); ++s) {
+    os << "schema " << s << " " << schemas[s].size();
+    for (const auto &b : schemas[s]) os << " " << b;
+    os << "\n";
+  }
+
+  for (const auto &f : files) {
+    if (!f.error.empty()) {
+      os << "error " << f.fname << " " << f.error << "\n";
+      continue;
+    }
+    os << "file " << f.fname << " " << f.file_size << " " << f.mtime;
+    os << " " << f.entries << " " << f.schema;
+    for (int c = 0; c < kNCounts; ++c) os << " " << f.max_count[c];
+    os << "\n";
+    os << "clusters " << f.cluster_starts.size();
+    for (auto s : f.cluster_starts) os << " " << s;
+    os << "\n";
+  }
+}
+
+DatasetManifest DatasetManifest::Read(std::istream &is) {
+
+  DatasetManifest m;
+  std::string line;
+  int lineno = 0;
+  auto fail = [&lineno] () {
+    std::cerr << "DatasetManifest: malformed line " << lineno << std::endl;
+    exit(EXIT_FAILURE);
+  };
+
+  while (std::getline(is, line)) {
+    ++lineno;
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream ss(line);
+    std::string kind;
+    ss >> kind;
+
+    if (kind == "tree") {
+      ss >> m.root_trname;
+    } else if (kind == "schema") {
+      size_t s, n;
+      if (!(ss >> s >> n) || s != m.schemas.size()) fail();
+      std::vector<std::string> branches(n);
+      for (auto &b : branches) if (!(ss >> b)) fail();
+      m.schemas.push_back(branches);
+    } else if (kind == "file") {
+      FileEntry f;
+      ss >> f.fname >> f.file_size >> f.mtime >> f.entries >> f.schema;
+      for (int c = 0; c < kNCounts; ++c) ss >> f.max_count[c];
+      if (!ss || f.schema < 0 || f.schema >= static_cast<int>(m.schemas.size())) fail();
+      m.files.push_back(f);
+    } else if (kind == "clusters") {
+      size_t n;
+      if (m.files.empty() || !(ss >> n)) fail();
+      std::vector<Long64_t> &starts = m.files.back().cluster_starts;
+      starts.resize(n);
+      for (auto &s : starts) if (!(ss >> s)) fail();
+    } else if (kind == "error") {
+      FileEntry f;
+      ss >> f.fname;
+      std::getline(ss >> std::ws, f.error);
+      if (f.error.empty()) f.error = "unknown error";
+      m.files.push_back(f);
+    } else {
+      fail();
+    }
+  }
+
+  return m;
+}
+
+const std::vector<std::string> &DatasetManifest::get_branches(const FileEntry &f) const {
+  static const std::vector<std::string> none;
+  return (f.schema >= 0) ? schemas[f.schema] : none;
+}
+
+Long64_t DatasetManifest::get_total_entries() const {
+  Long64_t n = 0;
+  for (const auto &f : files) n += f.entries;
+  return n;
+}
+
+int DatasetManifest::get_max_count(Count c) const {
+  int m = -1;
+  for (const auto &f : files) {
+    if (f.error.empty()) m = std::max(m, f.max_count[c]);
+  }
+  return m;
+}
+
+bool DatasetManifest::is_current(const FileEntry &f) {
+  struct stat st;
+  if (stat(f.fname.c_str(), &st) != 0) return false;
+  return st.st_size == f.file_size && st.st_mtime == f.mtime;
+}
@@ -0,0 +1,116 @@
+#ifndef __DATASETMANIFEST_H__
+#define __DATASETMANIFEST_H__
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Rtypes.h>
+
+/** @brief What is in each file of a dataset, recorded once.
+ *
+ * @detail
+ * # Purpose
+ * Planning a run over thousands of files should not mean opening each
+ * of them. `Build()` scans a dataset once, in parallel, and records for
+ * every file:
+ * * Its size and modification time, to tell when the entry is stale.
+ * * The number of entries and the first entry of every cluster, so that
+ *   work can be split at cluster boundaries.
+ * * The list of top level branches, and whether the MC truth branches
+ *   are present, so BDtaunuReader or BDtaunuMcReader can be picked.
+ * * The largest value of each block count, `nY`, `nB`, `nD`, `nC`, `nh`,
+ *   `nl`, `ngamma`, and `mcLen`, for buffer sizing and cap checks.
+ *
+ * Files that cannot be opened are recorded with the error instead.
+ *
+ * # Sidecar format
+ * `write()` produces a text file. Branch lists are shared by most
+ * files, so each distinct list is written once as a schema and files
+ * refer to it by number:
+ *
+ *     # bdtaunu dataset manifest 1
+ *     tree ntp1
+ *     schema 0 <nbranches> <branch> ...
+ *     file <path> <size> <mtime> <entries> <schema> <max nY> ... <max mcLen>
+ *     clusters <nclusters> <first entry> ...
+ *     error <path> <message>
+ *
+ * Usage Example
+ * -------------
+ *
+ *     DatasetManifest m = DatasetManifest::Build(fnames, "ntp1", 8);
+ *     std::ofstream out("sp1235.manifest");
+ *     m.write(out);
+ *
+ *     std::ifstream in("sp1235.manifest");
+ *     DatasetManifest m2 = DatasetManifest::Read(in);
+ *     m2.get_total_entries();
+ */
+class DatasetManifest {
+
+  public:
+
+    //! Block counts whose largest value is recorded.
+    enum Count { knY, knB, knD, knC, knh, knl, kngamma, kmcLen, kNCounts };
+
+    //! Branch name of a block count.
+    static const char *count_name(int c);
+
+    //! Manifest entry of one file.
+    struct FileEntry {
+      std::string fname;
+      Long64_t file_size = 0;
+      long mtime = 0;
+      Long64_t entries = 0;
+      std::vector<Long64_t> cluster_starts;   //!< first entry of each cluster
+      int schema = -1;                        //!< index into get_schemas()
+      int max_count[kNCounts] = {};           //!< -1 if the branch is missing
+      std::string error;                      //!< non-empty if the file is unreadable
+
+      bool is_mc() const { return max_count[kmcLen] >= 0; }
+    };
+
+    DatasetManifest() = default;
+
+    //! Scan `root_fnames` with `nthreads` threads; 0 means one per
+    //! hardware thread.
+    static DatasetManifest Build(const std::vector<std::string> &root_fnames,
+                                 const char *root_trname = "ntp1",
+                                 int nthreads = 0);
+
+    //! Scan one file.
+    static FileEntry ScanFile(const std::string &root_fname, const char *root_trname,
+                              std::vector<std::string> &branches);
+
+    //! Read a manifest written by `write()`. Exits on a malformed file.
+    static DatasetManifest Read(std::istream &is);
+
+    //! Write the sidecar format described above.
+    void write(std::ostream &os) const;
+
+    const std::string &get_tree_name() const { return root_trname; }
+    const std::vector<FileEntry> &get_files() const { return files; }
+    const std::vector<std::vector<std::string>> &get_schemas() const { return schemas; }
+
+    //! Branches of a file; empty if it could not be read.
+    const std::vector<std::string> &get_branches(const FileEntry &f) const;
+
+    //! Entries summed over the readable files.
+    Long64_t get_total_entries() const;
+
+    //! Largest value of a block count over the readable files.
+    int get_max_count(Count c) const;
+
+    //! Whether the file still has the size and mtime it was scanned with.
+    static bool is_current(const FileEntry &f);
+
+  private:
+    std::string root_trname;
+    std::vector<FileEntry> files;
+    std::vector<std::vector<std::string>> schemas;
+
+    int AddSchema(const std::vector<std::string> &branches);
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+#include "DecayDictionary.h"
+
+void DecayDictionary::insert(Signature s, const std::string &decay) {
+  auto result = dict.insert(std::make_pair(s, decay));
+  assert(result.second || result.first->second == decay);
+}
+
+const std::string &DecayDictionary::get_decay_string(Signature s) const {
+  static const std::string empty;
+  auto it = dict.find(s);
+  return (it != dict.end()) ? it->second : empty;
+}
+
+void DecayDictionary::merge(const DecayDictionary &other) {
+  for (const auto &entry : other.dict) insert(entry.first, entry.second);
+}
+
+// Entries are written in signature order so that the output is reproducible. 
+void DecayDictionary::write(std::ostream &os) const {
+  std::vector<Signature> keys;
+  for (const auto &entry : dict) keys.push_back(entry.first);
+  std::sort(keys.begin(), keys.end());
+
+  std::ios::fmtflags flags = os.flags();
+  char fill = os.fill();
+  for (auto k : keys) {
+    os << std::hex << std::setw(16) << std::setfill('0') << k;
+    os << std::dec << "\t" << dict.find(k)->second << "\n";
+  }
+  os.flags(flags);
+  os.fill(fill);
+}
@@ -0,0 +1,59 @@
+#ifndef __DECAYDICTIONARY_H__
+#define __DECAYDICTIONARY_H__
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+/** @brief Interned dictionary of decay chain signatures.
+ *
+ * @detail
+ * McGraphManager summarizes the decay chain of each truth \f$B\f$ as a 
+ * 64 bit signature (See McGraphManager.h). This class maps each signature 
+ * seen during a run to a human readable decay string, so that the decay 
+ * string only has to be built the first time a signature is encountered. 
+ *
+ * Dictionaries filled by different readers can be combined with `merge()`.
+ */
+class DecayDictionary {
+
+  public:
+
+    typedef std::uint64_t Signature;
+
+    DecayDictionary() = default;
+    DecayDictionary(const DecayDictionary&) = default;
+    DecayDictionary &operator=(const DecayDictionary&) = default;
+    ~DecayDictionary() {};
+
+    //! Decide whether the signature has been interned. 
+    bool contains(Signature s) const { return dict.find(s) != dict.end(); }
+
+    //! Intern a signature with its decay string. 
+    /*! Nothing happens if the signature is already present. */
+    void insert(Signature s, const std::string &decay);
+
+    //! Decay string of an interned signature, or the empty string. 
+    const std::string &get_decay_string(Signature s) const;
+
+    //! Number of interned signatures. 
+    std::size_t size() const { return dict.size(); }
+
+    //! Add all entries of another dictionary to this one. 
+    void merge(const DecayDictionary &other);
+
+    //! Clear cache. 
+    void clear() { dict.clear(); }
+
+    //! Get the underlying map with signature : decay string. 
+    const std::unordered_map<Signature, std::string> &get_map() const { return dict; }
+
+    //! Write one line per entry with the hexadecimal signature and decay string.
+    void write(std::ostream &os) const;
+
+  private:
+    std::unordered_map<Signature, std::string> dict;
+};
+
+#endif
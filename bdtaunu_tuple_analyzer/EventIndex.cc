@@ -0,0 +1,219 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <tuple>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+
+#include "EventIndex.h"
+#include "FilePrefetcher.h"
+
+static const char magic[8] = { 'B', 'D', 'T', 'E', 'V', 'I', 'X', '1' };
+
+// Records are mapped straight from the file.
+static_assert(sizeof(EventIndex::Record) == 32, "EventIndex::Record layout changed");
+
+bool EventIndex::Key::operator<(const Key &k) const {
+  return std::tie(platform, partition, upperID, lowerID)
+       < std::tie(k.platform, k.partition, k.upperID, k.lowerID);
+}
+
+bool EventIndex::Key::operator==(const Key &k) const {
+  return platform == k.platform && partition == k.partition
+      && upperID == k.upperID && lowerID == k.lowerID;
+}
+
+bool EventIndex::ParseEventId(const std::string &eventId, Key &key) {
+  int n = 0;
+  return std::sscanf(eventId.c_str(), "%d:%d:%d/%d%n",
+                     &key.platform, &key.partition, &key.upperID, &key.lowerID, &n) == 4
+      && n == static_cast<int>(eventId.size());
+}
+
+std::string EventIndex::FormatEventId(const Key &key) {
+  return std::to_string(key.platform)
+         + ":" + std::to_string(key.partition)
+         + ":" + std::to_string(key.upperID)
+         + "/" + std::to_string(key.lowerID);
+}
+
+// Read only the event Id branches of one file.
+std::string EventIndex::ScanFile(const std::string &root_fname, const char *root_trname,
+                                 int file, std::vector<Record> &out) {
+
+  TFile *tfile = nullptr;
+  TTree *tr = nullptr;
+  std::string error = FilePrefetcher::OpenTree(root_fname, root_trname, tfile, tr);
+  if (!error.empty()) return error;
+
+  Record r;
+  r.file = file;
+  tr->SetBranchStatus("*", 0);
+  tr->SetBranchStatus("platform", 1);
+  tr->SetBranchStatus("partition", 1);
+  tr->SetBranchStatus("upperID", 1);
+  tr->SetBranchStatus("lowerID", 1);
+  tr->SetBranchAddress("platform", &r.key.platform);
+  tr->SetBranchAddress("partition", &r.key.partition);
+  tr->SetBranchAddress("upperID", &r.key.upperID);
+  tr->SetBranchAddress("lowerID", &r.key.lowerID);
+
+  Long64_t nentries = tr->GetEntries();
+  out.reserve(nentries);
+  for (r.entry = 0; r.entry < nentries; ++r.entry) {
+    tr->GetEntry(r.entry);
+    out.push_back(r);
+  }
+
+  tfile->Close();
+  delete tfile;
+  return error;
+}
+
+EventIndex EventIndex::Build(
+    const std::vector<std::string> &root_fnames,
+    const char *root_trname, int nthreads) {
+
+  EventIndex index;
+  index.files = root_fnames;
+  std::vector<std::vector<Record>> records(root_fnames.size());
+  std::vector<std::string> errors(root_fnames.size());
+
+  int n = nthreads;
+  if (n <= 0) n = std::thread::hardware_concurrency();
+  if (n <= 0) n = 1;
+  n = std::max(1, std::min<int>(n, root_fnames.size()));
+
+  // Same scheme as McYieldTally: each thread takes the next file.
+  if (n > 1) ROOT::EnableThreadSafety();
+  std::atomic<int> next_file(0);
+  auto scan = [&] () {
+    int f;
+    while ((f = next_file++) < static_cast<int>(root_fnames.size())) {
+      errors[f] = ScanFile(root_fnames[f], root_trname, f, records[f]);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int i = 1; i < n; ++i) workers.push_back(std::thread(scan));
+  scan();
+  for (auto &w : workers) w.join();
+
+  size_t total = 0;
+  for (size_t f = 0; f < root_fnames.size(); ++f) {
+    if (!errors[f].empty()) {
+      std::cerr << "EventIndex: " << errors[f] << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    total += records[f].size();
+  }
+
+  // Files were scanned in order, so a stable sort keeps duplicates in
+  // file order.
+  index.built.reserve(total);
+  for (auto &r : records) {
+    index.built.insert(index.built.end(), r.begin(), r.end());
+    std::vector<Record>().swap(r);
+  }
+  std::stable_sort(index.built.begin(), index.built.end(),
+      [] (const Record &a, const Record &b) { return a.key < b.key; });
+
+  return index;
+}
+
+void EventIndex::write(const std::string &index_fname) const {
+
+  std::string names;
+  for (const auto &f : files) names.append(f.c_str(), f.size() + 1);
+  names.resize((names.size() + 7) / 8 * 8, '\0');
+
+  uint64_t header[3] = { files.size(), size(), names.size() };
+
+  std::ofstream os(index_fname, std::ios::binary);
+  os.write(magic, sizeof(magic));
+  os.write(reinterpret_cast<const char*>(header), sizeof(header));
+  os.write(names.data(), names.size());
+  os.write(reinterpret_cast<const char*>(begin()), size() * sizeof(Record));
+  if (!os) {
+    std::cerr << "EventIndex: cannot write " << index_fname << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+EventIndex EventIndex::Open(const std::string &index_fname) {
+
+  auto fail = [&index_fname] (const char *what) {
+    std::cerr << "EventIndex: " << index_fname << ": " << what << std::endl;
+    exit(EXIT_FAILURE);
+  };
+
+  int fd = open(index_fname.c_str(), O_RDONLY);
+  if (fd < 0) fail(std::strerror(errno));
+  struct stat st;
+  if (fstat(fd, &st) != 0) fail(std::strerror(errno));
+  size_t length = st.st_size;
+
+  uint64_t header[3];
+  const size_t header_size = sizeof(magic) + sizeof(header);
+  if (length < header_size) fail("not an event index");
+
+  void *base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) fail(std::strerror(errno));
+
+  EventIndex index;
+  index.mapping = std::shared_ptr<const void>(base, [length] (const void *p) {
+    munmap(const_cast<void*>(p), length);
+  });
+
+  const char *p = static_cast<const char*>(base);
+  if (std::memcmp(p, magic, sizeof(magic)) != 0) fail("not an event index");
+  std::memcpy(header, p + sizeof(magic), sizeof(header));
+  if (header[2] % 8 != 0 ||
+      length != header_size + header[2] + header[1] * sizeof(Record)) {
+    fail("truncated");
+  }
+
+  const char *name = p + header_size;
+  const char *names_end = name + header[2];
+  for (uint64_t f = 0; f < header[0]; ++f) {
+    const char *nul = static_cast<const char*>(std::memchr(name, '\0', names_end - name));
+    if (!nul) fail("truncated");
+    index.files.push_back(std::string(name, nul));
+    name = nul + 1;
+  }
+
+  index.mapped = reinterpret_cast<const Record*>(names_end);
+  index.nmapped = header[1];
+  return index;
+}
+
+bool EventIndex::find(const Key &key, std::string &fname, Long64_t &entry) const {
+  const Record *r = std::lower_bound(begin(), end(), key,
+      [] (const Record &a, const Key &k) { return a.key < k; });
+  if (r == end() || !(r->key == key)) return false;
+  if (r->file < 0 || r->file >= static_cast<int>(files.size())) return false;
+  fname = files[r->file];
+  entry = r->entry;
+  return true;
+}
+
+bool EventIndex::find(const std::string &eventId, std::string &fname, Long64_t &entry) const {
+  Key key;
+  return ParseEventId(eventId, key) && find(key, fname, entry);
+}
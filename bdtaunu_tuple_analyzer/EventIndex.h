@@ -0,0 +1,109 @@
+#ifndef __EVENTINDEX_H__
+#define __EVENTINDEX_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <Rtypes.h>
+
+/** @brief Where each event of a dataset is, by BaBar event Id.
+ *
+ * @detail
+ * # Purpose
+ * Finding one event used to mean calling `next_record()` from the start
+ * of a file until `get_eventId()` matched. `Build()` reads only the
+ * `platform`, `partition`, `upperID`, and `lowerID` branches of every
+ * file, in parallel, and records the file and entry of each event.
+ * Lookups are then a binary search, and BDtaunuReader::seek_event()
+ * jumps straight to the entry.
+ *
+ * # File format
+ * `write()` stores the index as a binary table, which `Open()` maps
+ * into memory rather than reading, so opening the index of a large
+ * dataset costs nothing until it is searched:
+ *
+ *     "BDTEVIX1"                 8 byte magic
+ *     nfiles, nrecords, nbytes   uint64 each
+ *     file names                 nbytes, NUL terminated, padded to 8
+ *     records                    nrecords Records, sorted by Key
+ *
+ * The table is written in the byte order of the machine that built it.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     EventIndex index = EventIndex::Build(fnames, "ntp1", 8);
+ *     index.write("sp1235.evidx");
+ *
+ *     std::string fname;
+ *     Long64_t entry;
+ *     EventIndex::Open("sp1235.evidx").find("1:1:0/42", fname, entry);
+ */
+class EventIndex {
+
+  public:
+
+    //! BaBar event Id.
+    struct Key {
+      int platform, partition, upperID, lowerID;
+
+      bool operator<(const Key &k) const;
+      bool operator==(const Key &k) const;
+    };
+
+    //! One event: its Id, and the file and entry it is stored at.
+    struct Record {
+      Key key;
+      int file;          //!< index into get_files()
+      Long64_t entry;
+    };
+
+    EventIndex() = default;
+
+    //! Index `root_fnames` with `nthreads` threads; 0 means one per
+    //! hardware thread. Exits if a file cannot be read.
+    static EventIndex Build(const std::vector<std::string> &root_fnames,
+                            const char *root_trname = "ntp1",
+                            int nthreads = 0);
+
+    //! Map an index written by `write()`. Exits on a malformed file.
+    static EventIndex Open(const std::string &index_fname);
+
+    //! Write the table described above.
+    void write(const std::string &index_fname) const;
+
+    //! Parse `platform:partition:upperID/lowerID`, the format of
+    //! BDtaunuReader::get_eventId().
+    static bool ParseEventId(const std::string &eventId, Key &key);
+
+    //! Inverse of `ParseEventId()`.
+    static std::string FormatEventId(const Key &key);
+
+    //! Look up an event. If it is in several files, the first is found.
+    bool find(const Key &key, std::string &fname, Long64_t &entry) const;
+    bool find(const std::string &eventId, std::string &fname, Long64_t &entry) const;
+
+    const std::vector<std::string> &get_files() const { return files; }
+
+    //! Number of events indexed.
+    size_t size() const { return mapping ? nmapped : built.size(); }
+
+    //! Records in Key order.
+    const Record *begin() const { return mapping ? mapped : built.data(); }
+    const Record *end() const { return begin() + size(); }
+
+  private:
+    std::vector<std::string> files;
+
+    // Records are either built in memory, or mapped from a file.
+    std::vector<Record> built;
+    std::shared_ptr<const void> mapping;
+    const Record *mapped = nullptr;
+    size_t nmapped = 0;
+
+    static std::string ScanFile(const std::string &root_fname, const char *root_trname,
+                                int file, std::vector<Record> &out);
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+
+#include "FilePrefetcher.h"
+
+FilePrefetcher::FilePrefetcher(
+    const std::vector<std::string> &_root_fnames,
+    const std::string &_root_trname,
+    size_t first,
+    int _window_files,
+    Long64_t _window_bytes) :
+  root_fnames(_root_fnames), root_trname(_root_trname),
+  window_files(std::max(_window_files, 1)), window_bytes(_window_bytes),
+  prepared(_root_fnames.size()), next_take(first), stop(false) {
+  ROOT::EnableThreadSafety();
+  worker = std::thread(&FilePrefetcher::Run, this, first);
+}
+
+FilePrefetcher::~FilePrefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  cv.notify_all();
+  worker.join();
+
+  for (auto &p : prepared) {
+    if (!p.file) continue;
+    p.file->Close();
+    delete p.file;
+  }
+}
+
+std::string FilePrefetcher::take(size_t i, TFile *&file, TTree *&tree, 
+                                 StagingCache::Lease &lease) {
+  std::unique_lock<std::mutex> lock(mutex);
+  next_take = i + 1;
+  cv.notify_all();
+  cv.wait(lock, [this, i] { return prepared[i].ready; });
+
+  file = prepared[i].file;
+  tree = prepared[i].tree;
+  lease = std::move(prepared[i].lease);
+  prepared[i].file = nullptr;
+  prepared[i].tree = nullptr;
+  return prepared[i].error;
+}
+
+// Prepare each file once it is inside the look-ahead window.
+void FilePrefetcher::Run(size_t first) {
+  for (size_t i = first; i < root_fnames.size(); ++i) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [this, i] { return stop || i < next_take + window_files; });
+      if (stop) return;
+    }
+
+    Prepared p;
+    p.lease = Stage(root_fnames[i]);
+    WarmPageCache(p.lease.get_path(), window_bytes / window_files);
+    p.error = OpenTree(p.lease.get_path(), root_trname, p.file, p.tree);
+    p.ready = true;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      prepared[i] = std::move(p);
+    }
+    cv.notify_all();
+  }
+}
+
+StagingCache::Lease FilePrefetcher::Stage(const std::string &root_fname) {
+  std::shared_ptr<StagingCache> cache = StagingCache::Default();
+  return cache ? cache->stage(root_fname) : StagingCache::Lease(root_fname);
+}
+
+std::string FilePrefetcher::OpenTree(const std::string &root_fname,
+                                     const std::string &root_trname,
+                                     TFile *&file, TTree *&tree) {
+  file = nullptr;
+  tree = nullptr;
+
+  TFile *f = new TFile(root_fname.c_str(), "r");
+  if (f->IsZombie()) {
+    delete f;
+    return "TFile* associated to \"" + root_fname + "\" is invalid.";
+  }
+
+  TTree *t = (TTree*) f->Get(root_trname.c_str());
+  if (!t) {
+    f->Close();
+    delete f;
+    return "no TTree with name \"" + root_trname + "\" in " + root_fname;
+  }
+
+  file = f;
+  tree = t;
+  return "";
+}
+
+// Advise the kernel first so that it can start reading ahead at once,
+// then read the range ourselves in case the advice is ignored.
+Long64_t FilePrefetcher::WarmPageCache(const std::string &fname, Long64_t nbytes) {
+
+  int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) return 0;
+
+  struct stat st;
+  if (fstat(fd, &st) == 0) nbytes = std::min(nbytes, static_cast<Long64_t>(st.st_size));
+
+#ifdef POSIX_FADV_WILLNEED
+  posix_fadvise(fd, 0, nbytes, POSIX_FADV_WILLNEED);
+#endif
+
+  static const size_t buffer_size = 1 << 20;
+  std::vector<char> buffer(buffer_size);
+  Long64_t nread = 0;
+  while (nread < nbytes) {
+    size_t n = std::min(static_cast<Long64_t>(buffer_size), nbytes - nread);
+    ssize_t r = read(fd, buffer.data(), n);
+    if (r <= 0) break;
+    nread += r;
+  }
+
+  close(fd);
+  return nread;
+}
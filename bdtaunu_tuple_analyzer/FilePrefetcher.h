@@ -0,0 +1,100 @@
+#ifndef __FILEPREFETCHER_H__
+#define __FILEPREFETCHER_H__
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include "StagingCache.h"
+
+/** @brief Opens the next files of a dataset on a helper thread.
+ *
+ * @detail
+ * # Purpose
+ * A multi-file RootReader spends the start of every file waiting for
+ * cold disk or NFS reads. While the reader works on file \f$k\f$, this
+ * class prepares the files after it on a helper thread:
+ * * Warms the start of each file into the page cache with
+ *   `posix_fadvise(POSIX_FADV_WILLNEED)` followed by background reads,
+ *   so that the reads are issued even where the advice is ignored.
+ *   Remote URLs are skipped.
+ * * Copies the file into the default StagingCache, if one is set, and
+ *   works on the copy from then on.
+ * * Opens the TFile and gets the TTree, so a broken file is found
+ *   before the reader reaches it.
+ *
+ * # Look-ahead window
+ * At most `window_files` files are prepared ahead of the one being
+ * read, and at most `window_bytes` bytes, split evenly among them, are
+ * warmed into the page cache. The memory used by the process itself is
+ * one read buffer plus the open TFile and TTree headers.
+ *
+ * ROOT must be thread safe for files to be opened off the main thread;
+ * the constructor calls `ROOT::EnableThreadSafety()`.
+ */
+class FilePrefetcher {
+
+  public:
+
+    //! Prepare `root_fnames[first]` onwards.
+    FilePrefetcher(const std::vector<std::string> &root_fnames,
+                   const std::string &root_trname,
+                   size_t first,
+                   int window_files,
+                   Long64_t window_bytes);
+    FilePrefetcher(const FilePrefetcher&) = delete;
+    FilePrefetcher &operator=(const FilePrefetcher&) = delete;
+
+    //! Stops the helper thread and closes the files that were not taken.
+    ~FilePrefetcher();
+
+    //! Wait until file `i` is open and take ownership of it.
+    /*! Files must be taken in order. `lease` is the staged copy that 
+     * was opened, if any. Returns an error message, and null pointers, 
+     * if the file or the tree could not be opened. */
+    std::string take(size_t i, TFile *&file, TTree *&tree, StagingCache::Lease &lease);
+
+    //! Stage `root_fname` in the default StagingCache, if one is set.
+    static StagingCache::Lease Stage(const std::string &root_fname);
+
+    //! Open `root_fname` and get the TTree `root_trname`.
+    /*! Returns an error message, and null pointers, on failure. */
+    static std::string OpenTree(const std::string &root_fname,
+                                const std::string &root_trname,
+                                TFile *&file, TTree *&tree);
+
+    //! Read up to the first `nbytes` of a local file into the page cache.
+    /*! Returns the number of bytes read. */
+    static Long64_t WarmPageCache(const std::string &fname, Long64_t nbytes);
+
+  private:
+    struct Prepared {
+      TFile *file = nullptr;
+      TTree *tree = nullptr;
+      std::string error;
+      StagingCache::Lease lease;
+      bool ready = false;
+    };
+
+    std::vector<std::string> root_fnames;
+    std::string root_trname;
+    int window_files;
+    Long64_t window_bytes;
+
+    std::vector<Prepared> prepared;
+    size_t next_take;
+    bool stop;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread worker;
+
+    void Run(size_t first);
+};
+
+#endif
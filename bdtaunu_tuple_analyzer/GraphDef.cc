@@ -99,3 +99,35 @@ void RecoGraph::RecoIndexer::set(std::initializer_list<int> l) {
   nl = *iter++;
   ngamma = *iter++;
 }
+
+
+// Tree
+// ----
+
+McGraph::Tree::Tree() : 
+  n(0), lund_arr(nullptr), moth_arr(nullptr), 
+  dau_arr(nullptr), daulen_arr(nullptr) {};
+
+McGraph::Tree::Tree(
+    int _n, const int *_lund, const int *_moth, 
+    const int *_dau, const int *_daulen) : 
+    n(_n), lund_arr(_lund), moth_arr(_moth), 
+    dau_arr(_dau), daulen_arr(_daulen) {};
+
+void McGraph::Tree::set(
+    int _n, const int *_lund, const int *_moth, 
+    const int *_dau, const int *_daulen) {
+  n = _n;
+  lund_arr = _lund;
+  moth_arr = _moth;
+  dau_arr = _dau;
+  daulen_arr = _daulen;
+}
+
+void McGraph::Tree::clear() {
+  n = 0;
+  lund_arr = nullptr;
+  moth_arr = nullptr;
+  dau_arr = nullptr;
+  daulen_arr = nullptr;
+}
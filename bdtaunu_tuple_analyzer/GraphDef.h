@@ -1,6 +1,7 @@
 #ifndef __GRAPHDEF_H_
 #define __GRAPHDEF_H_
 
+#include <cstdint>
 #include <initializer_list>
 #include <boost/graph/adjacency_list.hpp>
 
@@ -163,6 +164,64 @@ typedef typename boost::graph_traits<Graph>::adjacency_iterator AdjacencyIterato
 typedef typename boost::property_map<Graph, boost::vertex_lund_id_t>::type LundIdPropertyMap;
 typedef typename boost::property_map<Graph, boost::vertex_mc_index_t>::type McIndexPropertyMap;
 
+/** @brief Read only view of the MC truth tree stored in the reader's buffer.
+ *
+ * @detail 
+ * # Motivation
+ * BtaTupleMaker already saves the MC truth particles as a flat tree; the
+ * daughters of particle `i` occupy the contiguous index range 
+ * `[dauIdx[i], dauIdx[i] + dauLen[i])`. This class uses the buffer 
+ * arrays directly as the adjacency structure, so building it costs nothing 
+ * and it does not allocate. 
+ *
+ * # Implementation
+ * The vertices are the MC indices `0, ..., size() - 1`. The class only 
+ * holds pointers to the buffer; it is invalidated whenever the 
+ * supervising reader reads the next event. 
+ */
+class Tree {
+
+  private:
+    int n;
+    const int *lund_arr;
+    const int *moth_arr;
+    const int *dau_arr;
+    const int *daulen_arr;
+
+  public:
+    Tree();
+    Tree(int _n, const int *_lund, const int *_moth, 
+         const int *_dau, const int *_daulen);
+    Tree(const Tree &t) = default;
+    Tree &operator=(const Tree &t) = default;
+    ~Tree() {};
+
+    //! Number of MC particles in the tree.
+    int size() const { return n; }
+
+    //! Lund ID of the MC particle with index `i`.
+    int lund(int i) const { return lund_arr[i]; }
+
+    //! MC index of the mother of particle `i`; -1 if there is none.
+    int mother(int i) const { return moth_arr[i]; }
+
+    //! MC index of the first daughter of particle `i`.
+    int daughters_begin(int i) const { return dau_arr[i]; }
+
+    //! One past the MC index of the last daughter of particle `i`.
+    int daughters_end(int i) const { return dau_arr[i] + daulen_arr[i]; }
+
+    //! Number of daughters of particle `i`.
+    int n_daughters(int i) const { return daulen_arr[i]; }
+
+    //! Point the tree at a new set of buffer arrays.
+    void set(int _n, const int *_lund, const int *_moth, 
+             const int *_dau, const int *_daulen);
+
+    //! Clear cache.
+    void clear();
+};
+
 //! Data attached to vertices of \f$\tau\f$ leptons. 
 struct Tau {
   Tau() = default;
@@ -176,6 +235,7 @@ struct B {
   bdtaunu::McBTypeCatalogue::BMcType mc_type 
     = bdtaunu::McBTypeCatalogue::BMcType::null;
   Tau *tau = nullptr;
+  std::uint64_t signature = 0;  /*!< Decay chain signature. See McGraphManager.h. */
 };
 
 //! Data attached to vertices of \f$\Upsilon(4S)\f$ mesons. 
@@ -2,8 +2,11 @@
 #include <cmath>
 #include <cassert>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cstdint>
 
-#include <boost/graph/depth_first_search.hpp>
 #include <boost/graph/graphviz.hpp>
 
 #include "BDtaunuDef.h"
@@ -26,10 +29,27 @@ bool is_final_state_particle(int lund) {
      McGraphManager::final_state_particles.end()) ? false : true;
 }
 
-McGraphManager::McGraphManager() : reader(nullptr) { 
+McGraphManager::McGraphManager() : 
+  reader(nullptr), context(nullptr), signature_depth(2) { 
 }
 
-McGraphManager::McGraphManager(BDtaunuMcReader *_reader) : reader(_reader) { 
+McGraphManager::McGraphManager(
+    BDtaunuMcReader *_reader, const AnalysisContext &_context) : 
+  reader(_reader), context(&_context), signature_depth(2) { 
+  ResizeCache(BDtaunuMcReader::max_mc_length);
+}
+
+// Size the traversal and analysis caches to hold n MC particles. 
+void McGraphManager::ResizeCache(int n) {
+  dfs_color.resize(n);
+  dfs_stack.resize(n);
+  dfs_next.resize(n);
+  Y_cache.resize(n);
+  B_cache.resize(n);
+  Tau_cache.resize(n);
+  Y_list.reserve(n);
+  B_list.reserve(n);
+  daulund_list.reserve(n);
 }
 
 // Clear all cache.
@@ -40,17 +60,31 @@ void McGraphManager::clear() {
 
 // Clear graph cache. 
 void McGraphManager::ClearGraph() {
-  mc_vertex_map.clear();
-  g.clear();
+  tree.clear();
 }
 
-// Construct BGL graph from BDtaunuMcReader's buffer.
+// The MC truth particles are already stored as a flat tree in 
+// BDtaunuMcReader's buffer, so constructing the graph only amounts 
+// to pointing the tree at the buffer arrays. 
 void McGraphManager::construct_graph() {
 
   ClearGraph();
 
   assert(reader != nullptr);
 
+  tree.set(reader->mcLen, reader->mcLund, reader->mothIdx, 
+           reader->dauIdx, reader->dauLen);
+
+  if (static_cast<int>(dfs_color.size()) < tree.size()) 
+    ResizeCache(tree.size());
+}
+
+// Build BGL graph from the cached tree. The vertices are inserted in the 
+// same order as they are encountered while scanning the MC indices. 
+void McGraphManager::build_graph(Graph &g) const {
+
+  g.clear();
+
   // Each vertex has the following information attached:
   // 
   // 1. vertex_mc_index: The MC index of the particle. 
@@ -59,44 +93,34 @@ void McGraphManager::construct_graph() {
   McIndexPropertyMap mc_index = get(vertex_mc_index, g);
   LundIdPropertyMap lund_id = get(vertex_lund_id, g);
 
-  Vertex u, v;
+  // mc_vertex_map keeps track of which particle has been inserted. 
+  // The key is the MC index.
+  std::map<int, Vertex> mc_vertex_map;
   std::map<int, Vertex>::iterator pos;
   bool inserted;
 
-  for (int i = 0; i < reader->mcLen; i++) {
+  Vertex u, v;
+  for (int i = 0; i < tree.size(); i++) {
 
-    // Attempt to insert this particle into graph. If not already
-    // inserted, add a new vertex and return a handler to it. Otherwise, 
-    // just get the handler to its vertex. 
-    //
-    // mc_vertex_map keeps track of which particle has been inserted. 
-    // The key is the MC index.
-    int u_idx = i;
-    tie(pos, inserted) = mc_vertex_map.insert(std::make_pair(u_idx, Vertex()));
+    tie(pos, inserted) = mc_vertex_map.insert(std::make_pair(i, Vertex()));
     if (inserted) {
       u = add_vertex(g);
-      mc_index[u] = u_idx;
-      lund_id[u] = (reader->mcLund)[i];
-      mc_vertex_map[u_idx] = u;
+      mc_index[u] = i;
+      lund_id[u] = tree.lund(i);
+      pos->second = u;
     } else {
-      u = mc_vertex_map[u_idx];
+      u = pos->second;
     }
 
-    // Examine all daughters of this particle and insert any daughter
-    // that has not already been inserted. An edge is also inserted between 
-    // the particle and all its daughters.
-    int first_dau_idx = (reader->dauIdx)[i];
-    for (int j = 0; j < (reader->dauLen)[i]; j++) {
-
-      int v_idx = first_dau_idx + j;
-      tie(pos, inserted) = mc_vertex_map.insert(std::make_pair(v_idx, Vertex()));
+    for (int j = tree.daughters_begin(i); j < tree.daughters_end(i); j++) {
+      tie(pos, inserted) = mc_vertex_map.insert(std::make_pair(j, Vertex()));
       if (inserted) {
         v = add_vertex(g);
-        mc_index[v] = v_idx;
-        lund_id[v] = (reader->mcLund)[v_idx];
-        mc_vertex_map[v_idx] = v;
+        mc_index[v] = j;
+        lund_id[v] = tree.lund(j);
+        pos->second = v;
       } else {
-        v = mc_vertex_map[v_idx];
+        v = pos->second;
       }
 
       add_edge(u, v, g);
@@ -104,56 +128,179 @@ void McGraphManager::construct_graph() {
   }
 }
 
-// Clear graph analysis cache. 
+// Clear graph analysis cache. Only the lists need to be reset; 
+// cache entries are overwritten when their particle is analyzed. 
 void McGraphManager::ClearAnalysis() {
-  Y_map.clear();
-  B_map.clear();
-  Tau_map.clear();
+  Y_list.clear();
+  B_list.clear();
 }
 
-// Traverses BGL graph to compute analysis statistics.
+// Traverses the MC tree in post-order to compute analysis statistics.
+// Every particle is visited once; a new traversal is started from each 
+// particle that has not been reached yet, so particles whose mother 
+// is not in the tree are also analyzed. 
 void McGraphManager::analyze_graph() {
 
   ClearAnalysis();
 
   // See McGraphDfsVisitor.h for more information. 
-  depth_first_search(g, visitor(McGraphDfsVisitor(this)));
-  assert(Y_map.size() == 0 || Y_map.size() == 1);
-  assert(B_map.size() == 0 || B_map.size() == 2);
+  McGraphDfsVisitor vis(this);
+
+  std::fill(dfs_color.begin(), dfs_color.end(), 0);
+  for (int r = 0; r < tree.size(); r++) {
+
+    if (dfs_color[r]) continue;
+
+    int top = 0;
+    dfs_stack[top] = r;
+    dfs_next[top] = tree.daughters_begin(r);
+    dfs_color[r] = 1;
+
+    while (top >= 0) {
+      int u = dfs_stack[top];
+      if (dfs_next[top] < tree.daughters_end(u)) {
+        int v = dfs_next[top]++;
+        assert(v >= 0 && v < tree.size());
+        if (!dfs_color[v]) {
+          dfs_color[v] = 1;
+          ++top;
+          dfs_stack[top] = v;
+          dfs_next[top] = tree.daughters_begin(v);
+        }
+      } else {
+        vis.finish_vertex(u, tree);
+        --top;
+      }
+    }
+  }
+
+  // The B's are reported in MC index order. The daughters of the Y(4S)
+  // are contiguous, so this agrees with the order they appear in the tree. 
+  std::sort(B_list.begin(), B_list.end());
+
+  assert(Y_list.size() == 0 || Y_list.size() == 1);
+  assert(B_list.size() == 0 || B_list.size() == 2);
   return;
 }
 
 const Y* McGraphManager::get_mcY() const {
-  if (Y_map.size()) {
-    return &Y_map.begin()->second;
+  if (Y_list.size()) {
+    return &Y_cache[Y_list[0]];
   } else {
     return nullptr;
   }
 }
 
 const B* McGraphManager::get_mcB1() const {
-  if (B_map.size()) {
-    return &B_map.begin()->second;
+  if (B_list.size()) {
+    return &B_cache[B_list[0]];
   } else {
     return nullptr;
   }
 }
 
 const B* McGraphManager::get_mcB2() const {
-  if (B_map.size()) {
-    return &(++B_map.begin())->second;
+  if (B_list.size()) {
+    return &B_cache[B_list[1]];
   } else {
     return nullptr;
   }
 }
 
+// Finalizer of the splitmix64 generator. Used to spread the lund IDs and 
+// the sum of daughter signatures over all 64 bits. 
+static std::uint64_t MixBits(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// Lund ID of the antiparticle, or the lund ID itself if the 
+// particle is its own antiparticle. 
+int McGraphManager::ConjugateLund(const std::map<int, std::string> &names, int lund) {
+  return (names.find(-lund) != names.end()) ? -lund : lund;
+}
+
+// Signature of the decay chain of particle u down to depth generations. 
+// The daughters' signatures are summed so that their order does not matter. 
+DecayDictionary::Signature McGraphManager::ComputeSignature(
+    const Tree &t, const std::map<int, std::string> &names, 
+    int u, int depth, bool conjugate) {
+
+  int lund = conjugate ? ConjugateLund(names, t.lund(u)) : t.lund(u);
+  std::uint64_t sig = MixBits(static_cast<std::uint64_t>(static_cast<std::int64_t>(lund)));
+
+  if (depth > 0 && t.n_daughters(u) > 0) {
+    std::uint64_t dau_sum = 0;
+    for (int v = t.daughters_begin(u); v < t.daughters_end(u); ++v) 
+      dau_sum += MixBits(ComputeSignature(t, names, v, depth - 1, conjugate));
+    sig = MixBits(sig ^ (dau_sum + static_cast<std::uint64_t>(t.n_daughters(u))));
+  }
+
+  return sig;
+}
+
+// Human readable decay string of particle u down to depth generations. 
+// Daughters that are expanded further are wrapped in parentheses. 
+std::string McGraphManager::DecayString(
+    const Tree &t, const std::map<int, std::string> &names, 
+    int u, int depth, bool conjugate) {
+
+  int lund = conjugate ? ConjugateLund(names, t.lund(u)) : t.lund(u);
+  auto name_it = names.find(lund);
+  std::string name = (name_it != names.end()) ? 
+    name_it->second : std::to_string(lund);
+
+  if (depth <= 0 || t.n_daughters(u) == 0) return name;
+
+  std::vector<std::string> dau_strings;
+  for (int v = t.daughters_begin(u); v < t.daughters_end(u); ++v) {
+    if (depth > 1 && t.n_daughters(v) > 0) {
+      dau_strings.push_back("(" + DecayString(t, names, v, depth - 1, conjugate) + ")");
+    } else {
+      dau_strings.push_back(DecayString(t, names, v, depth - 1, conjugate));
+    }
+  }
+  std::sort(dau_strings.begin(), dau_strings.end());
+
+  std::string decay = name + " ->";
+  for (const auto &d : dau_strings) decay += " " + d;
+  return decay;
+}
+
+DecayDictionary::Signature McGraphManager::ChainSignature(
+    const Tree &t, int u, int depth, const AnalysisContext &context) {
+  return ComputeSignature(t, context.get_lund_to_name(), u, depth, t.lund(u) < 0);
+}
+
+std::string McGraphManager::ChainDecayString(
+    const Tree &t, int u, int depth, const AnalysisContext &context) {
+  return DecayString(t, context.get_lund_to_name(), u, depth, t.lund(u) < 0);
+}
+
+// Compute the signature of the B at MC index u and intern it. The decay
+// string is only built the first time a signature is seen. 
+DecayDictionary::Signature McGraphManager::InternSignature(int u) {
+  if (signature_depth <= 0) return 0;
+  DecayDictionary::Signature sig = ChainSignature(tree, u, signature_depth, *context);
+  if (!decay_dictionary.contains(sig)) 
+    decay_dictionary.insert(sig, ChainDecayString(tree, u, signature_depth, *context));
+  return sig;
+}
+
 // Print graphviz file. See BDtaunuGraphWriter.h.
 void McGraphManager::print(std::ostream &os) const {
 
+  Graph g;
+  build_graph(g);
+
   auto lund_pm = get(vertex_lund_id, g);
   auto mc_idx_pm = get(vertex_mc_index, g);
   BDtaunuGraphvizManager<Graph, decltype(lund_pm), decltype(mc_idx_pm)> gv_manager(
-      g, lund_pm, mc_idx_pm, BDtaunuMcReader::lund_to_name);
+      g, lund_pm, mc_idx_pm, context->get_lund_to_name());
 
   gv_manager.set_title("MC Graph");
   gv_manager.set_vertex_property({"color", "blue"});
@@ -2,11 +2,15 @@
 #define __MCGRAPHMANAGER_H_
 
 #include <iostream>
-#include <set>
 #include <map>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "GraphManager.h"
 #include "GraphDef.h"
+#include "AnalysisContext.h"
+#include "DecayDictionary.h"
 #include "McGraphVisitors.h"
 
 class BDtaunuMcReader;
@@ -26,9 +30,6 @@ class BDtaunuMcReader;
  *
  * # Implementation Details
  *
- * We use the [boost graph library (BGL)](http://www.boost.org/doc/libs/1_56_0/libs/graph/doc/ "BGL")
- * for graph operations.
- *
  * ### `BtaTupleMaker` Input format. 
  *
  * All MC truth information is stored in arrays of length equalling the number of 
@@ -63,21 +64,39 @@ class BDtaunuMcReader;
  *                        cout << mcLund[dauIdx[i] + j] << endl;
  *                      }
  *
+ * ### Graph construction
+ * The input is already a flat tree, so the graph is not copied. Instead, 
+ * `McGraph::Tree` (see GraphDef.h) points directly at the buffer arrays 
+ * and serves as the adjacency structure. 
  *
- * ### BGL graph operations.
+ * ### Graph analysis
+ * The tree is traversed in post-order with an explicit stack, and 
+ * McGraphDfsVisitor is called on each particle once all of its daughters 
+ * have been visited. The traversal state and the analysis results are 
+ * kept in arrays indexed by MC index that are sized once, so no 
+ * allocation happens per event. 
  *
- * See the [BGL documentation](http://www.boost.org/doc/libs/1_56_0/libs/graph/doc/table_of_contents.html)
- * for its API. 
- * 
- * #### Graph construction
- * This is more straight forward than the reco particle case. See source for details.
+ * ### Decay chain signatures
+ * The decay chain of each truth \f$B\f$ is summarized by a 64 bit 
+ * signature that is stored in McGraph::B. The signature of a particle 
+ * combines its lund ID with the signatures of its daughters, down to 
+ * `get_signature_depth()` generations below the \f$B\f$. The daughter 
+ * signatures are combined with a commutative sum, so the signature does 
+ * not depend on the order the daughters are saved in. Chains of 
+ * \f$\bar{B}\f$'s are charge conjugated first, so that a decay and its 
+ * charge conjugate share a signature. 
+ *
+ * Each new signature is interned in a DecayDictionary together with a 
+ * human readable decay string; e.g. with depth 2, 
  *
- * The resulting graph is cached for further analysis. 
+ *     B0 -> (D*- -> anti-D0 pi-) nu_tau tau+
  *
- * #### Graph analysis
- * We use BGL's generic algorithms and visitor classes to analyze the graph. 
+ * where the daughters at each level are sorted by name. 
  *
- * The methodology is very similar to those for the reco particle graph. 
+ * ### BGL graph
+ * A [boost graph library (BGL)](http://www.boost.org/doc/libs/1_56_0/libs/graph/doc/ "BGL")
+ * graph is only built on request; e.g. when printing graphviz output or
+ * when truth matching needs an edge contractable copy. See `build_graph()`.
  *
  */
 class McGraphManager : public GraphManager {
@@ -91,27 +110,57 @@ class McGraphManager : public GraphManager {
     
     //! Constructor
     /*! Construction of an object should be associated with a 
-     * supervising `BDtaunuReader` object. */
-    McGraphManager(BDtaunuMcReader*);
+     * supervising `BDtaunuMcReader` object and the context it uses. */
+    McGraphManager(BDtaunuMcReader*, const AnalysisContext&);
     McGraphManager();
     McGraphManager(const McGraphManager&) = default;
     McGraphManager &operator=(const McGraphManager&) = default;
     ~McGraphManager() {};
 
-    //! Construct and cache BGL graph. 
+    //! Point the cached MC tree at the reader's buffer. 
     void construct_graph();
 
-    //! Analyze cached BGL graph. 
+    //! Analyze cached MC tree. 
     void analyze_graph();
 
-    //! Print graphviz of data of BGL graph to ostream. 
+    //! Print graphviz of data of the MC tree to ostream. 
     void print(std::ostream &os) const;
 
     //! Clear cache. 
     void clear();
 
-    //! Get the mc graph
-    const McGraph::Graph& get_mc_graph() const { return g; }
+    //! Get the mc tree. 
+    const McGraph::Tree& get_mc_tree() const { return tree; }
+
+    //! Build a BGL graph of the cached MC tree into `g`. 
+    /*! Vertices are added in the order they are encountered while scanning
+     * the MC indices, and each carries its MC index and lund ID. */
+    void build_graph(McGraph::Graph &g) const;
+
+    //! Set the number of generations below the \f$B\f$ that its signature covers. 
+    /*! A depth of 0 disables the signatures. The default is 2. */
+    void set_signature_depth(int depth) { signature_depth = depth; }
+    int get_signature_depth() const { return signature_depth; }
+
+    //! Dictionary of all decay chain signatures seen so far. 
+    const DecayDictionary& get_decay_dictionary() const { return decay_dictionary; }
+
+    //! Intern a signature whose decay string is already known. 
+    /*! Used for signatures served from a ResultCache, which are not 
+     * computed from the tree. */
+    void insert_decay(DecayDictionary::Signature s, const std::string &decay) { 
+      decay_dictionary.insert(s, decay); 
+    }
+
+    //! Signature of the decay chain of particle `u` of `t`, `depth` generations down. 
+    /*! Chains of antiparticles are charge conjugated first. This is the 
+     * signature stored for each truth \f$B\f$. */
+    static DecayDictionary::Signature ChainSignature(
+        const McGraph::Tree &t, int u, int depth, const AnalysisContext &context);
+
+    //! Decay string of the same chain, as interned in the dictionary. 
+    static std::string ChainDecayString(
+        const McGraph::Tree &t, int u, int depth, const AnalysisContext &context);
 
     //! Returns pointer to the MC truth \f$\Upsilon(4S)\f$ if it exists, nullptr otherwise.
     const McGraph::Y* get_mcY() const;
@@ -132,19 +181,42 @@ class McGraphManager : public GraphManager {
     // Supervising event reader class. 
     BDtaunuMcReader *reader;
 
-    // Cached BGL graph.
-    McGraph::Graph g;
+    // Shared tables. Owned by the reader. 
+    const AnalysisContext *context;
 
-    // Graph construction
-    std::map<int, McGraph::Vertex> mc_vertex_map;
+    // Cached MC tree. 
+    McGraph::Tree tree;
     void ClearGraph();
 
-    // Graph analysis
-    std::map<McGraph::Vertex, McGraph::Y> Y_map;
-    std::map<McGraph::Vertex, McGraph::B> B_map;
-    std::map<McGraph::Vertex, McGraph::Tau> Tau_map;
+    // Graph traversal. Each is indexed by MC index, except for 
+    // dfs_stack and dfs_next, which are indexed by stack depth. 
+    std::vector<char> dfs_color;
+    std::vector<int> dfs_stack;
+    std::vector<int> dfs_next;
+    void ResizeCache(int n);
+
+    // Graph analysis. The caches are indexed by MC index and the 
+    // lists record which entries were filled this event. 
+    std::vector<McGraph::Y> Y_cache;
+    std::vector<McGraph::B> B_cache;
+    std::vector<McGraph::Tau> Tau_cache;
+    std::vector<int> Y_list;
+    std::vector<int> B_list;
+    std::vector<int> daulund_list;
     void ClearAnalysis();
 
+    // Decay chain signatures. 
+    int signature_depth;
+    DecayDictionary decay_dictionary;
+    DecayDictionary::Signature InternSignature(int u);
+    static DecayDictionary::Signature ComputeSignature(
+        const McGraph::Tree &t, const std::map<int, std::string> &names,
+        int u, int depth, bool conjugate);
+    static std::string DecayString(
+        const McGraph::Tree &t, const std::map<int, std::string> &names,
+        int u, int depth, bool conjugate);
+    static int ConjugateLund(const std::map<int, std::string> &names, int lund);
+
 };
 
 //! Decides if a particle is one of the final states.
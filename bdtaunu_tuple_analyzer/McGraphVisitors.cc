@@ -7,31 +7,29 @@
 #include "McGraphVisitors.h"
 #include "McGraphManager.h"
 
-using namespace boost;
 using namespace bdtaunu;
 using namespace McGraph;
 
 McGraphDfsVisitor::McGraphDfsVisitor(McGraphManager *_manager) 
-  : manager(_manager) {
-  lund_map = get(vertex_lund_id, manager->g);
+  : manager(_manager), 
+    mcB_catalogue(&manager->context->get_mcB_catalogue()),
+    daulund_list(&manager->daulund_list) {
 }
 
-const McBTypeCatalogue McGraphDfsVisitor::mcB_catalogue = McBTypeCatalogue();
-
 // Determine whether to analyze a MC particle 
-// when its vertex is colored black. 
-void McGraphDfsVisitor::finish_vertex(Vertex u, const Graph &g) {
-  int lund = std::abs(get(lund_map, u));
+// once all of its daughters have been visited. 
+void McGraphDfsVisitor::finish_vertex(int u, const Tree &t) {
+  int lund = std::abs(t.lund(u));
   switch (lund) {
     case UpsilonLund:
-      AnalyzeY(u, g);
+      AnalyzeY(u, t);
       break;
     case B0Lund:
     case BcLund:
-      AnalyzeB(u, g);
+      AnalyzeB(u, t);
       break;
     case tauLund:
-      AnalyzeTau(u, g);
+      AnalyzeTau(u, t);
       break;
     default:
       return;
@@ -42,20 +40,19 @@ void McGraphDfsVisitor::finish_vertex(Vertex u, const Graph &g) {
 
 // Analyze Y(4S). The quantities computed are:
 // 1. Pointers to the daughter B mesons.
-void McGraphDfsVisitor::AnalyzeY(const Vertex &u, const Graph &g) {
+void McGraphDfsVisitor::AnalyzeY(int u, const Tree &t) {
 
   Y mcY;
 
-  AdjacencyIterator ai, ai_end;
-  for (tie(ai, ai_end) = adjacent_vertices(u, g); ai != ai_end; ++ai) {
+  for (int v = t.daughters_begin(u); v < t.daughters_end(u); ++v) {
 
-    int lund = abs(get(lund_map, *ai));
+    int lund = abs(t.lund(v));
     switch (lund) {
       case B0Lund:
       case BcLund:
         (mcY.B1 == nullptr) ? 
-          (mcY.B1 = &(manager->B_map)[*ai]) : 
-          (mcY.B2 = &(manager->B_map)[*ai]);
+          (mcY.B1 = &(manager->B_cache)[v]) : 
+          (mcY.B2 = &(manager->B_cache)[v]);
         break;
       default:
         mcY.isBBbar = false;
@@ -63,48 +60,50 @@ void McGraphDfsVisitor::AnalyzeY(const Vertex &u, const Graph &g) {
     }
   }
 
-  (manager->Y_map).insert(std::make_pair(u, mcY));
+  (manager->Y_cache)[u] = mcY;
+  (manager->Y_list).push_back(u);
 }
 
 // Analyze B meson. The quantities computed are:
 // 1. B flavor. 
 // 2. Pointer to daughter tau. 
 // 3. MC type. See GraphDef.h.
-void McGraphDfsVisitor::AnalyzeB(const Vertex &u, const Graph &g) {
+// 4. Decay chain signature. See McGraphManager.h.
+void McGraphDfsVisitor::AnalyzeB(int u, const Tree &t) {
 
   B mcB;
 
-  if (abs(get(lund_map, u)) == B0Lund) {
+  if (abs(t.lund(u)) == B0Lund) {
     mcB.flavor = BFlavor::B0;
   } else {
     mcB.flavor = BFlavor::Bc;
   }
 
-  std::vector<int> daulund_list;
-  AdjacencyIterator ai, ai_end;
-  for (tie(ai, ai_end) = adjacent_vertices(u, g); ai != ai_end; ++ai) {
-    int lund = get(lund_map, *ai);
+  daulund_list->clear();
+  for (int v = t.daughters_begin(u); v < t.daughters_end(u); ++v) {
+    int lund = t.lund(v);
     switch (abs(lund)) {
       case tauLund:
-        mcB.tau = &(manager->Tau_map)[*ai];
+        mcB.tau = &(manager->Tau_cache)[v];
       default:
-        daulund_list.push_back(lund);
+        daulund_list->push_back(lund);
     }
   }
-  mcB.mc_type = mcB_catalogue.search_catalogue(daulund_list);
+  mcB.mc_type = mcB_catalogue->search_catalogue(*daulund_list);
+  mcB.signature = manager->InternSignature(u);
 
-  (manager->B_map).insert(std::make_pair(u, mcB));
+  (manager->B_cache)[u] = mcB;
+  (manager->B_list).push_back(u);
 }
 
 // Analyze tau. The quantities computed are:
 // 1. MC type. See GraphDef.h.
-void McGraphDfsVisitor::AnalyzeTau(const Vertex &u, const Graph &g) {
+void McGraphDfsVisitor::AnalyzeTau(int u, const Tree &t) {
 
   Tau mcTau;
 
-  AdjacencyIterator ai, ai_end;
-  for (tie(ai, ai_end) = adjacent_vertices(u, g); ai != ai_end; ++ai) {
-    int lund = abs(get(lund_map, *ai));
+  for (int v = t.daughters_begin(u); v < t.daughters_end(u); ++v) {
+    int lund = abs(t.lund(v));
     if (lund == eLund) {
       mcTau.mc_type = TauMcType::tau_e;
       break;
@@ -116,5 +115,5 @@ void McGraphDfsVisitor::AnalyzeTau(const Vertex &u, const Graph &g) {
     }
   }
 
-  (manager->Tau_map).insert(std::make_pair(u, mcTau));
+  (manager->Tau_cache)[u] = mcTau;
 }
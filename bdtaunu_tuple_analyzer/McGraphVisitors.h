@@ -3,15 +3,15 @@
 
 /** @file McGraphVisitors.h
  *
- * @brief BGL visitors used to analyze Monte Carlo truth particle graph.
+ * @brief Visitors used to analyze Monte Carlo truth particle graph.
  * 
  * @detail 
  * This file defines the following visitors:
  * * McGraphDfsVisitor: 
- * Subclass of [dfs_visitor](http://www.boost.org/doc/libs/1_55_0/libs/graph/doc/dfs_visitor.html).
+ * Called by McGraphManager's post-order traversal of the MC tree.
  */
 
-#include <boost/graph/depth_first_search.hpp>
+#include <vector>
 
 #include "BDtaunuDef.h"
 #include "GraphDef.h"
@@ -35,34 +35,35 @@ class McGraphManager;
  * is colored black. 
  *
  * # Implementation
- * This class is a subclass of
- * [dfs_visitor](http://www.boost.org/doc/libs/1_55_0/libs/graph/doc/dfs_visitor.html), 
- * and implements the `finish_vertex()` method. 
+ * McGraphManager traverses the flat MC tree (See McGraph::Tree in GraphDef.h) 
+ * in post-order and calls `finish_vertex()` with the MC index of each 
+ * particle once all of its daughters have been visited. 
  *
- * Every time a vertex is colored black, the visitor checks whether it is 
+ * Every time a vertex is finished, the visitor checks whether it is 
  * a particle type that we are interested in analyzing. If so, it calls
  * the corresponding `AnalyzeX()` method and puts the computed result in 
  * the cache that its supervising class (See McGraphManager.h) manages.
  */
-class McGraphDfsVisitor : public boost::default_dfs_visitor {
+class McGraphDfsVisitor {
 
   public:
     McGraphDfsVisitor() = default;
     McGraphDfsVisitor(McGraphManager*);
     ~McGraphDfsVisitor() {};
 
-    void finish_vertex(McGraph::Vertex u, const McGraph::Graph &g);
-
-  private:
-    static const bdtaunu::McBTypeCatalogue mcB_catalogue;
+    void finish_vertex(int u, const McGraph::Tree &t);
 
   private:
     McGraphManager *manager = nullptr;
-    McGraph::LundIdPropertyMap lund_map;
+    const bdtaunu::McBTypeCatalogue *mcB_catalogue = nullptr;
+
+    // Scratch list of B daughters; owned by the manager, which sizes it
+    // once, so that no event allocates.
+    std::vector<int> *daulund_list = nullptr;
 
-    void AnalyzeY(const McGraph::Vertex &u, const McGraph::Graph &g);
-    void AnalyzeB(const McGraph::Vertex &u, const McGraph::Graph &g);
-    void AnalyzeTau(const McGraph::Vertex &u, const McGraph::Graph &g);
+    void AnalyzeY(int u, const McGraph::Tree &t);
+    void AnalyzeB(int u, const McGraph::Tree &t);
+    void AnalyzeTau(int u, const McGraph::Tree &t);
 };
 
 #endif
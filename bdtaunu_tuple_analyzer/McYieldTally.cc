@@ -0,0 +1,369 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+
+#include <unistd.h>
+
+#include <TROOT.h>
+
+#include "BDtaunuDef.h"
+#include "RootReader.h"
+#include "BDtaunuMcReader.h"
+#include "McYieldTally.h"
+
+using namespace bdtaunu;
+
+namespace {
+
+const char checkpoint_magic[] = "bdtaunu_mc_yield_checkpoint";
+const int checkpoint_version = 1;
+
+// 64 bit FNV-1a; stable across compilers and runs, unlike std::hash.
+unsigned long long Fnv1a(const std::string &s) {
+  unsigned long long h = 14695981039346656037ULL;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+}
+
+// McYieldTable
+// ------------
+
+// BMcType and TauMcType range from null = -1 up to Had = 8 and 
+// tau_h = 4 respectively. Status ranges from 0 to 3. 
+const int McYieldTable::n_continuum = 2;
+const int McYieldTable::n_bmctype = 10;
+const int McYieldTable::n_taumctype = 6;
+const int McYieldTable::n_status = 4;
+
+McYieldTable::McYieldTable() : 
+  counts(n_continuum * n_bmctype * n_bmctype * n_taumctype * n_taumctype, 0), 
+  status_counts(n_status, 0) {
+}
+
+// Row major index into the flat table. The enums are shifted by one 
+// so that null maps to zero. 
+int McYieldTable::Index(
+    bool continuum, 
+    McBTypeCatalogue::BMcType b1_mctype, 
+    McBTypeCatalogue::BMcType b2_mctype, 
+    TauMcType b1_tau_mctype, 
+    TauMcType b2_tau_mctype) const {
+
+  int b1 = static_cast<int>(b1_mctype) + 1;
+  int b2 = static_cast<int>(b2_mctype) + 1;
+  int t1 = static_cast<int>(b1_tau_mctype) + 1;
+  int t2 = static_cast<int>(b2_tau_mctype) + 1;
+  assert(b1 >= 0 && b1 < n_bmctype && b2 >= 0 && b2 < n_bmctype);
+  assert(t1 >= 0 && t1 < n_taumctype && t2 >= 0 && t2 < n_taumctype);
+
+  int idx = continuum ? 1 : 0;
+  idx = idx * n_bmctype + b1;
+  idx = idx * n_bmctype + b2;
+  idx = idx * n_taumctype + t1;
+  idx = idx * n_taumctype + t2;
+  return idx;
+}
+
+void McYieldTable::add(
+    RootReader::Status status, 
+    bool continuum, 
+    McBTypeCatalogue::BMcType b1_mctype, 
+    McBTypeCatalogue::BMcType b2_mctype, 
+    TauMcType b1_tau_mctype, 
+    TauMcType b2_tau_mctype) {
+
+  ++status_counts[static_cast<int>(status)];
+  if (status == RootReader::Status::kReadSucceeded) {
+    ++counts[Index(continuum, b1_mctype, b2_mctype, b1_tau_mctype, b2_tau_mctype)];
+  }
+}
+
+void McYieldTable::add(RootReader::Status status, const BDtaunuMcReader &reader) {
+  add(status, reader.is_continuum(), 
+      reader.get_b1_mctype(), reader.get_b2_mctype(), 
+      reader.get_b1_tau_mctype(), reader.get_b2_tau_mctype());
+}
+
+void McYieldTable::merge(const McYieldTable &other) {
+  for (std::vector<unsigned long long>::size_type i = 0; i < counts.size(); ++i) 
+    counts[i] += other.counts[i];
+  for (std::vector<unsigned long long>::size_type i = 0; i < status_counts.size(); ++i) 
+    status_counts[i] += other.status_counts[i];
+}
+
+unsigned long long McYieldTable::get(
+    bool continuum, 
+    McBTypeCatalogue::BMcType b1_mctype, 
+    McBTypeCatalogue::BMcType b2_mctype, 
+    TauMcType b1_tau_mctype, 
+    TauMcType b2_tau_mctype) const {
+  return counts[Index(continuum, b1_mctype, b2_mctype, b1_tau_mctype, b2_tau_mctype)];
+}
+
+unsigned long long McYieldTable::get_status_count(RootReader::Status status) const {
+  return status_counts[static_cast<int>(status)];
+}
+
+unsigned long long McYieldTable::total() const {
+  return get_status_count(RootReader::Status::kReadSucceeded);
+}
+
+void McYieldTable::clear() {
+  std::fill(counts.begin(), counts.end(), 0);
+  std::fill(status_counts.begin(), status_counts.end(), 0);
+}
+
+// Only the non-zero counts, as `index count` pairs. 
+void McYieldTable::save(std::ostream &os) const {
+  for (const auto *v : { &counts, &status_counts }) {
+    os << " " << (v->size() - std::count(v->begin(), v->end(), 0ULL));
+    for (std::vector<unsigned long long>::size_type i = 0; i < v->size(); ++i) {
+      if ((*v)[i]) os << " " << i << " " << (*v)[i];
+    }
+  }
+  os << "\n";
+}
+
+bool McYieldTable::restore(std::istream &is) {
+  clear();
+  for (auto *v : { &counts, &status_counts }) {
+    std::vector<unsigned long long>::size_type n, i;
+    if (!(is >> n) || n > v->size()) return false;
+    while (n--) {
+      if (!(is >> i) || i >= v->size() || !(is >> (*v)[i])) return false;
+    }
+  }
+  return true;
+}
+
+void McYieldTable::write(std::ostream &os) const {
+
+  os << "# kReadSucceeded " << get_status_count(RootReader::Status::kReadSucceeded) << "\n";
+  os << "# kMaxRecoCandExceeded " << get_status_count(RootReader::Status::kMaxRecoCandExceeded) << "\n";
+  os << "# kMaxMcParticlesExceeded " << get_status_count(RootReader::Status::kMaxMcParticlesExceeded) << "\n";
+  os << "# continuum b1_mctype b2_mctype b1_tau_mctype b2_tau_mctype count\n";
+
+  // Unravel the flat index in the same order as Index(). 
+  for (std::vector<unsigned long long>::size_type i = 0; i < counts.size(); ++i) {
+    if (counts[i] == 0) continue;
+    int idx = i;
+    int t2 = idx % n_taumctype - 1; idx /= n_taumctype;
+    int t1 = idx % n_taumctype - 1; idx /= n_taumctype;
+    int b2 = idx % n_bmctype - 1; idx /= n_bmctype;
+    int b1 = idx % n_bmctype - 1; idx /= n_bmctype;
+    int continuum = idx;
+    os << continuum << " " << b1 << " " << b2 << " " 
+       << t1 << " " << t2 << " " << counts[i] << "\n";
+  }
+}
+
+
+// McYieldTally
+// ------------
+
+McYieldTally::McYieldTally(
+    const std::vector<std::string> &_root_fnames, 
+    const char *_root_trname) : 
+  root_fnames(_root_fnames), root_trname(_root_trname), 
+  nthreads(0), mode(BDtaunuMcReader::Mode::kMcOnly), 
+  checkpoint_interval(100000), stop_requested(false), complete(false) {
+}
+
+void McYieldTally::set_checkpoint(const std::string &fname, Long64_t interval) {
+  checkpoint_fname = fname;
+  checkpoint_interval = std::max(1LL, interval);
+}
+
+// Count the events of file f, starting where the progress left off. 
+// Returns false if the worker is to stop. 
+bool McYieldTally::TallyFile(int f, Progress &progress) const {
+
+  Long64_t first = 0;
+  McYieldTable t;
+  {
+    std::lock_guard<std::mutex> lock(progress.m);
+    auto it = progress.partial.find(f);
+    if (it != progress.partial.end()) {
+      first = it->second.first;
+      t = it->second.second;
+    }
+  }
+
+  bool checkpoints = !checkpoint_fname.empty();
+
+  BDtaunuMcReader reader(root_fnames[f].c_str(), root_trname.c_str(), mode);
+  if (first > 0) reader.set_entry_range(first, std::numeric_limits<Long64_t>::max());
+
+  Long64_t n = 0;
+  RootReader::Status status;
+  while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+    t.add(status, reader);
+    if (!checkpoints || ++n % checkpoint_interval != 0) continue;
+
+    std::lock_guard<std::mutex> lock(progress.m);
+    progress.partial[f] = std::make_pair(reader.get_current_entry() + 1, t);
+    WriteCheckpoint(progress);
+    if (stop_requested) return false;
+  }
+
+  std::lock_guard<std::mutex> lock(progress.m);
+  progress.done.merge(t);
+  progress.finished[f] = 1;
+  progress.partial.erase(f);
+  if (checkpoints) WriteCheckpoint(progress);
+  return !(checkpoints && stop_requested);
+}
+
+// Everything that determines the table of a run. 
+std::string McYieldTally::Configuration() const {
+  std::string config = root_trname + "\n" + std::to_string(static_cast<int>(mode)) + "\n";
+  for (const auto &fname : root_fnames) config += fname + "\n";
+  std::ostringstream os;
+  os << root_fnames.size() << " " << std::hex << Fnv1a(config);
+  return os.str();
+}
+
+// Checkpoint format, one item per line: 
+//
+//     bdtaunu_mc_yield_checkpoint <version>
+//     config <number of files> <hash of the configuration>
+//     finished <one 0 or 1 per file>
+//     done <McYieldTable::save() of the finished files>
+//     partial <file> <next entry> <McYieldTable::save()>
+//     ...
+//     end
+//
+// Returns false if there is no checkpoint file. 
+bool McYieldTally::ReadCheckpoint(Progress &progress) const {
+
+  std::ifstream is(checkpoint_fname);
+  if (!is) return false;
+
+  std::string word, config, finished;
+  int version = 0;
+  bool ok = (is >> word) && word == checkpoint_magic
+         && (is >> version) && version == checkpoint_version
+         && (is >> word) && word == "config" && std::getline(is >> std::ws, config)
+         && (is >> word) && word == "finished" && (is >> finished)
+         && finished.size() == root_fnames.size()
+         && (is >> word) && word == "done" && progress.done.restore(is);
+
+  if (ok && config != Configuration()) {
+    std::cerr << "McYieldTally: checkpoint " << checkpoint_fname;
+    std::cerr << " is of a run with other files, tree, or mode." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  while (ok && (is >> word) && word == "partial") {
+    int f;
+    Long64_t next;
+    McYieldTable t;
+    ok = (is >> f >> next) && f >= 0 && f < static_cast<int>(root_fnames.size())
+      && next >= 0 && t.restore(is);
+    if (ok) progress.partial[f] = std::make_pair(next, t);
+  }
+
+  if (!ok || word != "end") {
+    std::cerr << "McYieldTally: cannot read checkpoint " << checkpoint_fname << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t f = 0; f < finished.size(); ++f) progress.finished[f] = (finished[f] == '1');
+  return true;
+}
+
+// Write to a temporary file, sync it, and rename it over the last 
+// checkpoint. A checkpoint that cannot be written is reported, and the 
+// run carries on. 
+void McYieldTally::WriteCheckpoint(const Progress &progress) const {
+
+  std::ostringstream os;
+  os << checkpoint_magic << " " << checkpoint_version << "\n";
+  os << "config " << Configuration() << "\n";
+  os << "finished ";
+  for (char c : progress.finished) os << (c ? '1' : '0');
+  os << "\n";
+  os << "done";
+  progress.done.save(os);
+  for (const auto &p : progress.partial) {
+    os << "partial " << p.first << " " << p.second.first;
+    p.second.second.save(os);
+  }
+  os << "end\n";
+
+  const std::string data = os.str();
+  const std::string tmp = checkpoint_fname + ".tmp";
+  FILE *fp = std::fopen(tmp.c_str(), "w");
+  bool ok = fp && std::fwrite(data.data(), 1, data.size(), fp) == data.size();
+  if (fp) ok = (std::fflush(fp) == 0) && (fsync(fileno(fp)) == 0) && ok;
+  if (fp) ok = (std::fclose(fp) == 0) && ok;
+  if (ok) ok = (std::rename(tmp.c_str(), checkpoint_fname.c_str()) == 0);
+
+  if (!ok) {
+    std::cerr << "McYieldTally: cannot write checkpoint " << checkpoint_fname << std::endl;
+    std::remove(tmp.c_str());
+  }
+}
+
+const McYieldTable &McYieldTally::run() {
+
+  table.clear();
+
+  Progress progress;
+  progress.finished.assign(root_fnames.size(), 0);
+  if (!checkpoint_fname.empty()) ReadCheckpoint(progress);
+
+  int n = nthreads;
+  if (n <= 0) n = std::thread::hardware_concurrency();
+  if (n <= 0) n = 1;
+  n = std::min<int>(n, root_fnames.size());
+
+  // Each worker takes the next unclaimed file. Only the worker that 
+  // claimed a file changes its entry of progress.finished. 
+  std::atomic<int> next_file(0);
+  auto work = [this, &next_file, &progress] () {
+    int f;
+    while ((f = next_file++) < static_cast<int>(root_fnames.size())) {
+      if (progress.finished[f]) continue;
+      if (!TallyFile(f, progress)) break;
+    }
+  };
+
+  if (n <= 1) {
+    work();
+  } else {
+
+    // ROOT must be told that it will be used from several threads 
+    // before any of them opens a file. 
+    ROOT::EnableThreadSafety();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < n; ++i) workers.push_back(std::thread(work));
+    for (auto &w : workers) w.join();
+  }
+
+  stop_requested = false;
+  complete = std::all_of(progress.finished.begin(), progress.finished.end(),
+                         [] (char c) { return c != 0; });
+
+  table.merge(progress.done);
+  for (const auto &p : progress.partial) table.merge(p.second.second);
+
+  return table;
+}
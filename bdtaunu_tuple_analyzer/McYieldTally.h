@@ -0,0 +1,218 @@
+#ifndef __MCYIELDTALLY_H__
+#define __MCYIELDTALLY_H__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+
+#include "BDtaunuDef.h"
+#include "RootReader.h"
+#include "BDtaunuMcReader.h"
+
+/** @brief Dense count table of generated events keyed by their MC labels.
+ *
+ * @detail
+ * Each generated event is labeled by whether it is continuum, the MC type
+ * of both truth \f$B\f$'s, and the MC type of their \f$\tau\f$'s (See 
+ * BDtaunuMcReader). This class holds one counter for every combination of 
+ * labels in a flat array, so incrementing a count is a single index 
+ * computation. Tables filled independently can be merged with `merge()`.
+ *
+ * The table also counts the reader status of every event it was shown, 
+ * so that rejected events are accounted for in the normalization.
+ */
+class McYieldTable {
+
+  public:
+
+    McYieldTable();
+    McYieldTable(const McYieldTable&) = default;
+    McYieldTable &operator=(const McYieldTable&) = default;
+    ~McYieldTable() {};
+
+    //! Count one event with the given reader status and MC labels. 
+    /*! The MC labels are only counted when `status` is kReadSucceeded. */
+    void add(RootReader::Status status, 
+             bool continuum, 
+             bdtaunu::McBTypeCatalogue::BMcType b1_mctype, 
+             bdtaunu::McBTypeCatalogue::BMcType b2_mctype, 
+             bdtaunu::TauMcType b1_tau_mctype, 
+             bdtaunu::TauMcType b2_tau_mctype);
+
+    //! Count the current event of `reader` given the status it returned. 
+    void add(RootReader::Status status, const BDtaunuMcReader &reader);
+
+    //! Add the counts of another table to this one. 
+    void merge(const McYieldTable &other);
+
+    //! Number of events with the given MC labels. 
+    unsigned long long get(bool continuum, 
+                           bdtaunu::McBTypeCatalogue::BMcType b1_mctype, 
+                           bdtaunu::McBTypeCatalogue::BMcType b2_mctype, 
+                           bdtaunu::TauMcType b1_tau_mctype, 
+                           bdtaunu::TauMcType b2_tau_mctype) const;
+
+    //! Number of events the reader returned `status` for. 
+    unsigned long long get_status_count(RootReader::Status status) const;
+
+    //! Total number of successfully read events. 
+    unsigned long long total() const;
+
+    //! Reset all counts to zero. 
+    void clear();
+
+    //! Write all counts on one line, to be read back by `restore()`. 
+    void save(std::ostream &os) const;
+
+    //! Replace the counts with ones written by `save()`. 
+    /*! Returns false if the input is malformed. */
+    bool restore(std::istream &is);
+
+    //! Write the non-zero entries of the table to ostream. 
+    /*! The output has one line per non-zero entry with the columns
+     * `continuum b1_mctype b2_mctype b1_tau_mctype b2_tau_mctype count`, 
+     * where the MC types are the integer values of their enums. Lines 
+     * starting with `#` are comments and summarize the reader status counts. */
+    void write(std::ostream &os) const;
+
+  private:
+
+    // Number of values each label can take, including null. 
+    static const int n_continuum;
+    static const int n_bmctype;
+    static const int n_taumctype;
+    static const int n_status;
+
+    std::vector<unsigned long long> counts;
+    std::vector<unsigned long long> status_counts;
+
+    int Index(bool continuum, 
+              bdtaunu::McBTypeCatalogue::BMcType b1_mctype, 
+              bdtaunu::McBTypeCatalogue::BMcType b2_mctype, 
+              bdtaunu::TauMcType b1_tau_mctype, 
+              bdtaunu::TauMcType b2_tau_mctype) const;
+};
+
+
+/** @brief Tallies generated events by their MC labels over many files.
+ *
+ * @detail
+ * This class streams a list of BtaTupleMaker MC ntuples through 
+ * BDtaunuMcReader and accumulates the MC labels of every event into a 
+ * McYieldTable. 
+ *
+ * # Parallelism
+ * Files are the unit of work. Each worker thread repeatedly takes the 
+ * next unprocessed file, reads it with its own reader, and counts into a 
+ * table of that file. The table is merged into the total once the file 
+ * is finished, so the threads only synchronize between files and at 
+ * checkpoints. 
+ *
+ * By default the readers run in BDtaunuMcReader::Mode::kMcOnly, which
+ * reads only the MC truth branches. 
+ *
+ * All readers share `AnalysisContext::Default()`, so the particle data 
+ * table and catalogues are built once no matter how many files or 
+ * threads are used. 
+ *
+ * # Checkpoints
+ * With `set_checkpoint()`, the progress of a run is saved to a file 
+ * every so many entries of each file and whenever a file is finished: 
+ * the counts of the finished files, and the next entry and counts so 
+ * far of the ones being read. The file is written to a temporary name, 
+ * synced, and renamed into place, so it is always either the previous 
+ * or the next checkpoint. 
+ *
+ * A run with a checkpoint file that exists carries on from it, and the 
+ * table it returns is the same as that of an uninterrupted run. The 
+ * checkpoint records the file list, tree name, and mode; resuming with 
+ * a different configuration is an error. The number of threads may 
+ * differ. A finished run leaves its checkpoint in place, so running it 
+ * again returns the table at once. 
+ *
+ * `request_stop()` makes every worker stop after the next checkpoint it 
+ * writes, e.g. on the signal a batch system sends before it preempts a 
+ * job. 
+ *
+ * Usage Example
+ * -------------
+ *
+ *     McYieldTally tally({"sp1235r1.root", "sp1235r2.root"});
+ *     tally.set_nthreads(8);
+ *     const McYieldTable &table = tally.run();
+ *     table.write(std::cout);
+ */
+class McYieldTally {
+
+  public:
+
+    McYieldTally() = delete;
+    McYieldTally(const std::vector<std::string> &root_fnames, 
+                 const char *root_trname = "ntp1");
+    McYieldTally(const McYieldTally&) = delete;
+    McYieldTally &operator=(const McYieldTally&) = delete;
+    ~McYieldTally() {};
+
+    //! Number of worker threads. 0 means one per hardware thread. 
+    void set_nthreads(int n) { nthreads = n; }
+    int get_nthreads() const { return nthreads; }
+
+    //! Reader mode used for each file. Defaults to kMcOnly. 
+    void set_mode(BDtaunuMcReader::Mode m) { mode = m; }
+    BDtaunuMcReader::Mode get_mode() const { return mode; }
+
+    //! Save progress to `fname` every `interval` entries of each file. 
+    /*! An empty file name, the default, turns checkpoints off. */
+    void set_checkpoint(const std::string &fname, Long64_t interval = 100000);
+    const std::string &get_checkpoint() const { return checkpoint_fname; }
+
+    //! Make `run()` return after every worker writes its next checkpoint. 
+    /*! Only has an effect when checkpoints are on. Safe to call from a 
+     * signal handler or another thread. */
+    void request_stop() { stop_requested = true; }
+
+    //! Process all files and return the merged table. 
+    /*! If stopped early, the table holds the counts so far; see 
+     * `is_complete()`. */
+    const McYieldTable &run();
+
+    //! Whether the last call to `run()` processed every file. 
+    bool is_complete() const { return complete; }
+
+    //! Table from the last call to `run()`. 
+    const McYieldTable &get_table() const { return table; }
+
+  private:
+
+    // State of a run, as saved in a checkpoint. 
+    struct Progress {
+      std::vector<char> finished;
+      McYieldTable done;  // counts of the finished files
+
+      // Next entry and counts so far of the files being read. 
+      std::map<int, std::pair<Long64_t, McYieldTable>> partial;
+
+      std::mutex m;
+    };
+
+    std::vector<std::string> root_fnames;
+    std::string root_trname;
+    int nthreads;
+    BDtaunuMcReader::Mode mode;
+    McYieldTable table;
+
+    std::string checkpoint_fname;
+    Long64_t checkpoint_interval;
+    std::atomic<bool> stop_requested;
+    bool complete;
+
+    bool TallyFile(int f, Progress &progress) const;
+    std::string Configuration() const;
+    bool ReadCheckpoint(Progress &progress) const;
+    void WriteCheckpoint(const Progress &progress) const;
+};
+
+#endif
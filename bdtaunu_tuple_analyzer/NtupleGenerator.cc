@@ -0,0 +1,827 @@
+#include <TFile.h>
+#include <TTree.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+
+#include "BDtaunuDef.h"
+#include "NtupleGenerator.h"
+
+using namespace bdtaunu;
+
+const int NtupleGenerator::max_nY = 800;
+
+namespace {
+
+// Candidate limits of each block; see BDtaunuReader.cc. Blocks other
+// than Y are kept strictly below them.
+const int block_limit[] = { 800, 400, 200, 100, 100, 100, 100 };
+
+// MC particle limit; see BDtaunuMcReader.cc.
+const int max_mc_length = 100;
+
+// Number of daughter branches BtaTupleMaker writes for each block.
+const int n_dau[] = { 2, 4, 5, 2, 2, 3 };
+
+// Branch name prefix and candidate count branch of each block.
+const char *block_name[] = { "Y", "B", "D", "C", "h", "l", "gamma" };
+const char *block_count[] = { "nY", "nB", "nD", "nC", "nh", "nl", "ngamma" };
+
+// Float branches of the Y block and the range they are drawn from.
+struct YFloatBranch { const char *name; float lo, hi; };
+const YFloatBranch y_float_branches[] = {
+  { "YBPairMmissPrime2", -2.0, 10.0 },
+  { "YBPairEextra50", 0.0, 3.0 },
+  { "YTagBlP3MagCM", 0.0, 2.5 },
+  { "YSigBhP3MagCM", 0.0, 2.5 },
+  { "YTagBCosBY", -5.0, 5.0 },
+  { "YSigBCosBY", -5.0, 5.0 },
+  { "YTagBCosThetaDlCM", -1.0, 1.0 },
+  { "YSigBCosThetaDtauCM", -1.0, 1.0 },
+  { "YSigBVtxProbB", 0.0, 1.0 },
+  { "YBPairCosThetaT", -1.0, 1.0 },
+  { "YTagBDMass", 1.80, 1.90 },
+  { "YTagBDstarDeltaM", 0.13, 0.16 },
+  { "YTagBCosThetaDSoftCM", -1.0, 1.0 },
+  { "YTagBsoftP3MagCM", 0.0, 0.5 },
+  { "YSigBDMass", 1.80, 1.90 },
+  { "YSigBDstarDeltaM", 0.13, 0.16 },
+  { "YSigBCosThetaDSoftCM", -1.0, 1.0 },
+  { "YSigBsoftP3MagCM", 0.0, 0.5 },
+  { "YSigBhMass", 0.1, 1.0 },
+  { "YSigBVtxProbh", 0.0, 1.0 },
+};
+const int n_y_float_branches = sizeof(y_float_branches) / sizeof(YFloatBranch);
+
+// D decay modes registered in RecoDTypeCatalogue, written for the
+// D+ and D0. Anti-particles use the conjugate daughters.
+const std::vector<std::vector<int>> Dc_modes = {
+  { -KLund, piLund, piLund },                     // Dc_Kpipi
+  { -KLund, piLund, piLund, pi0Lund },            // Dc_Kpipipi0
+  { KSLund, KLund },                              // Dc_KsK
+  { KSLund, piLund },                             // Dc_Kspi
+  { KSLund, piLund, pi0Lund },                    // Dc_Kspipi0
+  { KSLund, piLund, piLund, -piLund },            // Dc_Kspipipi
+  { KLund, -KLund, piLund },                      // Dc_KKpi
+};
+const std::vector<std::vector<int>> D0_modes = {
+  { -KLund, piLund },                             // D0_Kpi
+  { -KLund, piLund, pi0Lund },                    // D0_Kpipi0
+  { -KLund, piLund, piLund, -piLund },            // D0_Kpipipi
+  { -KLund, piLund, piLund, -piLund, pi0Lund },   // D0_Kpipipipi0
+  { KSLund, piLund, -piLund },                    // D0_Kspipi
+  { KSLund, piLund, -piLund, pi0Lund },           // D0_Kspipipi0
+  { KSLund, pi0Lund },                            // D0_Kspi0
+  { KLund, -KLund },                              // D0_KK
+};
+
+// D* decay modes registered in RecoDTypeCatalogue.
+const std::vector<std::vector<int>> Dstarc_modes = {
+  { D0Lund, piLund },                             // Dstarc_D0pi
+  { DcLund, pi0Lund },                            // Dstarc_Dcpi0
+  { DcLund, gammaLund },                          // Dstarc_Dcgamma
+};
+const std::vector<std::vector<int>> Dstar0_modes = {
+  { D0Lund, pi0Lund },                            // Dstar0_D0pi0
+  { D0Lund, gammaLund },                          // Dstar0_D0gamma
+};
+
+const int vphoLund = 10022;
+
+// Lund ID of the anti-particle.
+int Conjugate(int lund) {
+  switch (lund) {
+    case UpsilonLund:
+    case vphoLund:
+    case KSLund:
+    case pi0Lund:
+    case gammaLund:
+      return lund;
+    default:
+      return -lund;
+  }
+}
+
+std::vector<int> Conjugate(std::vector<int> lunds) {
+  for (auto &l : lunds) l = Conjugate(l);
+  return lunds;
+}
+
+}
+
+NtupleGenerator::NtupleGenerator(unsigned seed) :
+  rng(seed), nY_min(1), nY_max(20), continuum_fraction(0.0),
+  event_count(0), upper_id(0), continuum(false) {
+
+  // Blocks other than Y are only capped by their limits by default.
+  for (int b = 0; b < kNBlocks; ++b) {
+    block_min[b] = -1;
+    block_max[b] = block_limit[b] - 1;
+  }
+
+  // Size every buffer once to its block limit.
+  Yfloat.assign(n_y_float_branches, std::vector<float>(max_nY));
+
+  lTrkIdx.resize(block_limit[kL]);
+  hTrkIdx.resize(block_limit[kH]);
+  eSelectorsMap.resize(block_limit[kH] + block_limit[kL]);
+  muSelectorsMap.resize(block_limit[kH] + block_limit[kL]);
+  KSelectorsMap.resize(block_limit[kH] + block_limit[kL]);
+  piSelectorsMap.resize(block_limit[kH] + block_limit[kL]);
+
+  YLund.resize(block_limit[kY]);
+  BLund.resize(block_limit[kB]);
+  DLund.resize(block_limit[kD]);
+  CLund.resize(block_limit[kC]);
+  hLund.resize(block_limit[kH]);
+  lLund.resize(block_limit[kL]);
+  gammaLund.resize(block_limit[kGamma]);
+
+  Ydau_idx.assign(n_dau[kY], std::vector<int>(block_limit[kY]));
+  Ydau_lund.assign(n_dau[kY], std::vector<int>(block_limit[kY]));
+  Bdau_idx.assign(n_dau[kB], std::vector<int>(block_limit[kB]));
+  Bdau_lund.assign(n_dau[kB], std::vector<int>(block_limit[kB]));
+  Ddau_idx.assign(n_dau[kD], std::vector<int>(block_limit[kD]));
+  Ddau_lund.assign(n_dau[kD], std::vector<int>(block_limit[kD]));
+  Cdau_idx.assign(n_dau[kC], std::vector<int>(block_limit[kC]));
+  Cdau_lund.assign(n_dau[kC], std::vector<int>(block_limit[kC]));
+  hdau_idx.assign(n_dau[kH], std::vector<int>(block_limit[kH]));
+  hdau_lund.assign(n_dau[kH], std::vector<int>(block_limit[kH]));
+  ldau_idx.assign(n_dau[kL], std::vector<int>(block_limit[kL]));
+  ldau_lund.assign(n_dau[kL], std::vector<int>(block_limit[kL]));
+
+  mcLund.resize(max_mc_length);
+  mothIdx.resize(max_mc_length);
+  dauIdx.resize(max_mc_length);
+  dauLen.resize(max_mc_length);
+  mcenergy.resize(max_mc_length);
+  hMCIdx.resize(block_limit[kH]);
+  lMCIdx.resize(block_limit[kL]);
+  gammaMCIdx.resize(block_limit[kGamma]);
+}
+
+void NtupleGenerator::set_seed(unsigned seed) {
+  rng.seed(seed);
+  event_count = 0;
+}
+
+void NtupleGenerator::set_nY_range(int min, int max) {
+  assert(0 <= min && min <= max && max <= max_nY);
+  nY_min = min;
+  nY_max = max;
+}
+
+// A min of -1 leaves the block unpadded.
+void NtupleGenerator::SetBlockRange(Block b, int min, int max) {
+  assert(b != kY);
+  assert(0 <= min && min <= max && max <= block_limit[b] - 1);
+  block_min[b] = min;
+  block_max[b] = max;
+}
+
+int NtupleGenerator::Uniform(int lo, int hi) {
+  return std::uniform_int_distribution<int>(lo, hi)(rng);
+}
+
+double NtupleGenerator::Uniform() {
+  return std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+}
+
+void NtupleGenerator::generate_event() {
+  continuum = (Uniform() < continuum_fraction);
+  GenerateMc();
+  GenerateReco();
+  FillBuffer();
+  ++event_count;
+}
+
+// The daughter ranges of the MC tree are rebuilt from the mother indices.
+void NtupleGenerator::SetEvent(const Event &event) {
+
+  assert(event.mc_lund.size() == event.mc_moth.size());
+  mcLen = 0;
+  for (std::size_t i = 0; i < event.mc_lund.size(); ++i) {
+    AddMc(event.mc_lund[i], event.mc_moth[i]);
+  }
+  for (int i = 0; i < mcLen; ++i) {
+    int m = mothIdx[i];
+    if (m < 0) continue;
+    assert(m < mcLen);
+    if (dauLen[m] == 0) dauIdx[m] = i;
+    assert(dauIdx[m] + dauLen[m] == i);
+    ++dauLen[m];
+  }
+
+  const std::vector<RecoCand> *blocks[] = {
+    &event.Y, &event.B, &event.D, &event.C, &event.h, &event.l, &event.gamma,
+  };
+  for (int b = 0; b < kNBlocks; ++b) {
+    assert(static_cast<int>(blocks[b]->size()) <= block_limit[b]);
+    reco[b] = *blocks[b];
+  }
+
+  FillBuffer();
+  ++event_count;
+}
+
+
+// MC truth
+// --------
+
+int NtupleGenerator::AddMc(int lund, int moth) {
+  assert(mcLen < max_mc_length);
+  mcLund[mcLen] = lund;
+  mothIdx[mcLen] = moth;
+  dauIdx[mcLen] = -1;
+  dauLen[mcLen] = 0;
+  mcenergy[mcLen] = static_cast<float>(5.29 * Uniform());
+  return mcLen++;
+}
+
+// Particles are decayed in the order they are added, so the daughters
+// of each particle are contiguous and the tree is breadth first.
+void NtupleGenerator::GenerateMc() {
+
+  mcLen = 0;
+
+  // Index 0 and 1 are the beams.
+  AddMc(eLund, -1);
+  AddMc(-eLund, -1);
+  AddMc(continuum ? vphoLund : UpsilonLund, -1);
+
+  for (int i = 2; i < mcLen; ++i) {
+    std::vector<int> daughters = McDecay(mcLund[i]);
+    if (daughters.empty()) continue;
+    dauIdx[i] = mcLen;
+    dauLen[i] = daughters.size();
+    for (auto l : daughters) AddMc(l, i);
+  }
+}
+
+// Daughters of one decay of a particle with Lund ID lund. Decays are
+// written for one charge and conjugated for the other.
+std::vector<int> NtupleGenerator::McDecay(int lund) {
+
+  switch (lund) {
+    case UpsilonLund:
+      return (Uniform(0, 1) ?
+          std::vector<int>{ B0Lund, -B0Lund } :
+          std::vector<int>{ BcLund, -BcLund });
+    case vphoLund:
+      return { D0Lund, -D0Lund };
+  }
+
+  // B- and anti-B0 decay to D(*) l- anti-nu or D(*) tau- anti-nu.
+  std::vector<int> d;
+  switch (std::abs(lund)) {
+    case B0Lund:
+    case BcLund:
+      if (std::abs(lund) == B0Lund) {
+        d.push_back(Uniform(0, 1) ? DcLund : DstarcLund);
+      } else {
+        d.push_back(Uniform(0, 1) ? D0Lund : Dstar0Lund);
+      }
+      switch (Uniform(0, 3)) {
+        case 0:
+          d.insert(d.end(), { eLund, -nu_eLund });
+          break;
+        case 1:
+          d.insert(d.end(), { muLund, -nu_muLund });
+          break;
+        default:
+          d.insert(d.end(), { tauLund, -nu_tauLund });
+      }
+      return (lund > 0) ? Conjugate(d) : d;
+
+    case tauLund:
+      switch (Uniform(0, 3)) {
+        case 0:
+          d = { eLund, -nu_eLund, nu_tauLund };
+          break;
+        case 1:
+          d = { muLund, -nu_muLund, nu_tauLund };
+          break;
+        case 2:
+          d = { -piLund, nu_tauLund };
+          break;
+        default:
+          d = { -rhoLund, nu_tauLund };
+      }
+      return (lund < 0) ? Conjugate(d) : d;
+
+    case rhoLund:
+      d = { piLund, pi0Lund };
+      return (lund < 0) ? Conjugate(d) : d;
+
+    case DstarcLund:
+      d = Dstarc_modes[Uniform(0, Dstarc_modes.size() - 1)];
+      return (lund < 0) ? Conjugate(d) : d;
+
+    case Dstar0Lund:
+      d = Dstar0_modes[Uniform(0, Dstar0_modes.size() - 1)];
+      return (lund < 0) ? Conjugate(d) : d;
+
+    case DcLund:
+      d = Dc_modes[Uniform(0, Dc_modes.size() - 1)];
+      return (lund < 0) ? Conjugate(d) : d;
+
+    case D0Lund:
+      d = D0_modes[Uniform(0, D0_modes.size() - 1)];
+      return (lund < 0) ? Conjugate(d) : d;
+
+    case KSLund:
+      return { piLund, -piLund };
+
+    case pi0Lund:
+      return { bdtaunu::gammaLund, bdtaunu::gammaLund };
+
+    default:
+      return {};
+  }
+}
+
+
+// Reco candidates
+// ---------------
+
+// Candidate block BtaTupleMaker stores a particle in; see RecoIndexer.
+NtupleGenerator::Block NtupleGenerator::BlockOf(int lund) {
+  switch (std::abs(lund)) {
+    case UpsilonLund:
+      return kY;
+    case B0Lund:
+    case BcLund:
+      return kB;
+    case D0Lund:
+    case DcLund:
+    case Dstar0Lund:
+    case DstarcLund:
+      return kD;
+    case KSLund:
+    case rhoLund:
+    case pi0Lund:
+      return kC;
+    case KLund:
+    case piLund:
+      return kH;
+    case eLund:
+    case muLund:
+      return kL;
+    case bdtaunu::gammaLund:
+      return kGamma;
+    default:
+      assert(false);
+      return kNBlocks;
+  }
+}
+
+int NtupleGenerator::AddReco(
+    int lund, int mc_idx,
+    const std::vector<int> &dau_lund,
+    const std::vector<int> &dau_idx) {
+  std::vector<RecoCand> &block = reco[BlockOf(lund)];
+  block.push_back({ lund, mc_idx, dau_lund, dau_idx });
+  return block.size() - 1;
+}
+
+// Reconstruct MC particle mc_idx and its visible descendants. Returns
+// its index within its block, or -1 for particles that are not
+// reconstructed (neutrinos, beams).
+int NtupleGenerator::RecoFromMc(int mc_idx) {
+
+  if (mc_reco_idx[mc_idx] != -2) return mc_reco_idx[mc_idx];
+
+  int lund = mcLund[mc_idx];
+  int reco_idx = -1;
+  std::vector<int> dau_lund, dau_idx;
+
+  switch (std::abs(lund)) {
+    case KLund:
+    case piLund:
+    case eLund:
+    case muLund:
+    case bdtaunu::gammaLund:
+      reco_idx = AddReco(lund, mc_idx);
+      break;
+
+    case KSLund:
+    case pi0Lund:
+    case rhoLund:
+    case D0Lund:
+    case DcLund:
+    case Dstar0Lund:
+    case DstarcLund:
+      for (int i = dauIdx[mc_idx]; i < dauIdx[mc_idx] + dauLen[mc_idx]; ++i) {
+        dau_lund.push_back(mcLund[i]);
+        dau_idx.push_back(RecoFromMc(i));
+      }
+      reco_idx = AddReco(lund, -1, dau_lund, dau_idx);
+      break;
+
+    // B's are reconstructed from the D(*) and the charged lepton, or
+    // for tau decays, the charged daughter of the tau.
+    case B0Lund:
+    case BcLund:
+      for (int i = dauIdx[mc_idx]; i < dauIdx[mc_idx] + dauLen[mc_idx]; ++i) {
+        int j = i;
+        if (std::abs(mcLund[i]) == tauLund) {
+          j = dauIdx[i];
+        }
+        switch (std::abs(mcLund[j])) {
+          case nu_eLund:
+          case nu_muLund:
+          case nu_tauLund:
+            continue;
+        }
+        dau_lund.push_back(mcLund[j]);
+        dau_idx.push_back(RecoFromMc(j));
+      }
+      reco_idx = AddReco(lund, -1, dau_lund, dau_idx);
+      break;
+  }
+
+  mc_reco_idx[mc_idx] = reco_idx;
+  return reco_idx;
+}
+
+// Make a combinatoric candidate that is not matched to MC truth.
+// Returns -1 if its block, or the block of a daughter, is full.
+int NtupleGenerator::MakeFake(int lund) {
+
+  Block b = BlockOf(lund);
+  if (static_cast<int>(reco[b].size()) >= block_max[b]) return -1;
+
+  std::vector<int> dau_lund;
+  switch (std::abs(lund)) {
+    case KLund:
+    case piLund:
+    case eLund:
+    case muLund:
+    case bdtaunu::gammaLund:
+      return AddReco(lund, -1);
+    case KSLund:
+    case pi0Lund:
+    case rhoLund:
+      dau_lund = McDecay(lund);
+      break;
+    case DcLund:
+    case D0Lund:
+    case DstarcLund:
+    case Dstar0Lund:
+      dau_lund = McDecay(lund);
+      break;
+    default:
+      assert(false);
+      return -1;
+  }
+
+  RecoCand cand = { lund, -1, {}, {} };
+  for (auto l : dau_lund) {
+    int idx = PickOrMake(l, cand);
+    if (idx < 0) return -1;
+    cand.dau_lund.push_back(l);
+    cand.dau_idx.push_back(idx);
+  }
+
+  // A daughter in the same block, e.g. the D of a D*, may have filled it.
+  if (static_cast<int>(reco[b].size()) >= block_max[b]) return -1;
+
+  return AddReco(lund, -1, cand.dau_lund, cand.dau_idx);
+}
+
+// A candidate of type lund that is not already a daughter of parent.
+// Existing candidates are reused most of the time, the way the same
+// tracks and photons enter many composites in real events.
+int NtupleGenerator::PickOrMake(int lund, const RecoCand &parent) {
+
+  const std::vector<RecoCand> &block = reco[BlockOf(lund)];
+
+  std::vector<int> candidates;
+  for (int i = 0; i < static_cast<int>(block.size()); ++i) {
+    if (block[i].lund != lund) continue;
+    bool used = false;
+    for (std::size_t k = 0; k < parent.dau_idx.size(); ++k) {
+      if (parent.dau_lund[k] == lund && parent.dau_idx[k] == i) used = true;
+    }
+    if (!used) candidates.push_back(i);
+  }
+
+  if (candidates.empty() || Uniform() < 0.3) {
+    int idx = MakeFake(lund);
+    if (idx >= 0 || candidates.empty()) return idx;
+  }
+  return candidates[Uniform(0, candidates.size() - 1)];
+}
+
+// Make a combinatoric B candidate from an existing D/D* and a tag
+// lepton or signal hadron.
+int NtupleGenerator::MakeFakeB(bool tag) {
+
+  if (static_cast<int>(reco[kB].size()) >= block_max[kB]) return -1;
+  if (reco[kD].empty()) return -1;
+
+  int d_idx = Uniform(0, reco[kD].size() - 1);
+  int d_lund = reco[kD][d_idx].lund;
+
+  int lepton_lund;
+  if (tag) {
+    lepton_lund = Uniform(0, 1) ? eLund : muLund;
+  } else {
+    lepton_lund = Uniform(0, 1) ? piLund : rhoLund;
+  }
+  if (Uniform(0, 1)) lepton_lund = -lepton_lund;
+
+  RecoCand b = { 0, -1, {}, {} };
+  int lepton_idx = PickOrMake(lepton_lund, b);
+  if (lepton_idx < 0) return -1;
+
+  int b_lund = (std::abs(d_lund) == DcLund || std::abs(d_lund) == DstarcLund) ? B0Lund : BcLund;
+  if (Uniform(0, 1)) b_lund = -b_lund;
+
+  return AddReco(b_lund, -1, { d_lund, lepton_lund }, { d_idx, lepton_idx });
+}
+
+// Tag B's are the ones reconstructed with an e or mu.
+bool NtupleGenerator::IsTagB(int b_idx) const {
+  for (auto l : reco[kB][b_idx].dau_lund) {
+    if (std::abs(l) == eLund || std::abs(l) == muLund) return true;
+  }
+  return false;
+}
+
+void NtupleGenerator::GenerateReco() {
+
+  for (auto &block : reco) block.clear();
+  mc_reco_idx.assign(mcLen, -2);
+
+  // Reconstruct the MC truth.
+  std::vector<int> true_B;
+  for (int i = 0; i < mcLen; ++i) {
+    int lund = std::abs(mcLund[i]);
+    if (lund == B0Lund || lund == BcLund) {
+      true_B.push_back(RecoFromMc(i));
+    } else if (continuum && (lund == D0Lund)) {
+      RecoFromMc(i);
+    }
+  }
+
+  // Seed the track and photon pools so that composites can always
+  // find distinct daughters once the blocks fill up.
+  for (auto l : { piLund, -piLund, KLund, -KLund }) {
+    for (int k = 0; k < 3; ++k) MakeFake(l);
+  }
+  for (int k = 0; k < 4; ++k) MakeFake(bdtaunu::gammaLund);
+
+  // Enough tag and signal B's to form nY distinct pairs.
+  int target_nY = Uniform(nY_min, nY_max);
+  int n_tag = 0, n_sig = 0;
+  if (target_nY > 0) {
+    n_tag = static_cast<int>(std::ceil(std::sqrt(target_nY)));
+    n_sig = (target_nY + n_tag - 1) / n_tag;
+  }
+
+  // Combinatoric D's; about one for every two B's.
+  int n_fake_D = (n_tag + n_sig + 1) / 2;
+  for (int k = 0; k < n_fake_D; ++k) {
+    int lund = (Uniform(0, 1) ? 1 : -1) *
+      std::vector<int>{ DcLund, D0Lund, DstarcLund, Dstar0Lund }[Uniform(0, 3)];
+    MakeFake(lund);
+  }
+
+  std::vector<int> tag_B, sig_B;
+  for (int i = 0; i < static_cast<int>(reco[kB].size()); ++i) {
+    (IsTagB(i) ? tag_B : sig_B).push_back(i);
+  }
+  while (static_cast<int>(tag_B.size()) < n_tag) {
+    int idx = MakeFakeB(true);
+    if (idx < 0) break;
+    tag_B.push_back(idx);
+  }
+  while (static_cast<int>(sig_B.size()) < n_sig) {
+    int idx = MakeFakeB(false);
+    if (idx < 0) break;
+    sig_B.push_back(idx);
+  }
+
+  // Form Y's from distinct tag and signal B pairs. The pair of true
+  // B's, if it is one, always comes first.
+  std::vector<std::pair<int, int>> pairs;
+  for (auto t : tag_B) {
+    for (auto s : sig_B) pairs.push_back({ t, s });
+  }
+  auto first = pairs.begin();
+  if (true_B.size() == 2) {
+    int t = IsTagB(true_B[0]) ? true_B[0] : true_B[1];
+    int s = IsTagB(true_B[0]) ? true_B[1] : true_B[0];
+    auto it = std::find(pairs.begin(), pairs.end(), std::make_pair(t, s));
+    if (it != pairs.end()) std::iter_swap(first++, it);
+  }
+  std::shuffle(first, pairs.end(), rng);
+  pairs.resize(std::min<int>(pairs.size(), target_nY));
+
+  for (const auto &p : pairs) {
+    int b[2] = { p.first, p.second };
+    if (Uniform(0, 1)) std::swap(b[0], b[1]);
+    AddReco(UpsilonLund, -1,
+            { reco[kB][b[0]].lund, reco[kB][b[1]].lund }, { b[0], b[1] });
+  }
+
+  PadBlocks();
+}
+
+// Add combinatoric candidates to each block with a range until it holds
+// a number drawn from the range. Composites come first, so that the
+// tracks and photons they make count toward their own blocks.
+void NtupleGenerator::PadBlocks() {
+
+  static const std::vector<int> pad_lunds[] = {
+    {}, {},
+    { DcLund, D0Lund, DstarcLund, Dstar0Lund },
+    { KSLund, pi0Lund, rhoLund },
+    { piLund, KLund },
+    { eLund, muLund },
+    { bdtaunu::gammaLund },
+  };
+
+  for (int b = kB; b < kNBlocks; ++b) {
+    if (block_min[b] < 0) continue;
+    int target = Uniform(block_min[b], block_max[b]);
+    while (static_cast<int>(reco[b].size()) < target) {
+      int idx;
+      if (b == kB) {
+        idx = MakeFakeB(Uniform(0, 1));
+      } else {
+        const std::vector<int> &lunds = pad_lunds[b];
+        int lund = lunds[Uniform(0, lunds.size() - 1)];
+        idx = MakeFake(Uniform(0, 1) ? Conjugate(lund) : lund);
+      }
+      if (idx < 0) break;
+    }
+  }
+}
+
+
+// Buffer
+// ------
+
+void NtupleGenerator::FillBlock(
+    Block b, int &n, std::vector<int> &lund,
+    std::vector<std::vector<int>> &dau_idx,
+    std::vector<std::vector<int>> &dau_lund) {
+  n = reco[b].size();
+  for (int i = 0; i < n; ++i) {
+    const RecoCand &cand = reco[b][i];
+    lund[i] = cand.lund;
+    for (std::size_t k = 0; k < dau_idx.size(); ++k) {
+      bool has_dau = (k < cand.dau_idx.size());
+      dau_idx[k][i] = has_dau ? cand.dau_idx[k] : -1;
+      dau_lund[k][i] = has_dau ? cand.dau_lund[k] : 0;
+    }
+  }
+}
+
+void NtupleGenerator::FillBuffer() {
+
+  platform = 1;
+  partition = 1;
+  upperID = upper_id;
+  lowerID = event_count;
+  R2All = static_cast<float>(Uniform());
+
+  FillBlock(kY, nY, YLund, Ydau_idx, Ydau_lund);
+  FillBlock(kB, nB, BLund, Bdau_idx, Bdau_lund);
+  FillBlock(kD, nD, DLund, Ddau_idx, Ddau_lund);
+  FillBlock(kC, nC, CLund, Cdau_idx, Cdau_lund);
+  FillBlock(kH, nh, hLund, hdau_idx, hdau_lund);
+  FillBlock(kL, nl, lLund, ldau_idx, ldau_lund);
+
+  ngamma = reco[kGamma].size();
+  for (int i = 0; i < ngamma; ++i) {
+    gammaLund[i] = reco[kGamma][i].lund;
+    gammaMCIdx[i] = reco[kGamma][i].mc_idx;
+  }
+
+  for (int j = 0; j < n_y_float_branches; ++j) {
+    const YFloatBranch &br = y_float_branches[j];
+    for (int i = 0; i < nY; ++i) {
+      Yfloat[j][i] = static_cast<float>(br.lo + (br.hi - br.lo) * Uniform());
+    }
+  }
+
+  // Each h and l candidate is given its own track.
+  for (int i = 0; i < nh; ++i) {
+    hMCIdx[i] = reco[kH][i].mc_idx;
+    hTrkIdx[i] = i;
+  }
+  for (int i = 0; i < nl; ++i) {
+    lMCIdx[i] = reco[kL][i].mc_idx;
+    lTrkIdx[i] = nh + i;
+  }
+  nTrk = nh + nl;
+  for (int i = 0; i < nTrk; ++i) {
+    eSelectorsMap[i] = Uniform(0, 0xffff);
+    muSelectorsMap[i] = Uniform(0, 0xffff);
+    KSelectorsMap[i] = Uniform(0, 0xffff);
+    piSelectorsMap[i] = Uniform(0, 0xffff);
+  }
+}
+
+
+// Output
+// ------
+
+void NtupleGenerator::write(
+    const char *root_fname, int nevents, const char *root_trname) {
+  Write(root_fname, root_trname, nevents, [this] (int) { generate_event(); });
+}
+
+void NtupleGenerator::write(
+    const char *root_fname, const std::vector<Event> &events, const char *root_trname) {
+  Write(root_fname, root_trname, events.size(),
+        [this, &events] (int i) { SetEvent(events[i]); });
+}
+
+// Book every branch, then fill one entry per call to next_event.
+void NtupleGenerator::Write(
+    const char *root_fname, const char *root_trname,
+    int nevents, std::function<void(int)> next_event) {
+
+  TFile *tfile = new TFile(root_fname, "RECREATE");
+  if (tfile->IsZombie()) {
+    std::cerr << "TFile* associated to \"" << root_fname;
+    std::cerr << "\" is invalid." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  TTree *tr = new TTree(root_trname, root_trname);
+
+  tr->Branch("platform", &platform, "platform/I");
+  tr->Branch("partition", &partition, "partition/I");
+  tr->Branch("upperID", &upperID, "upperID/I");
+  tr->Branch("lowerID", &lowerID, "lowerID/I");
+  tr->Branch("nTRK", &nTrk, "nTRK/I");
+  tr->Branch("R2All", &R2All, "R2All/F");
+
+  // Candidate blocks. Counts must be booked before the arrays sized by them.
+  int *counts[] = { &nY, &nB, &nD, &nC, &nh, &nl, &ngamma };
+  for (int b = 0; b < kNBlocks; ++b) {
+    tr->Branch(block_count[b], counts[b], (std::string(block_count[b]) + "/I").c_str());
+  }
+
+  std::vector<int> *lunds[] = { &YLund, &BLund, &DLund, &CLund, &hLund, &lLund, &gammaLund };
+  std::vector<std::vector<int>> *dau_idx[] = { &Ydau_idx, &Bdau_idx, &Ddau_idx, &Cdau_idx, &hdau_idx, &ldau_idx };
+  std::vector<std::vector<int>> *dau_lund[] = { &Ydau_lund, &Bdau_lund, &Ddau_lund, &Cdau_lund, &hdau_lund, &ldau_lund };
+  for (int b = 0; b < kNBlocks; ++b) {
+    std::string name = std::string(block_name[b]) + "Lund";
+    tr->Branch(name.c_str(), lunds[b]->data(),
+               (name + "[" + block_count[b] + "]/I").c_str());
+  }
+  for (int b = 0; b < kGamma; ++b) {
+    for (int k = 0; k < n_dau[b]; ++k) {
+      std::string prefix = std::string(block_name[b]) + "d" + std::to_string(k + 1);
+      tr->Branch((prefix + "Idx").c_str(), (*dau_idx[b])[k].data(),
+                 (prefix + "Idx[" + block_count[b] + "]/I").c_str());
+      tr->Branch((prefix + "Lund").c_str(), (*dau_lund[b])[k].data(),
+                 (prefix + "Lund[" + block_count[b] + "]/I").c_str());
+    }
+  }
+
+  for (int j = 0; j < n_y_float_branches; ++j) {
+    std::string name = y_float_branches[j].name;
+    tr->Branch(name.c_str(), Yfloat[j].data(), (name + "[nY]/F").c_str());
+  }
+
+  tr->Branch("hTrkIdx", hTrkIdx.data(), "hTrkIdx[nh]/I");
+  tr->Branch("lTrkIdx", lTrkIdx.data(), "lTrkIdx[nl]/I");
+  tr->Branch("eSelectorsMap", eSelectorsMap.data(), "eSelectorsMap[nTRK]/I");
+  tr->Branch("muSelectorsMap", muSelectorsMap.data(), "muSelectorsMap[nTRK]/I");
+  tr->Branch("KSelectorsMap", KSelectorsMap.data(), "KSelectorsMap[nTRK]/I");
+  tr->Branch("piSelectorsMap", piSelectorsMap.data(), "piSelectorsMap[nTRK]/I");
+
+  // MC truth and truth match.
+  tr->Branch("mcLen", &mcLen, "mcLen/I");
+  tr->Branch("mcLund", mcLund.data(), "mcLund[mcLen]/I");
+  tr->Branch("mothIdx", mothIdx.data(), "mothIdx[mcLen]/I");
+  tr->Branch("dauIdx", dauIdx.data(), "dauIdx[mcLen]/I");
+  tr->Branch("dauLen", dauLen.data(), "dauLen[mcLen]/I");
+  tr->Branch("mcenergy", mcenergy.data(), "mcenergy[mcLen]/F");
+  tr->Branch("hMCIdx", hMCIdx.data(), "hMCIdx[nh]/I");
+  tr->Branch("lMCIdx", lMCIdx.data(), "lMCIdx[nl]/I");
+  tr->Branch("gammaMCIdx", gammaMCIdx.data(), "gammaMCIdx[ngamma]/I");
+
+  for (int i = 0; i < nevents; ++i) {
+    next_event(i);
+    tr->Fill();
+  }
+
+  tfile->Write();
+  tfile->Close();
+  delete tfile;
+}
@@ -0,0 +1,215 @@
+#ifndef __NTUPLEGENERATOR_H__
+#define __NTUPLEGENERATOR_H__
+
+#include <vector>
+#include <random>
+#include <functional>
+
+/** @brief Writes synthetic BtaTupleMaker ntuples.
+ *
+ * @detail
+ * # Purpose
+ * This class generates events in the `ntp1` format read by
+ * BDtaunuReader and BDtaunuMcReader, so that the library can be
+ * benchmarked and regression tested without real SLAC ntuples. Every
+ * branch the readers bind is written.
+ *
+ * # Events
+ * Each event is generated in two steps:
+ * 1. An MC truth tree. An \f$\Upsilon(4S)\f$ decays to a \f$B\bar{B}\f$
+ *    pair, or for continuum events a virtual photon decays to a
+ *    \f$D^0\bar{D}^0\f$ pair. Each \f$B\f$ decays to
+ *    \f$D^{(*)}\ell\nu\f$ or \f$D^{(*)}\tau\nu\f$. All \f$D/D^*\f$ decays
+ *    are modes registered in RecoDTypeCatalogue. The tree is stored
+ *    breadth first, the way BtaTupleMaker stores it, and always fits in
+ *    the 100 particle limit of BDtaunuMcReader.
+ * 2. A reco candidate DAG,
+ *    \f$\Upsilon\rightarrow B\rightarrow D/D^*\rightarrow C/h/\ell/\gamma\f$.
+ *    Every visible MC truth particle is first reconstructed, with
+ *    `hMCIdx`, `lMCIdx`, and `gammaMCIdx` pointing back to the MC
+ *    particles. Combinatoric candidates are then added from unmatched
+ *    tracks and photons (MC index -1) until the requested number of
+ *    \f$\Upsilon(4S)\f$ candidates can be formed. Each
+ *    \f$\Upsilon(4S)\f$ candidate pairs a tag \f$B\f$
+ *    (\f$D^{(*)}\ell\f$) with a signal \f$B\f$ (\f$D^{(*)}\pi\f$ or
+ *    \f$D^{(*)}\rho\f$).
+ *
+ * # Multiplicity
+ * The number of \f$\Upsilon(4S)\f$ candidates per event is drawn
+ * uniformly from `set_nY_range()`, up to 800. Events with 800
+ * candidates hit the BtaTupleMaker limit and are reported by the
+ * readers as RootReader::Status::kMaxRecoCandExceeded. All other
+ * candidate blocks are kept under their limits.
+ *
+ * The other blocks can be given a range too, e.g. `set_nh_range()`.
+ * Combinatoric candidates then stop at the block's max, and once the
+ * \f$\Upsilon(4S)\f$ candidates are formed the block is padded up to a
+ * number drawn uniformly from its range. Candidates reconstructed from
+ * MC truth are always made, so a block can exceed a max below their
+ * number, and a small range for a block that \f$\Upsilon(4S)\f$
+ * candidates are built from leaves fewer of them than `set_nY_range()`
+ * asks for. A block whose range is not set is not padded.
+ *
+ * Output is fully determined by the seed.
+ *
+ * # Hand built events
+ * Events with a given MC tree and candidates can be written instead
+ * with `write(root_fname, events)`; e.g. to build adversarial events for
+ * benchmarks. The branches an Event does not give, the \f$\Upsilon(4S)\f$
+ * features, the selector maps, and `mcenergy`, are drawn as for
+ * generated events.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     NtupleGenerator generator(1234);
+ *     generator.set_nY_range(10, 200);
+ *     generator.set_continuum_fraction(0.25);
+ *     generator.write("synthetic.root", 10000);
+ */
+class NtupleGenerator {
+
+  public:
+
+    //! Largest allowed number of \f$\Upsilon(4S)\f$ candidates per event.
+    static const int max_nY;
+
+    NtupleGenerator(unsigned seed = 1);
+    NtupleGenerator(const NtupleGenerator&) = delete;
+    NtupleGenerator &operator=(const NtupleGenerator&) = delete;
+    ~NtupleGenerator() {};
+
+    //! Restart the random sequence.
+    void set_seed(unsigned seed);
+
+    //! Number of \f$\Upsilon(4S)\f$ candidates per event is uniform in [min, max].
+    void set_nY_range(int min, int max);
+    int get_nY_min() const { return nY_min; }
+    int get_nY_max() const { return nY_max; }
+
+    //! Number of candidates in each of the other blocks is uniform in [min, max].
+    /*! See Multiplicity above. max is below the block's limit. */
+    void set_nB_range(int min, int max) { SetBlockRange(kB, min, max); }
+    void set_nD_range(int min, int max) { SetBlockRange(kD, min, max); }
+    void set_nC_range(int min, int max) { SetBlockRange(kC, min, max); }
+    void set_nh_range(int min, int max) { SetBlockRange(kH, min, max); }
+    void set_nl_range(int min, int max) { SetBlockRange(kL, min, max); }
+    void set_ngamma_range(int min, int max) { SetBlockRange(kGamma, min, max); }
+
+    //! Fraction of events that are continuum.
+    void set_continuum_fraction(double f) { continuum_fraction = f; }
+    double get_continuum_fraction() const { return continuum_fraction; }
+
+    //! upperID of the events; lowerID counts events since the last seed.
+    /*! Give each file of a dataset its own, so event Ids are unique. */
+    void set_upperID(int id) { upper_id = id; }
+
+    //! Generate the next event into the buffer.
+    void generate_event();
+
+    //! Generate nevents events and write them to TTree root_trname in root_fname.
+    void write(const char *root_fname, int nevents, const char *root_trname = "ntp1");
+
+    //! A reco candidate before it is flattened into the buffer.
+    /*! `dau_idx` index the blocks of the daughters' Lund IDs. `mc_idx`
+     * is only used by h, l, and gamma candidates; -1 if not matched. */
+    struct RecoCand {
+      int lund;
+      int mc_idx;
+      std::vector<int> dau_lund;
+      std::vector<int> dau_idx;
+    };
+
+    //! A hand built event.
+    /*! The MC tree is given by the Lund ID and mother index (-1 for none)
+     * of each particle. The daughters of a particle must be contiguous.
+     * Candidates are given per block, up to the block's limit. */
+    struct Event {
+      std::vector<int> mc_lund, mc_moth;
+      std::vector<RecoCand> Y, B, D, C, h, l, gamma;
+    };
+
+    //! Write events to TTree root_trname in root_fname.
+    void write(const char *root_fname, const std::vector<Event> &events, const char *root_trname = "ntp1");
+
+  private:
+
+    // Reco candidate blocks, in BtaTupleMaker's order.
+    enum Block { kY, kB, kD, kC, kH, kL, kGamma, kNBlocks };
+
+    // Generator state
+    // ---------------
+    std::mt19937 rng;
+    int nY_min, nY_max;
+    int block_min[kNBlocks], block_max[kNBlocks];
+    double continuum_fraction;
+    int event_count;
+    int upper_id;
+    bool continuum;
+
+    std::vector<RecoCand> reco[kNBlocks];
+    std::vector<int> mc_reco_idx;
+
+    // Buffer elements
+    // ---------------
+    // Named after the branches they are written to.
+    int platform, partition, upperID, lowerID;
+    int nTrk;
+    float R2All;
+
+    std::vector<std::vector<float>> Yfloat;
+
+    std::vector<int> lTrkIdx, hTrkIdx;
+    std::vector<int> eSelectorsMap, muSelectorsMap, KSelectorsMap, piSelectorsMap;
+
+    int nY, nB, nD, nC, nh, nl, ngamma;
+    std::vector<int> YLund, BLund, DLund, CLund, hLund, lLund, gammaLund;
+    std::vector<std::vector<int>> Ydau_idx, Ydau_lund;
+    std::vector<std::vector<int>> Bdau_idx, Bdau_lund;
+    std::vector<std::vector<int>> Ddau_idx, Ddau_lund;
+    std::vector<std::vector<int>> Cdau_idx, Cdau_lund;
+    std::vector<std::vector<int>> hdau_idx, hdau_lund;
+    std::vector<std::vector<int>> ldau_idx, ldau_lund;
+
+    int mcLen;
+    std::vector<int> mcLund, mothIdx, dauIdx, dauLen;
+    std::vector<float> mcenergy;
+    std::vector<int> hMCIdx, lMCIdx, gammaMCIdx;
+
+    // Helper functions
+    // ----------------
+
+    int Uniform(int lo, int hi);
+    double Uniform();
+
+    void SetBlockRange(Block b, int min, int max);
+
+    void GenerateMc();
+    int AddMc(int lund, int moth);
+    std::vector<int> McDecay(int lund);
+
+    static Block BlockOf(int lund);
+
+    void GenerateReco();
+    int RecoFromMc(int mc_idx);
+    int AddReco(int lund, int mc_idx,
+                const std::vector<int> &dau_lund = {},
+                const std::vector<int> &dau_idx = {});
+    int PickOrMake(int lund, const RecoCand &parent);
+    int MakeFake(int lund);
+    int MakeFakeB(bool tag);
+    bool IsTagB(int b_idx) const;
+    void PadBlocks();
+
+    void SetEvent(const Event &event);
+
+    void FillBuffer();
+    void FillBlock(Block b, int &n, std::vector<int> &lund,
+                   std::vector<std::vector<int>> &dau_idx,
+                   std::vector<std::vector<int>> &dau_lund);
+
+    void Write(const char *root_fname, const char *root_trname,
+               int nevents, std::function<void(int)> next_event);
+};
+
+#endif
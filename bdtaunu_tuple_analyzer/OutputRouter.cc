@@ -0,0 +1,162 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+
+#include <TROOT.h>
+
+#include "RootReader.h"
+#include "BDtaunuReader.h"
+#include "CandidateColumns.h"
+#include "OutputRouter.h"
+
+namespace {
+
+// 64 bit FNV-1a; stable across compilers and runs, unlike std::hash.
+unsigned long long Fnv1a(const std::string &s) {
+  unsigned long long h = 14695981039346656037ULL;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// The splitmix64 finalizer. FNV-1a barely mixes the last characters of
+// a key into the high bits, which decide the split.
+unsigned long long Mix(unsigned long long h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+}
+
+OutputRouter::OutputRouter(bool _mc_labels, Long64_t _chunk_rows, size_t _buffer_events) :
+  mc_labels(_mc_labels), chunk_rows(_chunk_rows),
+  buffer_events(_buffer_events ? _buffer_events : 1), closed(false) {
+  ROOT::EnableThreadSafety();
+}
+
+OutputRouter::~OutputRouter() {
+  close();
+}
+
+int OutputRouter::add_sink(const std::string &fname, Predicate keep) {
+  return AddSink(std::unique_ptr<CandidateColumnWriter>(
+      new CandidateColumnWriter(fname, mc_labels, chunk_rows)), keep);
+}
+
+int OutputRouter::add_sink(const std::string &event_fname,
+                           const std::string &candidate_fname, Predicate keep) {
+  return AddSink(std::unique_ptr<CandidateColumnWriter>(
+      new CandidateColumnWriter(event_fname, candidate_fname, mc_labels, chunk_rows)), keep);
+}
+
+int OutputRouter::AddSink(std::unique_ptr<CandidateColumnWriter> writer, Predicate keep) {
+  if (closed) {
+    std::cerr << "OutputRouter: sink added after close()." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::unique_ptr<Sink> sink(new Sink);
+  sink->keep = keep;
+  sink->writer = std::move(writer);
+  sink->thread = std::thread(&OutputRouter::Drain, this, sink.get());
+  sinks.push_back(std::move(sink));
+  return sinks.size() - 1;
+}
+
+OutputRouter::Predicate OutputRouter::HashSplit(double lo, double hi, std::uint64_t seed) {
+  return [lo, hi, seed] (const BDtaunuReader &reader) {
+    double x = HashFraction(reader.get_eventId(), seed);
+    return x >= lo && x < hi;
+  };
+}
+
+double OutputRouter::HashFraction(const std::string &eventId, std::uint64_t seed) {
+  unsigned long long h = Mix(Fnv1a(eventId) ^ Mix(seed));
+  return (h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Write the queued events of a sink, a queue at a time, until it is
+// closed and empty, then close its files; the last chunks of every sink
+// are written in parallel.
+void OutputRouter::Drain(Sink *sink) {
+  std::deque<std::shared_ptr<const CandidateColumnWriter::Event>> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(sink->mutex);
+      sink->cv.wait(lock, [sink] { return sink->closing || !sink->queue.empty(); });
+      if (sink->queue.empty()) break;
+      batch.swap(sink->queue);
+    }
+    sink->cv.notify_all();
+    for (const auto &event : batch) sink->writer->write(*event);
+    batch.clear();
+  }
+  sink->writer->close();
+}
+
+void OutputRouter::route(const BDtaunuReader &reader) {
+
+  if (closed) {
+    std::cerr << "OutputRouter: event routed after close()." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::shared_ptr<const CandidateColumnWriter::Event> event;
+  for (auto &sink : sinks) {
+    if (sink->keep && !sink->keep(reader)) continue;
+
+    if (!event) {
+      event = std::make_shared<const CandidateColumnWriter::Event>(
+          CandidateColumnWriter::Snapshot(reader));
+      if (mc_labels && !event->has_mc_labels) {
+        std::cerr << "OutputRouter: MC labels asked for, ";
+        std::cerr << "but the reader is not a BDtaunuMcReader." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    Sink *s = sink.get();
+    {
+      std::unique_lock<std::mutex> lock(s->mutex);
+      s->cv.wait(lock, [this, s] { return s->queue.size() < buffer_events; });
+      s->queue.push_back(event);
+    }
+    s->cv.notify_all();
+    ++s->nevents;
+  }
+}
+
+Long64_t OutputRouter::run(BDtaunuReader &reader) {
+  Long64_t nrouted = 0;
+  RootReader::Status status;
+  while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+    if (status != RootReader::Status::kReadSucceeded) continue;
+    route(reader);
+    ++nrouted;
+  }
+  return nrouted;
+}
+
+void OutputRouter::close() {
+  if (closed) return;
+  closed = true;
+  for (auto &sink : sinks) {
+    {
+      std::lock_guard<std::mutex> lock(sink->mutex);
+      sink->closing = true;
+    }
+    sink->cv.notify_all();
+  }
+  for (auto &sink : sinks) sink->thread.join();
+}
@@ -0,0 +1,136 @@
+#ifndef __OUTPUTROUTER_H__
+#define __OUTPUTROUTER_H__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include <Rtypes.h>
+
+#include "BDtaunuReader.h"
+#include "CandidateColumns.h"
+
+/** @brief Writes several partitions of the events of one reader in a
+ * single pass.
+ *
+ * @detail
+ * # Purpose
+ * Train, test, and validation splits, per sample files, and signal and
+ * background files are all subsets of the same events. Rather than
+ * reading and decompressing the input once per output, this class
+ * offers every event of one reader to a list of sinks, and writes each
+ * event to the columnar file of every sink that takes it, as
+ * CandidateColumnWriter does.
+ *
+ * # Routing
+ * Each sink has a predicate, called on the reader with the current
+ * event; a null predicate takes every event. An event may go to any
+ * number of sinks, or to none. `HashSplit()` makes predicates that
+ * split events by a hash of their event Id: the split of an event does
+ * not depend on the order or on the files it is read from, and
+ * predicates with the same seed and disjoint ranges never take the
+ * same event.
+ *
+ * # Buffering
+ * Encoding and compressing the columns is done by one writer thread per
+ * sink, so the event loop only reads, derives, and routes. An event
+ * taken by any sink is copied out of the reader once, with
+ * `CandidateColumnWriter::Snapshot()`, and shared by the queues of the
+ * sinks that take it. A queue holds at most `buffer_events` events;
+ * the event loop waits for the slowest sink when it is full, which
+ * bounds the memory used.
+ *
+ * Predicates are called on the thread that calls `route()` or `run()`.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     OutputRouter router(true);
+ *     router.add_sink("train.col", OutputRouter::HashSplit(0.0, 0.8));
+ *     router.add_sink("test.col", OutputRouter::HashSplit(0.8, 0.9));
+ *     router.add_sink("validation.col", OutputRouter::HashSplit(0.9, 1.0));
+ *     router.add_sink("signal.col", [] (const BDtaunuReader &r) {
+ *       const auto &mc = static_cast<const BDtaunuMcReader&>(r);
+ *       return mc.get_b1_tau_mctype() != bdtaunu::TauMcType::NoTau
+ *           || mc.get_b2_tau_mctype() != bdtaunu::TauMcType::NoTau;
+ *     });
+ *
+ *     BDtaunuMcReader reader({"sp1235r1.root", "sp1235r2.root"});
+ *     router.run(reader);
+ *     router.close();
+ */
+class OutputRouter {
+
+  public:
+
+    //! Whether a sink takes the current event of a reader.
+    typedef std::function<bool(const BDtaunuReader&)> Predicate;
+
+    //! With `mc_labels`, readers must be BDtaunuMcReaders.
+    OutputRouter(bool mc_labels = false, Long64_t chunk_rows = 16384,
+                 size_t buffer_events = 4096);
+    OutputRouter(const OutputRouter&) = delete;
+    OutputRouter &operator=(const OutputRouter&) = delete;
+
+    //! Closes the sinks if `close()` was not called.
+    ~OutputRouter();
+
+    //! Write the events `keep` takes to `fname`; returns the index of the sink.
+    int add_sink(const std::string &fname, Predicate keep);
+
+    //! Same, as an event table and a candidate table; see CandidateColumnWriter.
+    int add_sink(const std::string &event_fname, const std::string &candidate_fname,
+                 Predicate keep);
+
+    //! Takes the events whose `HashFraction()` is in [lo, hi).
+    static Predicate HashSplit(double lo, double hi, std::uint64_t seed = 0);
+
+    //! Uniform number in [0, 1) fixed by `eventId` and `seed`.
+    static double HashFraction(const std::string &eventId, std::uint64_t seed = 0);
+
+    //! Offer the current event of `reader` to every sink.
+    void route(const BDtaunuReader &reader);
+
+    //! Route every event `reader` reads successfully until the end.
+    /*! Returns the number of events routed. */
+    Long64_t run(BDtaunuReader &reader);
+
+    //! Write out the queued events and close every sink.
+    void close();
+
+    size_t get_num_sinks() const { return sinks.size(); }
+
+    //! Number of events routed to sink `i`.
+    Long64_t get_num_events(int i) const { return sinks[i]->nevents; }
+
+  private:
+    struct Sink {
+      Predicate keep;
+      std::unique_ptr<CandidateColumnWriter> writer;
+      Long64_t nevents = 0;
+
+      // Events waiting for the writer thread.
+      std::deque<std::shared_ptr<const CandidateColumnWriter::Event>> queue;
+      bool closing = false;
+      std::mutex mutex;
+      std::condition_variable cv;
+      std::thread thread;
+    };
+
+    bool mc_labels;
+    Long64_t chunk_rows;
+    size_t buffer_events;
+    bool closed;
+    std::vector<std::unique_ptr<Sink>> sinks;
+
+    int AddSink(std::unique_ptr<CandidateColumnWriter> writer, Predicate keep);
+    void Drain(Sink *sink);
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include "ReaderStats.h"
+
+// LatencyHistogram
+// ----------------
+
+// 1-2-5 steps from 1 us to 1 s.
+double LatencyHistogram::upper_edge(int i) {
+  static const double mantissa[] = { 1, 2, 5 };
+  double decade = 1e-6;
+  for (int k = 0; k < i / 3; ++k) decade *= 10;
+  return decade * mantissa[i % 3];
+}
+
+void LatencyHistogram::add(double seconds) {
+  int i = 0;
+  while (i < n_buckets - 1 && seconds > upper_edge(i)) ++i;
+  ++counts[i];
+  ++n;
+  total += seconds;
+  max = std::max(max, seconds);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (int i = 0; i < n_buckets; ++i) counts[i] += other.counts[i];
+  n += other.n;
+  total += other.total;
+  max = std::max(max, other.max);
+}
+
+void LatencyHistogram::clear() {
+  std::fill(counts, counts + n_buckets, 0);
+  n = 0;
+  total = 0;
+  max = 0;
+}
+
+double LatencyHistogram::quantile(double q) const {
+  if (n == 0) return 0;
+  unsigned long long rank = static_cast<unsigned long long>(q * n);
+  if (rank >= n) rank = n - 1;
+  unsigned long long seen = 0;
+  for (int i = 0; i < n_buckets - 1; ++i) {
+    seen += counts[i];
+    if (seen > rank) return std::min(upper_edge(i), max);
+  }
+  return max;
+}
+
+
+// ReaderStats
+// -----------
+
+const char *ReaderStats::stage_name(Stage stage) {
+  static const char *names[] = {
+    "open_file", "get_entry",
+    "reco_construct_graph", "reco_analyze_graph", "fill_reco_info",
+    "mc_construct_graph", "mc_analyze_graph",
+    "truth_match_update_graph", "truth_match_contract_graph",
+    "truth_match_analyze_graph", "fill_mc_info",
+  };
+  return names[stage];
+}
+
+void ReaderStats::merge(const ReaderStats &other) {
+
+  // Efficiencies are averaged over the events of each reader.
+  unsigned long long n = events_read + other.events_read;
+  if (n > 0) {
+    cache_efficiency = (events_read * cache_efficiency + other.events_read * other.cache_efficiency) / n;
+  }
+
+  files_opened += other.files_opened;
+  events_read += other.events_read;
+  for (int i = 0; i < n_status; ++i) status_counts[i] += other.status_counts[i];
+  bytes_read += other.bytes_read;
+  reco_vertices += other.reco_vertices;
+  reco_edges += other.reco_edges;
+  mc_vertices += other.mc_vertices;
+  mc_edges += other.mc_edges;
+  truth_match_probes += other.truth_match_probes;
+  candidates += other.candidates;
+  cache_size = std::max(cache_size, other.cache_size);
+  cache_read_calls += other.cache_read_calls;
+  cache_bytes_read += other.cache_bytes_read;
+  uncached_read_calls += other.uncached_read_calls;
+  uncached_bytes_read += other.uncached_bytes_read;
+  for (int i = 0; i < kNStages; ++i) stage_latency[i].merge(other.stage_latency[i]);
+}
+
+void ReaderStats::clear() {
+  StageObserver *o = observer;
+  *this = ReaderStats();
+  observer = o;
+}
+
+// One line of counters, then one line per stage that ran.
+void ReaderStats::print(std::ostream &os) const {
+
+  if (!enabled) {
+    os << "reader statistics disabled at compile time" << std::endl;
+    return;
+  }
+
+  os << "files opened: " << files_opened;
+  os << ", events read: " << events_read;
+  os << ", bytes read: " << bytes_read;
+  os << ", status counts:";
+  for (int i = 0; i < n_status; ++i) os << " " << status_counts[i];
+  os << std::endl;
+
+  os << "reco vertices: " << reco_vertices << ", reco edges: " << reco_edges;
+  os << ", mc vertices: " << mc_vertices << ", mc edges: " << mc_edges;
+  os << ", truth match probes: " << truth_match_probes;
+  os << ", candidates: " << candidates << std::endl;
+
+  os << "cache size: " << cache_size;
+  os << ", cache reads: " << cache_read_calls << " (" << cache_bytes_read << " bytes)";
+  os << ", uncached reads: " << uncached_read_calls << " (" << uncached_bytes_read << " bytes)";
+  os << ", cache efficiency: " << cache_efficiency << std::endl;
+
+  os << std::left << std::setw(28) << "stage";
+  os << std::right << std::setw(10) << "calls";
+  os << std::setw(12) << "total(s)";
+  os << std::setw(12) << "p50(us)";
+  os << std::setw(12) << "p99(us)";
+  os << std::setw(12) << "max(us)" << std::endl;
+  for (int i = 0; i < kNStages; ++i) {
+    const LatencyHistogram &h = stage_latency[i];
+    if (h.get_count() == 0) continue;
+    os << std::left << std::setw(28) << stage_name(static_cast<Stage>(i));
+    os << std::right << std::setw(10) << h.get_count();
+    os << std::setw(12) << h.get_total_seconds();
+    os << std::setw(12) << 1e6 * h.quantile(0.50);
+    os << std::setw(12) << 1e6 * h.quantile(0.99);
+    os << std::setw(12) << 1e6 * h.get_max_seconds() << std::endl;
+  }
+}
@@ -0,0 +1,198 @@
+#ifndef __READERSTATS_H__
+#define __READERSTATS_H__
+
+#include <iostream>
+#include <chrono>
+
+/** @brief Fixed bucket latency histogram.
+ *
+ * @detail
+ * Buckets have fixed upper edges from 1 \f$\mu s\f$ to 1 s in 1-2-5
+ * steps, plus an overflow bucket, so histograms from different readers
+ * or jobs can always be merged by adding their counts.
+ */
+class LatencyHistogram {
+
+  public:
+
+    //! Number of buckets, including the overflow bucket.
+    static const int n_buckets = 20;
+
+    //! Upper edge of bucket `i` in seconds; the last bucket has no upper edge.
+    static double upper_edge(int i);
+
+    LatencyHistogram() { clear(); }
+
+    //! Count one sample.
+    void add(double seconds);
+
+    //! Add the counts of another histogram to this one.
+    void merge(const LatencyHistogram &other);
+
+    void clear();
+
+    //! Number of samples in bucket `i`.
+    unsigned long long get_bucket_count(int i) const { return counts[i]; }
+
+    //! Total number of samples.
+    unsigned long long get_count() const { return n; }
+
+    //! Sum of all samples in seconds.
+    double get_total_seconds() const { return total; }
+
+    //! Largest sample in seconds.
+    double get_max_seconds() const { return max; }
+
+    //! Upper bound on the `q` quantile, with `q` in [0, 1].
+    /*! Returns the upper edge of the bucket the quantile falls in, or the
+     * largest sample if it falls in the overflow bucket. */
+    double quantile(double q) const;
+
+  private:
+    unsigned long long counts[n_buckets];
+    unsigned long long n;
+    double total;
+    double max;
+};
+
+
+/** @brief Counters and stage timers of a reader.
+ *
+ * @detail
+ * RootReader and its subclasses fill one of these while they read; a
+ * copy is returned by `RootReader::stats()`. It records:
+ *
+ * * The latency of each stage of `next_record()` in a LatencyHistogram, 
+ *   including opening each file, or waiting for it at a file boundary. 
+ * * Files opened, events read, and the number of times each RootReader::Status was
+ *   returned, indexed by the integer value of the status.
+ * * Bytes read, as reported by `TTree::GetEntry()`.
+ * * Vertices and edges of the reco graphs and MC trees built.
+ * * Truth match probes: MC particles whose daughters were compared to a
+ *   reco candidate's in `TruthMatchDfsVisitor`.
+ * * \f$\Upsilon(4S)\f$ candidates emitted.
+ * * The TTreeCache: its size, the reads it issued, the reads that
+ *   missed it, and its hit efficiency. The counts are summed over the
+ *   files read; those of the open file's cache are added when the
+ *   snapshot is made. The efficiency is that of the open file.
+ *
+ * Compiling the library with `-DBDTAUNU_NO_STATS` (`make STATS=0`) turns
+ * `enabled` off; the timers and counters then compile to nothing and all
+ * statistics read zero. The class layout does not change. Code that
+ * includes this header must be compiled with the library's setting; the
+ * library build records it in `lib/stats.mk`, which the Makefiles in
+ * `tests/`, `tools/`, and `bench/` include.
+ */
+class ReaderStats {
+
+  public:
+
+#ifdef BDTAUNU_NO_STATS
+    static constexpr bool enabled = false;
+#else
+    static constexpr bool enabled = true;
+#endif
+
+    //! Stages of `next_record()`, in the order they run.
+    enum Stage {
+      kOpenFile, kGetEntry,
+      kRecoConstructGraph, kRecoAnalyzeGraph, kFillRecoInfo,
+      kMcConstructGraph, kMcAnalyzeGraph,
+      kTruthMatchUpdateGraph, kTruthMatchContractGraph, kTruthMatchAnalyzeGraph,
+      kFillMcInfo,
+      kNStages
+    };
+
+    //! Number of RootReader::Status values.
+    static const int n_status = 4;
+
+    //! snake_case name of a stage.
+    static const char *stage_name(Stage stage);
+
+    //! Told when each stage starts and stops.
+    /*! For measurements the timers do not take, e.g. hardware counters
+     * or heap usage per stage. Stages do not nest, so each
+     * `stage_started()` is followed by the `stage_stopped()` of the same
+     * stage. Called from the thread that reads, outside of the timed
+     * interval. */
+    class StageObserver {
+      public:
+        virtual ~StageObserver() {}
+        virtual void stage_started() = 0;
+        virtual void stage_stopped(Stage stage) = 0;
+    };
+
+    //! Observer of the stages timed from now on; null for none.
+    /*! Not owned. Kept by `clear()`, and not called when `enabled` is off. */
+    void set_observer(StageObserver *o) { observer = o; }
+
+    // Stage timers
+    // ------------
+
+#ifdef BDTAUNU_NO_STATS
+    struct Timestamp {};
+    Timestamp start() const { return Timestamp(); }
+    void stop(Stage, Timestamp) {}
+#else
+    typedef std::chrono::steady_clock::time_point Timestamp;
+
+    //! Start timing a stage.
+    Timestamp start() const {
+      if (observer) observer->stage_started();
+      return std::chrono::steady_clock::now();
+    }
+
+    //! Count the time since `t0` against `stage`.
+    void stop(Stage stage, Timestamp t0) {
+      stage_latency[stage].add(
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+      if (observer) observer->stage_stopped(stage);
+    }
+#endif
+
+    // Counters
+    // --------
+
+    unsigned long long files_opened = 0;
+    unsigned long long events_read = 0;
+    unsigned long long status_counts[n_status] = {};
+    unsigned long long bytes_read = 0;
+    unsigned long long reco_vertices = 0;
+    unsigned long long reco_edges = 0;
+    unsigned long long mc_vertices = 0;
+    unsigned long long mc_edges = 0;
+    unsigned long long truth_match_probes = 0;
+    unsigned long long candidates = 0;
+
+    unsigned long long cache_size = 0;
+    unsigned long long cache_read_calls = 0;     //!< reads issued by the cache
+    unsigned long long cache_bytes_read = 0;
+    unsigned long long uncached_read_calls = 0;  //!< reads that missed the cache
+    unsigned long long uncached_bytes_read = 0;
+    double cache_efficiency = 0;                 //!< fraction of basket reads served by the cache
+
+    LatencyHistogram stage_latency[kNStages];
+
+    //! Move one count from status `from` to status `to`.
+    /*! Used when a subclass overrides the status of its parent class. */
+    template <typename Status>
+    void change_status(Status from, Status to) {
+      if (enabled) {
+        --status_counts[static_cast<int>(from)];
+        ++status_counts[static_cast<int>(to)];
+      }
+    }
+
+    //! Add the statistics of another reader.
+    void merge(const ReaderStats &other);
+
+    void clear();
+
+    //! Print a human readable summary.
+    void print(std::ostream &os) const;
+
+  private:
+    StageObserver *observer = nullptr;
+};
+
+#endif
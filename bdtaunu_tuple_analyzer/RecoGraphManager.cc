@@ -14,10 +14,12 @@
 using namespace boost;
 using namespace RecoGraph;
 
-RecoGraphManager::RecoGraphManager() : reader(nullptr) { 
+RecoGraphManager::RecoGraphManager() : reader(nullptr), context(nullptr) { 
 }
 
-RecoGraphManager::RecoGraphManager(BDtaunuReader *_reader) : reader(_reader) { 
+RecoGraphManager::RecoGraphManager(
+    BDtaunuReader *_reader, const AnalysisContext &_context) : 
+  reader(_reader), context(&_context) { 
 }
 
 // Clear all cache.
@@ -111,7 +113,7 @@ void RecoGraphManager::print(std::ostream &os) const {
   auto lund_pm = get(vertex_lund_id, g);
   auto reco_pm = get(vertex_reco_index, g);
   BDtaunuGraphvizManager<Graph, decltype(lund_pm), decltype(reco_pm)> gv_manager(
-      g, lund_pm, reco_pm, BDtaunuReader::lund_to_name);
+      g, lund_pm, reco_pm, context->get_lund_to_name());
 
   gv_manager.set_title("Reco Graph");
   gv_manager.set_vertex_property({"color", "red"});
@@ -7,6 +7,7 @@
 
 #include "GraphDef.h"
 #include "GraphManager.h"
+#include "AnalysisContext.h"
 #include "RecoGraphVisitors.h"
 
 class BDtaunuReader;
@@ -113,8 +114,8 @@ class RecoGraphManager : public GraphManager {
 
     //! Constructor
     /*! Construction of an object should be associated with a 
-     * supervising `BDtaunuReader` object. */
-    RecoGraphManager(BDtaunuReader*);
+     * supervising `BDtaunuReader` object and the context it uses. */
+    RecoGraphManager(BDtaunuReader*, const AnalysisContext&);
     RecoGraphManager();
     RecoGraphManager(const RecoGraphManager&) = default;
     RecoGraphManager &operator=(const RecoGraphManager&) = default;
@@ -146,6 +147,9 @@ class RecoGraphManager : public GraphManager {
     // Supervising event reader class. 
     BDtaunuReader *reader;
 
+    // Shared tables. Owned by the reader. 
+    const AnalysisContext *context;
+
     // Cached BGL graph. 
     RecoGraph::Graph g;
 
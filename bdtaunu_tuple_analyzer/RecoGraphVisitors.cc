@@ -11,13 +11,12 @@ using namespace RecoGraph;
 using namespace bdtaunu;
 
 RecoGraphDfsVisitor::RecoGraphDfsVisitor(RecoGraphManager *_manager) 
-  : manager(_manager) {
+  : manager(_manager), 
+    recoD_catalogue(&manager->context->get_recoD_catalogue()) {
   lund_map = get(vertex_lund_id, manager->g);
   block_idx_map = get(vertex_block_index, manager->g);
 }
 
-const RecoDTypeCatalogue RecoGraphDfsVisitor::recoD_catalogue = RecoDTypeCatalogue();
-
 // Determine whether to analyze a reco particle 
 // when its vertex is colored black. 
 void RecoGraphDfsVisitor::finish_vertex(Vertex u, const Graph &g) {
@@ -65,7 +64,7 @@ void RecoGraphDfsVisitor::AnalyzeD(const Vertex &u, const Graph &g) {
   for (tie(ai, ai_end) = adjacent_vertices(u, g); ai != ai_end; ++ai) {
     lund_list.push_back(get(lund_map, *ai));
   }
-  recoD.D_mode = recoD_catalogue.search_d_catalogue(lund_list);
+  recoD.D_mode = recoD_catalogue->search_d_catalogue(lund_list);
 
   // Insert results into supervisor's cache. 
   (manager->D_map).insert(std::make_pair(u, recoD));
@@ -104,7 +103,7 @@ void RecoGraphDfsVisitor::AnalyzeDstar(const Vertex &u, const Graph &g) {
         return;
     }
   }
-  recoD.Dstar_mode = recoD_catalogue.search_dstar_catalogue(lund_list);
+  recoD.Dstar_mode = recoD_catalogue->search_dstar_catalogue(lund_list);
 
   // Insert results into supervisor's cache. 
   (manager->D_map).insert(std::make_pair(u, recoD));
@@ -53,11 +53,9 @@ class RecoGraphDfsVisitor : public boost::default_dfs_visitor {
 
     void finish_vertex(RecoGraph::Vertex u, const RecoGraph::Graph &g);
 
-  private:
-    static const bdtaunu::RecoDTypeCatalogue recoD_catalogue;
-
   private:
     RecoGraphManager *manager = nullptr;
+    const bdtaunu::RecoDTypeCatalogue *recoD_catalogue = nullptr;
     RecoGraph::LundIdPropertyMap lund_map;
     RecoGraph::BlockIndexPropertyMap block_idx_map;
 
@@ -0,0 +1,269 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TUUID.h>
+
+#include "BDtaunuDef.h"
+#include "AnalysisContext.h"
+#include "ResultCache.h"
+
+const int ResultCache::algorithm_version = 1;
+
+namespace {
+
+// Process wide default cache.
+std::mutex default_mutex;
+bool default_set = false;
+std::shared_ptr<ResultCache> default_cache;
+
+const char magic[8] = { 'B', 'D', 'T', 'R', 'C', '0', '0', '2' };
+
+// 64 bit FNV-1a; stable across compilers and runs, unlike std::hash.
+unsigned long long Fnv1a(const std::string &s) {
+  unsigned long long h = 14695981039346656037ULL;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// Parse the decay strings written by DecayDictionary::write().
+bool ReadDecays(const std::string &text, DecayDictionary &decays) {
+  std::istringstream is(text);
+  std::string line;
+  while (std::getline(is, line)) {
+    std::size_t tab = line.find('\t');
+    if (tab != 16) return false;
+    char *end = nullptr;
+    DecayDictionary::Signature s = std::strtoull(line.c_str(), &end, 16);
+    if (end != line.c_str() + tab) return false;
+    decays.insert(s, line.substr(tab + 1));
+  }
+  return true;
+}
+
+}
+
+// Tables are read and written as they are laid out in memory.
+static_assert(sizeof(ResultCache::Event) == 56, "ResultCache::Event layout changed");
+static_assert(sizeof(ResultCache::Candidate) == 33 * 4, "ResultCache::Candidate layout changed");
+
+ResultCache::ResultCache(const std::string &_cache_dir) :
+  cache_dir(_cache_dir), hits(0), misses(0) {
+  if (mkdir(cache_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    std::cerr << "ResultCache: cannot create " << cache_dir << ": ";
+    std::cerr << std::strerror(errno) << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+std::string ResultCache::Key(TTree *tr, int mode, int signature_depth, const AnalysisContext &context) {
+
+  TFile *f = tr->GetCurrentFile();
+  if (!f) return "";
+
+  std::string pdt;
+  for (const auto &p : context.get_lund_to_name()) {
+    pdt += std::to_string(p.first) + " " + p.second + "\n";
+  }
+
+  std::ostringstream key;
+  key << "uuid " << f->GetUUID().AsString();
+  key << " size " << f->GetSize();
+  key << " tree " << tr->GetName();
+  key << " entries " << tr->GetEntries();
+  key << " totbytes " << tr->GetTotBytes();
+  key << " zipbytes " << tr->GetZipBytes();
+  key << " mode " << mode;
+  key << " depth " << signature_depth;
+  key << " algorithm " << algorithm_version;
+  key << " catalogue " << AnalysisContext::catalogue_version;
+  key << " pdt " << std::hex << Fnv1a(pdt);
+  return key.str();
+}
+
+std::string ResultCache::Path(const std::string &key) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bdrc", Fnv1a(key));
+  return cache_dir + "/" + name;
+}
+
+std::shared_ptr<const ResultCache::Table> ResultCache::load(const std::string &key) {
+
+  std::string path = Path(key);
+  std::ifstream is(path, std::ios::binary);
+  char m[sizeof(magic)];
+  std::uint64_t sizes[4];
+  std::string stored_key;
+
+  // The sizes must add up to the file size before anything is allocated.
+  struct stat st;
+  bool found = is.read(m, sizeof(m)) && std::memcmp(m, magic, sizeof(m)) == 0
+            && is.read(reinterpret_cast<char*>(sizes), sizeof(sizes))
+            && stat(path.c_str(), &st) == 0
+            && sizes[0] < static_cast<std::uint64_t>(st.st_size)
+            && sizes[1] < static_cast<std::uint64_t>(st.st_size)
+            && sizes[2] < static_cast<std::uint64_t>(st.st_size)
+            && sizes[3] < static_cast<std::uint64_t>(st.st_size)
+            && static_cast<std::uint64_t>(st.st_size) == sizeof(magic) + sizeof(sizes)
+               + sizes[0] + sizes[1] * sizeof(Event) + sizes[2] * sizeof(Candidate) + sizes[3];
+  if (found) {
+    stored_key.resize(sizes[0]);
+    found = is.read(&stored_key[0], sizes[0]) && stored_key == key;
+  }
+
+  std::shared_ptr<Table> table;
+  if (found) {
+    table = std::make_shared<Table>();
+    table->events.resize(sizes[1]);
+    table->candidates.resize(sizes[2]);
+    found = is.read(reinterpret_cast<char*>(table->events.data()), sizes[1] * sizeof(Event))
+         && is.read(reinterpret_cast<char*>(table->candidates.data()), sizes[2] * sizeof(Candidate));
+  }
+  if (found) {
+    std::string decays(sizes[3], '\0');
+    found = is.read(&decays[0], sizes[3]) && ReadDecays(decays, table->decays);
+  }
+
+  if (!found) {
+    ++misses;
+    return nullptr;
+  }
+  ++hits;
+  return table;
+}
+
+void ResultCache::store(const std::string &key, const Table &table) {
+
+  std::string path = Path(key);
+  std::string tmp = path + ".tmp." + std::to_string(getpid());
+  std::ostringstream decays;
+  table.decays.write(decays);
+  std::uint64_t sizes[4] = { key.size(), table.events.size(), table.candidates.size(),
+                             decays.str().size() };
+
+  std::ofstream os(tmp, std::ios::binary);
+  os.write(magic, sizeof(magic));
+  os.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+  os.write(key.data(), key.size());
+  os.write(reinterpret_cast<const char*>(table.events.data()), table.events.size() * sizeof(Event));
+  os.write(reinterpret_cast<const char*>(table.candidates.data()),
+           table.candidates.size() * sizeof(Candidate));
+  os << decays.str();
+  os.close();
+
+  // A table that cannot be written is recomputed next time.
+  if (!os || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::cerr << "ResultCache: cannot write " << path << std::endl;
+    std::remove(tmp.c_str());
+  }
+}
+
+ResultCache::Candidate ResultCache::Pack(const UpsilonCandidate &cand) {
+  Candidate c;
+  c.block_index = cand.get_block_index();
+  c.reco_index = cand.get_reco_index();
+  c.truth_match = cand.get_truth_match();
+  c.bflavor = static_cast<int>(cand.get_bflavor());
+  c.eextra50 = cand.get_eextra50();
+  c.mmiss_prime2 = cand.get_mmiss_prime2();
+  c.cosThetaT = cand.get_cosThetaT();
+  c.tag_lp3 = cand.get_tag_lp3();
+  c.tag_cosBY = cand.get_tag_cosBY();
+  c.tag_cosThetaDl = cand.get_tag_cosThetaDl();
+  c.tag_Dmass = cand.get_tag_Dmass();
+  c.tag_deltaM = cand.get_tag_deltaM();
+  c.tag_cosThetaDSoft = cand.get_tag_cosThetaDSoft();
+  c.tag_softP3MagCM = cand.get_tag_softP3MagCM();
+  c.tag_d_mode = static_cast<int>(cand.get_tag_d_mode());
+  c.tag_dstar_mode = static_cast<int>(cand.get_tag_dstar_mode());
+  c.l_ePidMap = cand.get_l_ePidMap();
+  c.l_muPidMap = cand.get_l_muPidMap();
+  c.sig_hp3 = cand.get_sig_hp3();
+  c.sig_cosBY = cand.get_sig_cosBY();
+  c.sig_cosThetaDtau = cand.get_sig_cosThetaDtau();
+  c.sig_vtxB = cand.get_sig_vtxB();
+  c.sig_Dmass = cand.get_sig_Dmass();
+  c.sig_deltaM = cand.get_sig_deltaM();
+  c.sig_cosThetaDSoft = cand.get_sig_cosThetaDSoft();
+  c.sig_softP3MagCM = cand.get_sig_softP3MagCM();
+  c.sig_hmass = cand.get_sig_hmass();
+  c.sig_vtxh = cand.get_sig_vtxh();
+  c.sig_d_mode = static_cast<int>(cand.get_sig_d_mode());
+  c.sig_dstar_mode = static_cast<int>(cand.get_sig_dstar_mode());
+  c.sig_tau_mode = static_cast<int>(cand.get_sig_tau_mode());
+  c.h_ePidMap = cand.get_h_ePidMap();
+  c.h_muPidMap = cand.get_h_muPidMap();
+  return c;
+}
+
+UpsilonCandidate ResultCache::Unpack(const Candidate &c, const std::string &eventId) {
+  using namespace bdtaunu;
+  UpsilonCandidate cand;
+  cand.set_eventId(eventId);
+  cand.set_block_index(c.block_index);
+  cand.set_reco_index(c.reco_index);
+  cand.set_truth_match(c.truth_match);
+  cand.set_bflavor(static_cast<BFlavor>(c.bflavor));
+  cand.set_eextra50(c.eextra50);
+  cand.set_mmiss_prime2(c.mmiss_prime2);
+  cand.set_cosThetaT(c.cosThetaT);
+  cand.set_tag_lp3(c.tag_lp3);
+  cand.set_tag_cosBY(c.tag_cosBY);
+  cand.set_tag_cosThetaDl(c.tag_cosThetaDl);
+  cand.set_tag_Dmass(c.tag_Dmass);
+  cand.set_tag_deltaM(c.tag_deltaM);
+  cand.set_tag_cosThetaDSoft(c.tag_cosThetaDSoft);
+  cand.set_tag_softP3MagCM(c.tag_softP3MagCM);
+  cand.set_tag_d_mode(static_cast<RecoDTypeCatalogue::DType>(c.tag_d_mode));
+  cand.set_tag_dstar_mode(static_cast<RecoDTypeCatalogue::DstarType>(c.tag_dstar_mode));
+  cand.set_l_ePidMap(c.l_ePidMap);
+  cand.set_l_muPidMap(c.l_muPidMap);
+  cand.set_sig_hp3(c.sig_hp3);
+  cand.set_sig_cosBY(c.sig_cosBY);
+  cand.set_sig_cosThetaDtau(c.sig_cosThetaDtau);
+  cand.set_sig_vtxB(c.sig_vtxB);
+  cand.set_sig_Dmass(c.sig_Dmass);
+  cand.set_sig_deltaM(c.sig_deltaM);
+  cand.set_sig_cosThetaDSoft(c.sig_cosThetaDSoft);
+  cand.set_sig_softP3MagCM(c.sig_softP3MagCM);
+  cand.set_sig_hmass(c.sig_hmass);
+  cand.set_sig_vtxh(c.sig_vtxh);
+  cand.set_sig_d_mode(static_cast<RecoDTypeCatalogue::DType>(c.sig_d_mode));
+  cand.set_sig_dstar_mode(static_cast<RecoDTypeCatalogue::DstarType>(c.sig_dstar_mode));
+  cand.set_sig_tau_mode(static_cast<TauType>(c.sig_tau_mode));
+  cand.set_h_ePidMap(c.h_ePidMap);
+  cand.set_h_muPidMap(c.h_muPidMap);
+  return cand;
+}
+
+std::shared_ptr<ResultCache> ResultCache::Default() {
+  std::lock_guard<std::mutex> lock(default_mutex);
+  if (!default_set) {
+    default_set = true;
+    const char *dir = std::getenv("BDTAUNU_RESULT_CACHE_DIR");
+    if (dir && *dir) default_cache = std::make_shared<ResultCache>(dir);
+  }
+  return default_cache;
+}
+
+void ResultCache::SetDefault(std::shared_ptr<ResultCache> cache) {
+  std::lock_guard<std::mutex> lock(default_mutex);
+  default_set = true;
+  default_cache = cache;
+}
@@ -0,0 +1,147 @@
+#ifndef __RESULTCACHE_H__
+#define __RESULTCACHE_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#include <Rtypes.h>
+
+#include "UpsilonCandidate.h"
+#include "DecayDictionary.h"
+
+class TTree;
+class AnalysisContext;
+
+/** @brief Derived results of whole input files, kept across runs.
+ *
+ * @detail
+ * # Purpose
+ * The reco graph, the MC graph, and truth matching give the same
+ * results for the same input every time they are run. BDtaunuMcReader
+ * stores, for every entry of a file it reads from start to end, the
+ * \f$\Upsilon(4S)\f$ candidates and the MC labels it derived. Later
+ * readers of the same file serve them from here, and skip building and
+ * analyzing the graphs.
+ *
+ * # Invalidation
+ * A table is keyed by:
+ * * The input: the UUID ROOT gives every file when it is created, its
+ *   size, and the entries and byte counts of the tree. Hashing the
+ *   contents would mean reading all of it, which is what the cache
+ *   avoids.
+ * * The reader mode and signature depth.
+ * * `algorithm_version`, to be bumped with any change to
+ *   RecoGraphManager, McGraphManager, TruthMatchManager, or the
+ *   derivation of UpsilonCandidate that changes results.
+ * * A fingerprint of the AnalysisContext: the particle data table and
+ *   AnalysisContext::catalogue_version.
+ *
+ * Tables of any other key are never read; they are simply left behind.
+ *
+ * # What is not cached
+ * On a hit the graphs are not built, so the graph printers and the
+ * truth map of the reader do not describe the event. The decay strings
+ * of the signatures are stored with the table, and are added to the
+ * reader's decay dictionary as each event is served. Everything read
+ * directly from the tree is unaffected.
+ *
+ * # Format
+ * One binary file per table, `<hash of key>.bdrc`, written to a
+ * temporary name and renamed into place. The file starts with the full
+ * key, which is checked on load. Any number of processes may share a
+ * cache directory.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     ResultCache::SetDefault(std::make_shared<ResultCache>("/scratch/results"));
+ *     BDtaunuMcReader reader("sp1235r1.root");  // fills, then uses, the cache
+ *
+ * The default can also be set with the environment variable
+ * `BDTAUNU_RESULT_CACHE_DIR`.
+ */
+class ResultCache {
+
+  public:
+
+    //! Version of the algorithms whose results are cached.
+    static const int algorithm_version;
+
+    //! Derived results of one entry.
+    struct Event {
+      std::uint64_t b1_signature, b2_signature;
+      std::int64_t first_candidate;      //!< index into `candidates`
+      std::int32_t status;               //!< RootReader::Status
+      std::int32_t continuum;
+      std::int32_t b1_mctype, b2_mctype;
+      std::int32_t b1_tau_mctype, b2_tau_mctype;
+      std::int32_t ncandidates;
+      std::int32_t unused;
+    };
+
+    //! An UpsilonCandidate without its event Id.
+    struct Candidate {
+      std::int32_t block_index, reco_index, truth_match, bflavor;
+      float eextra50, mmiss_prime2, cosThetaT;
+      float tag_lp3, tag_cosBY, tag_cosThetaDl, tag_Dmass, tag_deltaM;
+      float tag_cosThetaDSoft, tag_softP3MagCM;
+      std::int32_t tag_d_mode, tag_dstar_mode, l_ePidMap, l_muPidMap;
+      float sig_hp3, sig_cosBY, sig_cosThetaDtau, sig_vtxB, sig_Dmass;
+      float sig_deltaM, sig_cosThetaDSoft, sig_softP3MagCM, sig_hmass, sig_vtxh;
+      std::int32_t sig_d_mode, sig_dstar_mode, sig_tau_mode, h_ePidMap, h_muPidMap;
+    };
+
+    //! Results of every entry of one tree.
+    struct Table {
+      std::vector<Event> events;           //!< one per entry
+      std::vector<Candidate> candidates;
+      DecayDictionary decays;              //!< decay strings of the signatures of `events`
+    };
+
+    ResultCache() = delete;
+    ResultCache(const std::string &cache_dir);
+    ResultCache(const ResultCache&) = delete;
+    ResultCache &operator=(const ResultCache&) = delete;
+    ~ResultCache() {};
+
+    //! Key of the results of `tr` derived in reader mode `mode` with
+    //! decay chain signatures `signature_depth` generations deep.
+    /*! Empty if `tr` is not read from a file. */
+    static std::string Key(TTree *tr, int mode, int signature_depth, const AnalysisContext &context);
+
+    //! Table stored under `key`, or null.
+    std::shared_ptr<const Table> load(const std::string &key);
+
+    //! Store a table under `key`.
+    void store(const std::string &key, const Table &table);
+
+    static Candidate Pack(const UpsilonCandidate &cand);
+    static UpsilonCandidate Unpack(const Candidate &c, const std::string &eventId);
+
+    const std::string &get_cache_dir() const { return cache_dir; }
+
+    //! Number of `load()` calls that found a table.
+    unsigned long long get_hits() const { return hits; }
+
+    //! Number of `load()` calls that did not.
+    unsigned long long get_misses() const { return misses; }
+
+    //! Cache used by BDtaunuMcReader; null unless set.
+    /*! Built from the environment on first use if not set. */
+    static std::shared_ptr<ResultCache> Default();
+
+    //! Set the cache used by BDtaunuMcReader; null turns caching off.
+    static void SetDefault(std::shared_ptr<ResultCache> cache);
+
+  private:
+    std::string cache_dir;
+    std::atomic<unsigned long long> hits;
+    std::atomic<unsigned long long> misses;
+
+    std::string Path(const std::string &key) const;
+};
+
+#endif
@@ -1,17 +1,41 @@
 #include <TFile.h>
+#include <TTree.h>
+#include <TTreeCache.h>
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
 
 #include "RootReader.h"
 
+// Bounds of the automatic TTreeCache size. 
+const Long64_t RootReader::min_cache_size = 1 << 20;
+const Long64_t RootReader::max_cache_size = 256 << 20;
+
 RootReader::RootReader(
   const char *root_fname, 
   const char *root_trname) : 
-  tfile(nullptr), tr(nullptr), record_index(0) {
+  tfile(nullptr), tr(nullptr), 
+  root_fnames(1, root_fname), root_trname(root_trname), record_index(0) {
   PrepareTreeFile(root_fname, root_trname);
 }
 
+RootReader::RootReader(
+  const std::vector<std::string> &_root_fnames, 
+  const char *root_trname) : 
+  tfile(nullptr), tr(nullptr), 
+  root_fnames(_root_fnames), root_trname(root_trname), record_index(0) {
+  if (root_fnames.empty()) {
+    std::cerr << "RootReader: no input files." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  PrepareTreeFile(root_fnames[0].c_str(), root_trname);
+}
+
 RootReader::~RootReader() {
+  prefetcher.reset();
+  io_profile.reset();
   if (tfile != 0) { 
     tfile->Close();
     delete tfile;
@@ -22,19 +46,15 @@ RootReader::~RootReader() {
 void RootReader::PrepareTreeFile(const char *root_fname, 
                                  const char *root_trname) {
 
-  tfile = new TFile(root_fname, "r");
-  if (tfile->IsZombie()) {
-    std::cerr << "TFile* associated to \"" << root_fname;
-    std::cerr << "\" is invalid." << std::endl;
-    exit(EXIT_FAILURE);
-  }
-
-  tr = (TTree*) tfile->Get(root_trname);
-  if (!tr) {
-    std::cerr << "no TTree with name \"" << root_trname;
-    std::cerr << "\" in " << root_fname << std::endl;
+  ReaderStats::Timestamp t0 = reader_stats.start();
+  lease = FilePrefetcher::Stage(root_fname);
+  std::string error = FilePrefetcher::OpenTree(lease.get_path(), root_trname, tfile, tr);
+  if (!error.empty()) {
+    std::cerr << error << std::endl;
     exit(EXIT_FAILURE);
   }
+  reader_stats.stop(ReaderStats::kOpenFile, t0);
+  if (ReaderStats::enabled) ++reader_stats.files_opened;
 
   record_index = 0;
   total_records = tr->GetEntries();
@@ -42,10 +62,208 @@ void RootReader::PrepareTreeFile(const char *root_fname,
 
 // Read in the next event from the TTree. 
 RootReader::Status RootReader::next_record() {
+
+  // Start preparing the next files once the settings are final. 
+  if (!started) {
+    started = true;
+    if (file_index + 1 < root_fnames.size() && prefetch_files > 0) {
+      prefetcher.reset(new FilePrefetcher(root_fnames, root_trname, file_index + 1, 
+                                          prefetch_files, prefetch_bytes));
+    }
+  }
+
+  while (record_index >= total_records && NextFile()) {}
+  if (!cache_configured) ConfigureCache();
+
+  Status status;
   if (record_index < total_records) {
-    tr->GetEntry(record_index++);
-    return Status::kReadSucceeded;
+    ReaderStats::Timestamp t0 = reader_stats.start();
+    int nbytes = io_profile ? io_profile->read_entry(record_index++) 
+                            : tr->GetEntry(record_index++);
+    reader_stats.stop(ReaderStats::kGetEntry, t0);
+    if (ReaderStats::enabled) {
+      ++reader_stats.events_read;
+      if (nbytes > 0) reader_stats.bytes_read += nbytes;
+    }
+    status = Status::kReadSucceeded;
+  } else {
+    status = Status::kEOF;
+  }
+  if (ReaderStats::enabled) ++reader_stats.status_counts[static_cast<int>(status)];
+  return status;
+}
+
+void RootReader::enable_io_profile() {
+  if (!io_profile) io_profile.reset(new BranchIoProfile());
+  io_profile->attach(tr);
+}
+
+void RootReader::set_prefetch_window(int nfiles, Long64_t nbytes) {
+  prefetch_files = nfiles;
+  prefetch_bytes = nbytes;
+}
+
+// Switch to the next file. Returns false after the last file. 
+bool RootReader::NextFile() {
+  if (file_index + 1 >= root_fnames.size()) return false;
+  SwitchFile(file_index + 1);
+  return true;
+}
+
+// Switch to the tree of file `i` and bind it like the current one. 
+void RootReader::SwitchFile(size_t i) {
+
+  // The prefetcher only prepares files in order. 
+  if (i != file_index + 1 && prefetcher) {
+    prefetcher.reset();
+    started = false;
+  }
+  file_index = i;
+
+  ReaderStats::Timestamp t0 = reader_stats.start();
+
+  TFile *next_tfile = nullptr;
+  TTree *next_tr = nullptr;
+  StagingCache::Lease next_lease;
+  std::string error;
+  if (prefetcher) {
+    error = prefetcher->take(file_index, next_tfile, next_tr, next_lease);
   } else {
-    return Status::kEOF;
+    next_lease = FilePrefetcher::Stage(root_fnames[file_index]);
+    error = FilePrefetcher::OpenTree(next_lease.get_path(), root_trname, next_tfile, next_tr);
+  }
+  if (!error.empty()) {
+    std::cerr << error << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  TObjArray *branches = tr->GetListOfBranches();
+  for (int i = 0; branches && i < branches->GetEntriesFast(); ++i) {
+    TBranch *b = static_cast<TBranch*>(branches->At(i));
+    next_tr->SetBranchStatus(b->GetName(), tr->GetBranchStatus(b->GetName()));
+    if (b->GetAddress()) next_tr->SetBranchAddress(b->GetName(), static_cast<void*>(b->GetAddress()));
   }
+
+  // The profile carries on across files. 
+  if (io_profile) {
+    std::unique_ptr<BranchIoProfile> next_profile(new BranchIoProfile());
+    io_profile->detach();
+    next_profile->attach(next_tr);
+    next_profile->merge(*io_profile);
+    io_profile = std::move(next_profile);
+  }
+
+  // The cache goes with the old file, so keep what it read. 
+  if (ReaderStats::enabled) {
+    AddCacheStats(reader_stats);
+    cache_baseline = ReaderStats();
+  }
+
+  tfile->Close();
+  delete tfile;
+  tfile = next_tfile;
+  tr = next_tr;
+  lease = std::move(next_lease);
+
+  record_index = 0;
+  total_records = tr->GetEntries();
+  cache_configured = false;
+
+  reader_stats.stop(ReaderStats::kOpenFile, t0);
+  if (ReaderStats::enabled) ++reader_stats.files_opened;
+}
+
+bool RootReader::SeekEntry(const std::string &root_fname, Long64_t entry) {
+  auto it = std::find(root_fnames.begin(), root_fnames.end(), root_fname);
+  if (it == root_fnames.end()) return false;
+
+  size_t i = it - root_fnames.begin();
+  if (i != file_index) SwitchFile(i);
+
+  total_records = tr->GetEntries();
+  if (entry < 0 || entry >= total_records) return false;
+  record_index = entry;
+  return true;
+}
+
+void RootReader::set_entry_range(Long64_t first, Long64_t last) {
+  Long64_t nentries = tr->GetEntries();
+  record_index = std::max(0LL, std::min(first, nentries));
+  total_records = std::max(record_index, std::min(last, nentries));
+}
+
+// Size the cache and register the bound branches with it. Called 
+// before the first record is read, once the subclasses have bound 
+// their branches. 
+void RootReader::ConfigureCache() {
+
+  cache_configured = true;
+  if (cache_size < 0) return;
+
+  std::vector<TBranch*> bound;
+  TObjArray *branches = tr->GetListOfBranches();
+  for (int i = 0; branches && i < branches->GetEntriesFast(); ++i) {
+    TBranch *b = static_cast<TBranch*>(branches->At(i));
+    if (tr->GetBranchStatus(b->GetName()) && b->GetAddress()) bound.push_back(b);
+  }
+
+  // One basket of every bound branch, which is what a cluster of a 
+  // tree written with the default auto flush holds. 
+  Long64_t size = cache_size;
+  if (size == 0) {
+    for (auto b : bound) size += b->GetBasketSize();
+    size = std::max(min_cache_size, std::min(max_cache_size, size));
+  }
+
+  tr->SetCacheSize(size);
+  for (auto b : bound) tr->AddBranchToCache(b->GetName(), true);
+  tr->StopCacheLearningPhase();
+
+  // Widen the entry range to whole clusters. 
+  Long64_t nentries = tr->GetEntries();
+  if (record_index > 0 || total_records < nentries) {
+    TTree::TClusterIterator clusters = tr->GetClusterIterator(record_index);
+    Long64_t start = clusters.Next();
+    Long64_t end = clusters.GetNextEntry();
+    while (end < total_records) {
+      clusters.Next();
+      Long64_t next = clusters.GetNextEntry();
+      if (next <= end) break;
+      end = next;
+    }
+    tr->SetCacheEntryRange(start, std::min(std::max(end, total_records), nentries));
+  }
+}
+
+ReaderStats RootReader::stats() const {
+  ReaderStats snapshot = reader_stats;
+  snapshot.set_observer(nullptr);
+  if (ReaderStats::enabled) AddCacheStats(snapshot);
+  return snapshot;
+}
+
+// Add the counters of the current file's cache since the last 
+// clear_stats() to `s`. Those of earlier files are already in 
+// reader_stats. 
+void RootReader::AddCacheStats(ReaderStats &s) const {
+  TTreeCache *cache = dynamic_cast<TTreeCache*>(tfile->GetCacheRead(tr));
+  if (!cache) return;
+  s.cache_size = std::max(s.cache_size, static_cast<unsigned long long>(cache->GetBufferSize()));
+  s.cache_read_calls += cache->GetReadCalls() - cache_baseline.cache_read_calls;
+  s.cache_bytes_read += cache->GetBytesRead() - cache_baseline.cache_bytes_read;
+  s.uncached_read_calls += cache->GetNoCacheReadCalls() - cache_baseline.uncached_read_calls;
+  s.uncached_bytes_read += cache->GetNoCacheBytesRead() - cache_baseline.uncached_bytes_read;
+  s.cache_efficiency = cache->GetEfficiency();
+}
+
+// The cache counts from when the file was opened, so keep its counters 
+// to subtract them later. 
+void RootReader::clear_stats() {
+  ReaderStats s;
+  AddCacheStats(s);
+  cache_baseline.cache_read_calls += s.cache_read_calls;
+  cache_baseline.cache_bytes_read += s.cache_bytes_read;
+  cache_baseline.uncached_read_calls += s.uncached_read_calls;
+  cache_baseline.uncached_bytes_read += s.uncached_bytes_read;
+  reader_stats.clear();
 }
@@ -1,15 +1,47 @@
 #ifndef __ROOTREADER_H__
 #define __ROOTREADER_H__
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <TFile.h>
 #include <TTree.h>
 
+#include "ReaderStats.h"
+#include "BranchIoProfile.h"
+#include "FilePrefetcher.h"
+
 //! Abstract base class that opens a TFile and gets a TTree. 
 /*! This class is responsible for opening and closing a TFile, and it
  * also owns the pointer to the TTree from which we would like to read
  * from. 
  *
- * It supports single pass iteration of events in the TTree. */
+ * It supports single pass iteration of events in the TTree, or in a 
+ * range of entries of it; see `set_entry_range()`. 
+ *
+ * Constructed with a list of files, it reads the TTree of each in turn. 
+ * The branch addresses and statuses set on the first tree are carried 
+ * over to the next. While a file is read, a FilePrefetcher warms and 
+ * opens the files after it; see `set_prefetch_window()`. 
+ *
+ * When a default StagingCache is set, every file is copied to local 
+ * storage, or found there, before it is opened. 
+ *
+ * Before the first record is read, the TTreeCache is sized and loaded 
+ * with exactly the branches the reader bound, so ROOT skips its 
+ * learning phase and fetches those baskets in a few large reads. With 
+ * an entry range, the cache range is widened to cluster boundaries so 
+ * that no basket at either end is fetched on its own. See 
+ * `set_cache_size()`. 
+ *
+ * Subclasses can jump to a given entry of any of their files with 
+ * `SeekEntry()`; BDtaunuReader uses it to seek events by Id. 
+ *
+ * Readers count what they do in a ReaderStats; see `stats()`. 
+ *
+ * `enable_io_profile()` additionally times the read of each branch; 
+ * see BranchIoProfile. */
 class RootReader {
 
   public:
@@ -27,22 +59,98 @@ class RootReader {
 
     //! Constructor with specified root file name and TTree name. 
     RootReader(const char *root_fname, const char *root_trname = "ntp1");
+
+    //! Read the TTree root_trname of each file in turn. 
+    RootReader(const std::vector<std::string> &root_fnames, const char *root_trname = "ntp1");
     virtual ~RootReader();
 
     //! Read in the next event from the TTree. 
     virtual Status next_record();
 
+    //! Size of the TTreeCache in bytes. 
+    /*! 0, the default, sizes it from the baskets of the bound branches; 
+     * a negative size leaves the cache to ROOT. Call before the first 
+     * record is read. */
+    void set_cache_size(Long64_t bytes) { cache_size = bytes; }
+
+    //! Only read entries `first` to `last - 1`. 
+    /*! Call before the first record is read. With several files, the 
+     * range applies to the first file only. */
+    void set_entry_range(Long64_t first, Long64_t last);
+
+    //! Prepare up to `nfiles` files, and `nbytes` of page cache, ahead. 
+    /*! Defaults to one file and 256 MB; 0 files turns prefetching off. 
+     * Call before the first record is read. */
+    void set_prefetch_window(int nfiles, Long64_t nbytes);
+
+    //! Index of the current file in the list the reader was constructed with. 
+    size_t get_file_index() const { return file_index; }
+
+    //! Entry of the current tree that was read last. 
+    Long64_t get_current_entry() const { return record_index - 1; }
+
+    //! Snapshot of the timers and counters of this reader. 
+    ReaderStats stats() const;
+
+    //! Reset the timers and counters. 
+    void clear_stats();
+
+    //! Tell `o` when each stage of `next_record()` starts and stops. 
+    /*! See ReaderStats::StageObserver. Null turns it off. */
+    void set_stage_observer(ReaderStats::StageObserver *o) { reader_stats.set_observer(o); }
+
+    //! Profile the read cost of each branch from the next record on. 
+    /*! Call after construction, once the branches are bound. */
+    void enable_io_profile();
+
+    //! Branch read costs so far; null unless profiling is enabled. 
+    const BranchIoProfile *get_io_profile() const { return io_profile.get(); }
+
   private:
     TFile *tfile = nullptr;
 
   protected: 
     TTree *tr = nullptr;
+    ReaderStats reader_stats;
+
+    //! Make `entry` of `root_fname` the next record read. 
+    /*! `root_fname` must be one of the files the reader was constructed 
+     * with. Reading carries on from there to the end of the file, 
+     * ignoring any entry range, and then through the files after it. 
+     * Returns false if the file or entry is not found. */
+    bool SeekEntry(const std::string &root_fname, Long64_t entry);
 
   private: 
-    int record_index = 0;
-    int total_records = 0;
+    static const Long64_t min_cache_size;
+    static const Long64_t max_cache_size;
+
+    std::vector<std::string> root_fnames;
+    std::string root_trname;
+    size_t file_index = 0;
+    int prefetch_files = 1;
+    Long64_t prefetch_bytes = 256 << 20;
+    bool started = false;
+    std::unique_ptr<FilePrefetcher> prefetcher;
+
+    // Staged copy of the current file, if any; released after the file 
+    // is closed. 
+    StagingCache::Lease lease;
+
+    Long64_t record_index = 0;
+    Long64_t total_records = 0;
+    Long64_t cache_size = 0;
+    bool cache_configured = false;
+    std::unique_ptr<BranchIoProfile> io_profile;
+
+    // Counters of the current file's cache at the last clear_stats(); 
+    // zero if it was not cleared since the file was opened. 
+    ReaderStats cache_baseline;
+    void AddCacheStats(ReaderStats &s) const;
 
     void PrepareTreeFile(const char *root_fname, const char *root_trname);
+    void ConfigureCache();
+    bool NextFile();
+    void SwitchFile(size_t i);
 };
 
 #endif
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TObjArray.h>
+
+#include "RootReader.h"
+#include "BDtaunuReader.h"
+#include "SkimWriter.h"
+
+// Create an output file, and make it the current directory so that
+// cloned trees are written to it.
+static TFile *OpenOutput(const std::string &output_fname) {
+  TFile *f = new TFile(output_fname.c_str(), "RECREATE");
+  if (f->IsZombie()) {
+    std::cerr << "TFile* associated to \"" << output_fname;
+    std::cerr << "\" is invalid." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  f->cd();
+  return f;
+}
+
+static void CloseOutput(TFile *f) {
+  f->Write();
+  f->Close();
+  delete f;
+}
+
+SkimWriter::SkimWriter(Predicate _keep) :
+  keep(_keep), nthreads(0),
+  make_reader([] (const std::string &fname) {
+    return std::unique_ptr<BDtaunuReader>(new BDtaunuReader(fname.c_str()));
+  }) {
+}
+
+// Keep active only the branches the reader has bound, and the extra
+// branches. Inactive branches are neither read nor cloned.
+void SkimWriter::SelectBranches(TTree *tr) const {
+
+  std::vector<std::string> kept;
+  TObjArray *branches = tr->GetListOfBranches();
+  for (int i = 0; branches && i < branches->GetEntriesFast(); ++i) {
+    TBranch *b = static_cast<TBranch*>(branches->At(i));
+    if (tr->GetBranchStatus(b->GetName()) && b->GetAddress()) kept.push_back(b->GetName());
+  }
+
+  for (const auto &name : extra_branches) {
+    if (!tr->GetBranch(name.c_str())) {
+      std::cerr << "SkimWriter: no branch " << name << " to keep." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    kept.push_back(name);
+  }
+
+  tr->SetBranchStatus("*", 0);
+  for (const auto &name : kept) tr->SetBranchStatus(name.c_str(), 1);
+}
+
+Long64_t SkimWriter::skim(BDtaunuReader &reader, const std::string &output_fname) const {
+
+  SelectBranches(reader.tr);
+  TFile *output = OpenOutput(output_fname);
+
+  // The clone is made from the first tree the reader reads. When the
+  // reader moves on to the next file, the clone is pointed at the
+  // buffers of the new tree.
+  TTree *out = nullptr;
+  TTree *current = nullptr;
+  Long64_t nwritten = 0;
+
+  RootReader::Status status;
+  while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+    if (reader.tr != current) {
+      current = reader.tr;
+      if (out) {
+        current->CopyAddresses(out);
+      } else {
+        output->cd();
+        out = current->CloneTree(0);
+      }
+    }
+    if (status != RootReader::Status::kReadSucceeded) continue;
+    if (keep && !keep(reader)) continue;
+    out->Fill();
+    ++nwritten;
+  }
+
+  if (!out) {
+    output->cd();
+    out = reader.tr->CloneTree(0);
+  }
+  CloseOutput(output);
+
+  return nwritten;
+}
+
+// Copy the baskets of the kept branches without unpacking them. Only
+// used on a reader of a single file. The copy would include the entries
+// the reader rejects, which skim() drops, so a file with any of them is
+// skimmed instead. Finding them only reads the count branches.
+Long64_t SkimWriter::FastCopy(BDtaunuReader &reader, const std::string &output_fname) const {
+  if (reader.tr->GetEntries(reader.RejectedSelection().c_str()) > 0) {
+    return skim(reader, output_fname);
+  }
+  SelectBranches(reader.tr);
+  TFile *output = OpenOutput(output_fname);
+  TTree *out = reader.tr->CloneTree(-1, "fast");
+  Long64_t nwritten = out ? out->GetEntries() : 0;
+  CloseOutput(output);
+  return nwritten;
+}
+
+std::vector<Long64_t> SkimWriter::run(
+    const std::vector<std::string> &input_fnames,
+    const std::vector<std::string> &output_fnames) const {
+
+  if (input_fnames.size() != output_fnames.size()) {
+    std::cerr << "SkimWriter: " << input_fnames.size() << " inputs but ";
+    std::cerr << output_fnames.size() << " outputs." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<Long64_t> nwritten(input_fnames.size(), 0);
+  auto skim_file = [this, &input_fnames, &output_fnames, &nwritten] (size_t f) {
+    std::unique_ptr<BDtaunuReader> reader = make_reader(input_fnames[f]);
+    nwritten[f] = keep ? skim(*reader, output_fnames[f])
+                       : FastCopy(*reader, output_fnames[f]);
+  };
+
+  int n = nthreads;
+  if (n <= 0) n = std::thread::hardware_concurrency();
+  if (n <= 0) n = 1;
+  n = std::min<int>(n, input_fnames.size());
+
+  if (n <= 1) {
+    for (size_t f = 0; f < input_fnames.size(); ++f) skim_file(f);
+    return nwritten;
+  }
+
+  // Same scheme as McYieldTally: each thread takes the next file.
+  ROOT::EnableThreadSafety();
+  std::atomic<int> next_file(0);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < n; ++i) {
+    workers.push_back(std::thread([&input_fnames, &next_file, &skim_file] () {
+      int f;
+      while ((f = next_file++) < static_cast<int>(input_fnames.size())) skim_file(f);
+    }));
+  }
+  for (auto &w : workers) w.join();
+
+  return nwritten;
+}
@@ -0,0 +1,111 @@
+#ifndef __SKIMWRITER_H__
+#define __SKIMWRITER_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include <Rtypes.h>
+
+#include "BDtaunuReader.h"
+
+class TTree;
+
+/** @brief Writes the events a predicate keeps to a smaller ntuple.
+ *
+ * @detail
+ * # Purpose
+ * Most passes of an analysis only look at a small fraction of the
+ * events, and at a fraction of the branches. This class reads events
+ * with a BDtaunuReader, offers each successfully read event to a
+ * predicate, and writes the ones it keeps to a new tree of the same
+ * name.
+ *
+ * # Branches
+ * The skim holds the branches the reader reads, that is the active
+ * branches it has bound, plus any set with `set_extra_branches()`.
+ * Every other branch is deactivated. A reader constructed like the one
+ * that wrote the skim therefore reads it unchanged; for example a skim
+ * written through a BDtaunuMcReader in kMcOnly mode can only be read in
+ * that mode.
+ *
+ * # Copying
+ * With a null predicate, every successfully read event is kept. If the
+ * reader accepts every entry of a file, `run()` then copies the
+ * compressed baskets of the kept branches with
+ * `TTree::CloneTree(-1, "fast")` rather than decompressing and
+ * refilling them. Otherwise kept events are filled one at a time, so
+ * both ways drop the entries that exceed the reader's buffer limits.
+ *
+ * # Parallelism
+ * `run()` skims a list of files into a list of outputs, one output per
+ * input. As in McYieldTally, each worker thread takes the next file and
+ * reads it with its own reader. The predicate is called from all worker
+ * threads, and must be safe to call concurrently.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     SkimWriter skim([] (const BDtaunuReader &r) {
+ *       return r.get_upsilon_candidates().size() > 0;
+ *     });
+ *
+ *     // One reader.
+ *     BDtaunuReader reader("sp1235r1.root");
+ *     skim.skim(reader, "sp1235r1.skim.root");
+ *
+ *     // Or many files in parallel.
+ *     skim.set_nthreads(8);
+ *     skim.run({"sp1235r1.root", "sp1235r2.root"},
+ *              {"skim/sp1235r1.root", "skim/sp1235r2.root"});
+ */
+class SkimWriter {
+
+  public:
+
+    //! Whether to keep the current event of a reader.
+    typedef std::function<bool(const BDtaunuReader&)> Predicate;
+
+    //! Makes the reader of one input file in `run()`.
+    typedef std::function<std::unique_ptr<BDtaunuReader>(const std::string&)> ReaderFactory;
+
+    SkimWriter() = delete;
+
+    //! Keep the events `keep` returns true for; null keeps every event
+    //! that is read successfully.
+    SkimWriter(Predicate keep);
+    SkimWriter(const SkimWriter&) = delete;
+    SkimWriter &operator=(const SkimWriter&) = delete;
+    ~SkimWriter() {};
+
+    //! Branches to write in addition to the ones the reader reads.
+    void set_extra_branches(const std::vector<std::string> &b) { extra_branches = b; }
+
+    //! Number of worker threads of `run()`. 0 means one per hardware thread.
+    void set_nthreads(int n) { nthreads = n; }
+
+    //! Reader of each input file of `run()`. Defaults to a BDtaunuReader
+    //! of tree "ntp1".
+    void set_reader_factory(ReaderFactory f) { make_reader = f; }
+
+    //! Skim the events of a reader that has not read any yet.
+    /*! Returns the number of events written. */
+    Long64_t skim(BDtaunuReader &reader, const std::string &output_fname) const;
+
+    //! Skim `input_fnames[i]` into `output_fnames[i]` for every i.
+    /*! Returns the number of events written to each output. */
+    std::vector<Long64_t> run(const std::vector<std::string> &input_fnames,
+                              const std::vector<std::string> &output_fnames) const;
+
+  private:
+    Predicate keep;
+    std::vector<std::string> extra_branches;
+    int nthreads;
+    ReaderFactory make_reader;
+
+    void SelectBranches(TTree *tr) const;
+    Long64_t FastCopy(BDtaunuReader &reader, const std::string &output_fname) const;
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+#include "StagingCache.h"
+
+namespace {
+
+// Process wide default cache.
+std::mutex default_mutex;
+bool default_set = false;
+std::shared_ptr<StagingCache> default_cache;
+
+// 64 bit FNV-1a; stable across compilers and runs, unlike std::hash.
+unsigned long long Fnv1a(const std::string &s) {
+  unsigned long long h = 14695981039346656037ULL;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+bool EndsWith(const std::string &s, const std::string &suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+// Lease
+// -----
+
+StagingCache::Lease::Lease(Lease &&other) : path(std::move(other.path)), fd(other.fd) {
+  other.fd = -1;
+}
+
+StagingCache::Lease &StagingCache::Lease::operator=(Lease &&other) {
+  if (this != &other) {
+    if (fd >= 0) close(fd);
+    path = std::move(other.path);
+    fd = other.fd;
+    other.fd = -1;
+  }
+  return *this;
+}
+
+// Closing the lock file releases the shared lock.
+StagingCache::Lease::~Lease() {
+  if (fd >= 0) close(fd);
+}
+
+
+// StagingCache
+// ------------
+
+StagingCache::StagingCache(const std::string &_cache_dir, Long64_t _budget) :
+  cache_dir(_cache_dir), budget(_budget), hits(0), copies(0) {
+  if (mkdir(cache_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    std::cerr << "StagingCache: cannot create " << cache_dir << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+StagingCache::Lease StagingCache::stage(const std::string &fname) {
+
+  struct stat src;
+  if (stat(fname.c_str(), &src) != 0 || !S_ISREG(src.st_mode)) return Lease(fname);
+  if (src.st_size > budget) return Lease(fname);
+
+  char resolved[PATH_MAX];
+  std::string canonical = realpath(fname.c_str(), resolved) ? resolved : fname;
+
+  char key[32];
+  std::snprintf(key, sizeof(key), "%016llx", Fnv1a(canonical + "\n" +
+        std::to_string(src.st_size) + "\n" +
+        std::to_string(src.st_mtime)));
+  std::string copy_path = cache_dir + "/" + key + ".root";
+  std::string lock_path = cache_dir + "/" + key + ".lock";
+
+  // Converting the exclusive lock to a shared one is not atomic, so
+  // another process may evict the copy in between; try again if so.
+  for (int attempt = 0; attempt < 3; ++attempt) {
+
+    int fd = open(lock_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return Lease(fname);
+    flock(fd, LOCK_EX);
+
+    struct stat dst;
+    if (stat(copy_path.c_str(), &dst) == 0 && dst.st_size == src.st_size) {
+      utimensat(AT_FDCWD, copy_path.c_str(), nullptr, 0);
+      ++hits;
+    } else {
+      if (!Evict(src.st_size) || !CopyFile(fname, copy_path)) {
+        close(fd);
+        return Lease(fname);
+      }
+      ++copies;
+    }
+
+    flock(fd, LOCK_SH);
+    if (stat(copy_path.c_str(), &dst) == 0) {
+      Lease lease(copy_path);
+      lease.fd = fd;
+      return lease;
+    }
+    close(fd);
+  }
+
+  return Lease(fname);
+}
+
+// Remove the least recently used copies that are not leased until
+// `nbytes` more fit in the budget. Copies in progress, under their
+// temporary names, count against the budget but are left alone.
+// Returns whether `nbytes` more fit.
+bool StagingCache::Evict(Long64_t nbytes) {
+
+  std::string dir_lock_path = cache_dir + "/.lock";
+  int dir_fd = open(dir_lock_path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (dir_fd < 0) return false;
+  flock(dir_fd, LOCK_EX);
+
+  struct Copy { std::string key; Long64_t size; time_t mtime; };
+  std::vector<Copy> cached;
+  Long64_t total = 0;
+
+  DIR *dir = opendir(cache_dir.c_str());
+  if (dir) {
+    while (struct dirent *e = readdir(dir)) {
+      std::string name = e->d_name;
+      bool in_progress = name.find(".root.tmp.") != std::string::npos;
+      if (!EndsWith(name, ".root") && !in_progress) continue;
+      struct stat st;
+      if (stat((cache_dir + "/" + name).c_str(), &st) != 0) continue;
+      if (!in_progress) cached.push_back({ name.substr(0, name.size() - 5), st.st_size, st.st_mtime });
+      total += st.st_size;
+    }
+    closedir(dir);
+  }
+
+  std::sort(cached.begin(), cached.end(),
+      [] (const Copy &a, const Copy &b) { return a.mtime < b.mtime; });
+
+  for (const auto &c : cached) {
+    if (total + nbytes <= budget) break;
+
+    // Copies that are being made or read hold their lock file.
+    int fd = open((cache_dir + "/" + c.key + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) continue;
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+      if (unlink((cache_dir + "/" + c.key + ".root").c_str()) == 0) total -= c.size;
+    }
+    close(fd);
+  }
+
+  close(dir_fd);
+  return total + nbytes <= budget;
+}
+
+// Copy to a temporary name, then rename into place so that a copy is
+// never seen half written.
+bool StagingCache::CopyFile(const std::string &src, const std::string &dst) const {
+
+  std::string tmp = dst + ".tmp." + std::to_string(getpid());
+  int in = open(src.c_str(), O_RDONLY);
+  if (in < 0) return false;
+  int out = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out < 0) {
+    close(in);
+    return false;
+  }
+
+  static const size_t buffer_size = 4 << 20;
+  std::vector<char> buffer(buffer_size);
+  bool ok = true;
+  while (ok) {
+    ssize_t n = read(in, buffer.data(), buffer_size);
+    if (n == 0) break;
+    if (n < 0) {
+      ok = false;
+      break;
+    }
+    for (ssize_t written = 0; written < n; ) {
+      ssize_t w = write(out, buffer.data() + written, n - written);
+      if (w <= 0) {
+        ok = false;
+        break;
+      }
+      written += w;
+    }
+  }
+
+  close(in);
+  if (close(out) != 0) ok = false;
+  if (ok) ok = (rename(tmp.c_str(), dst.c_str()) == 0);
+  if (!ok) unlink(tmp.c_str());
+  return ok;
+}
+
+std::shared_ptr<StagingCache> StagingCache::Default() {
+  std::lock_guard<std::mutex> lock(default_mutex);
+  if (!default_set) {
+    default_set = true;
+    const char *dir = std::getenv("BDTAUNU_STAGING_DIR");
+    const char *budget_mb = std::getenv("BDTAUNU_STAGING_BUDGET_MB");
+    if (dir && *dir) {
+      Long64_t budget = budget_mb ? std::atoll(budget_mb) : 10240;
+      default_cache = std::make_shared<StagingCache>(dir, budget << 20);
+    }
+  }
+  return default_cache;
+}
+
+void StagingCache::SetDefault(std::shared_ptr<StagingCache> cache) {
+  std::lock_guard<std::mutex> lock(default_mutex);
+  default_set = true;
+  default_cache = cache;
+}
@@ -0,0 +1,117 @@
+#ifndef __STAGINGCACHE_H__
+#define __STAGINGCACHE_H__
+
+#include <string>
+#include <memory>
+#include <atomic>
+
+#include <Rtypes.h>
+
+/** @brief Local copies of input ntuples, with LRU eviction.
+ *
+ * @detail
+ * # Purpose
+ * Inputs on a shared filesystem are slow under contention, and the same
+ * samples are read many times a day. `stage()` copies a file into a
+ * local directory, e.g. on an SSD or tmpfs, the first time it is asked
+ * for; later readers of the same file open the local copy.
+ *
+ * Copies are keyed by the canonical path, size, and modification time
+ * of the original, so a rewritten original is copied again. Whole files
+ * are copied, since TFile reads are scattered over the file.
+ *
+ * # Eviction
+ * Before a copy, the least recently used copies are removed until the
+ * new one fits in the size budget. Copies that other processes are
+ * still writing count against the budget. Staging a file that is
+ * already in the cache marks it as used. Files larger than the budget
+ * are never staged, nor are files for which eviction cannot make room
+ * because the copies in the way are leased; their original is read.
+ *
+ * # Concurrency
+ * Any number of processes on a node can share a cache directory:
+ * * Each copy has a lock file. It is held exclusively while the copy is
+ *   made, so a file is copied once, and shared while a Lease on the copy
+ *   exists, so the copy is not evicted while it is read.
+ * * Eviction holds a lock on the whole directory.
+ * * Copies are written to a temporary name and renamed into place.
+ *
+ * Usage Example
+ * -------------
+ *
+ *     StagingCache::SetDefault(std::make_shared<StagingCache>("/scratch/ntuples", 50LL << 30));
+ *     BDtaunuReader reader("/nfs/sp1235r1.root");  // reads /scratch/ntuples/...
+ *
+ * RootReader stages every file through `Default()` when it is set. The
+ * default can also be set with the environment variables
+ * `BDTAUNU_STAGING_DIR` and `BDTAUNU_STAGING_BUDGET_MB`; the budget
+ * defaults to 10 GB.
+ */
+class StagingCache {
+
+  public:
+
+    //! A file to read: the staged copy, or the original.
+    /*! Holds the copy's lock file shared until destroyed. */
+    class Lease {
+
+      public:
+        Lease() = default;
+        explicit Lease(const std::string &_path) : path(_path) {}
+        Lease(const Lease&) = delete;
+        Lease &operator=(const Lease&) = delete;
+        Lease(Lease &&other);
+        Lease &operator=(Lease &&other);
+        ~Lease();
+
+        //! Path to open.
+        const std::string &get_path() const { return path; }
+
+        //! Whether the path is a staged copy.
+        bool is_staged() const { return fd >= 0; }
+
+      private:
+        friend class StagingCache;
+        std::string path;
+        int fd = -1;
+    };
+
+    StagingCache() = delete;
+    StagingCache(const std::string &cache_dir, Long64_t budget_bytes);
+    StagingCache(const StagingCache&) = delete;
+    StagingCache &operator=(const StagingCache&) = delete;
+    ~StagingCache() {};
+
+    //! Local copy of `fname`, copied now if it is not cached.
+    /*! Returns a lease on `fname` itself if it cannot be staged: it is
+     * not a local file, it is larger than the budget, leased copies
+     * leave no room for it, or the copy failed. */
+    Lease stage(const std::string &fname);
+
+    const std::string &get_cache_dir() const { return cache_dir; }
+    Long64_t get_budget() const { return budget; }
+
+    //! Number of `stage()` calls that found a copy in the cache.
+    unsigned long long get_hits() const { return hits; }
+
+    //! Number of `stage()` calls that made a copy.
+    unsigned long long get_copies() const { return copies; }
+
+    //! Cache used by RootReader; null unless set.
+    /*! Built from the environment on first use if not set. */
+    static std::shared_ptr<StagingCache> Default();
+
+    //! Set the cache used by RootReader; null turns staging off.
+    static void SetDefault(std::shared_ptr<StagingCache> cache);
+
+  private:
+    std::string cache_dir;
+    Long64_t budget;
+    std::atomic<unsigned long long> hits;
+    std::atomic<unsigned long long> copies;
+
+    bool Evict(Long64_t nbytes);
+    bool CopyFile(const std::string &src, const std::string &dst) const;
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include <boost/graph/graphviz.hpp>
 
 #include "BDtaunuDef.h"
+#include "ReaderStats.h"
 #include "TruthMatchManager.h"
 #include "BDtaunuMcReader.h"
 #include "GraphDef.h"
@@ -22,10 +23,12 @@ using namespace bdtaunu;
 // TruthMatchMananger
 // ------------------
 
-TruthMatchManager::TruthMatchManager() : reader(nullptr) {
+TruthMatchManager::TruthMatchManager() : reader(nullptr), context(nullptr) {
 }
 
-TruthMatchManager::TruthMatchManager(BDtaunuMcReader *_reader) : reader(_reader) {
+TruthMatchManager::TruthMatchManager(
+    BDtaunuMcReader *_reader, const AnalysisContext &_context) : 
+  reader(_reader), context(&_context) {
 }
 
 int TruthMatchManager::get_truth_match_status(int reco_idx) const {
@@ -45,28 +48,36 @@ void TruthMatchManager::update_graph(
   gammaMCIdx = reader->gammaMCIdx;
 
   // Get copies of the MC and reconstructed graphs. Copies because 
-  // we will need to modify them for the algorithm.  
+  // we will need to modify them for the algorithm. The MC manager
+  // only keeps a flat tree, so a BGL graph is built from it here. 
   reco_graph = reco_graph_manager.get_reco_graph();
   reco_indexer = reco_graph_manager.get_reco_indexer();
-  mc_graph = mc_graph_manager.get_mc_graph();
-
-  // Edge contract the MC graph.
-  contract_mc_graph();
+  mc_graph_manager.build_graph(mc_graph);
 }
 
 // Analyze cached graph. Entry point to the algorithm. 
 void TruthMatchManager::analyze_graph() {
   truth_match.clear();
+  n_probes = 0;
   depth_first_search(reco_graph, visitor(TruthMatchDfsVisitor(this)));
 }
 
+// The visitor only inserts into the truth match map, so the candidate's 
+// entry is erased first. 
+int TruthMatchManager::match_candidate(RecoGraph::Vertex u) {
+  int reco_idx = get(vertex_reco_index, reco_graph)[u];
+  truth_match.erase(reco_idx);
+  TruthMatchDfsVisitor(this).finish_vertex(u, reco_graph);
+  return get_truth_match_status(reco_idx);
+}
+
 // Given a vertex on the original MC graph, decide whether it needs to 
 // be ``cleaved''. These are vertices we do not wish to truth match. 
-bool TruthMatchManager::is_cleave_vertex(
+bool TruthMatchManager::IsCleaveVertex(
     const McGraph::Vertex &v, 
     const McGraph::Graph &g, 
     const McGraph::LundIdPropertyMap &lund_id_pm,
-    const McGraph::McIndexPropertyMap &mc_idx_pm) const {
+    const McGraph::McIndexPropertyMap &mc_idx_pm) {
 
   // neutrinos, tau, and K0
   switch (abs(lund_id_pm[v])) {
@@ -109,9 +120,8 @@ bool TruthMatchManager::is_cleave_vertex(
 
 // Edge contract the MC graph to get rid of the vertices we wanted to cleave. 
 // http://en.wikipedia.org/wiki/Edge_contraction
-void TruthMatchManager::contract_mc_graph() {
+void TruthMatchManager::ContractMcGraph(McGraph::Graph &g) {
 
-  McGraph::Graph &g = mc_graph;
   McGraph::McIndexPropertyMap mc_idx_pm = get(vertex_mc_index, g);
   McGraph::LundIdPropertyMap lund_id_pm = get(vertex_lund_id, g);
 
@@ -120,7 +130,7 @@ void TruthMatchManager::contract_mc_graph() {
   std::vector<int> to_cleave;
   graph_traits<McGraph::Graph>::vertex_iterator vi, vi_end;
   for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi)
-    if (is_cleave_vertex(*vi, g, lund_id_pm, mc_idx_pm)) to_cleave.push_back(mc_idx_pm[*vi]);
+    if (IsCleaveVertex(*vi, g, lund_id_pm, mc_idx_pm)) to_cleave.push_back(mc_idx_pm[*vi]);
 
   // Cleave away a vertex by contracting the edge between its mother and itself.
   for (auto i : to_cleave) {
@@ -160,7 +170,7 @@ void TruthMatchManager::print_mc(std::ostream &os) const {
   auto lund_pm = get(vertex_lund_id, mc_graph);
   auto mc_idx_pm = get(vertex_mc_index, mc_graph);
   BDtaunuGraphvizManager<decltype(mc_graph), decltype(lund_pm), decltype(mc_idx_pm)> gv_manager(
-      mc_graph, lund_pm, mc_idx_pm, BDtaunuMcReader::lund_to_name);
+      mc_graph, lund_pm, mc_idx_pm, context->get_lund_to_name());
 
   gv_manager.set_title("MC Graph with Edge Contraction");
   gv_manager.set_vertex_property({"color", "blue"});
@@ -180,7 +190,7 @@ void TruthMatchManager::print_reco(std::ostream &os) const {
   auto lund_pm = get(vertex_lund_id, reco_graph);
   auto reco_idx_pm = get(vertex_reco_index, reco_graph);
   BDtaunuGraphvizManager<decltype(reco_graph), decltype(lund_pm), decltype(reco_idx_pm)> gv_manager(
-      reco_graph, lund_pm, reco_idx_pm, BDtaunuMcReader::lund_to_name, truth_match);
+      reco_graph, lund_pm, reco_idx_pm, context->get_lund_to_name(), truth_match);
 
   gv_manager.set_title("Reco Graph with Truth Match");
   gv_manager.set_vertex_property({"color", "red"});
@@ -304,6 +314,8 @@ void TruthMatchDfsVisitor::MatchCompositeState(const RecoGraph::Vertex &u, const
     // Consider only MC particles with the correct identity. 
     if (reco_lund_pm[u] == mc_lund_pm[*vi]) {
 
+      if (ReaderStats::enabled) ++manager->n_probes;
+
       // Get a list of the MC particle's daughter and store their mc_idx. 
       std::vector<int> dau_mc_idx;
       McGraph::AdjacencyIterator bi, bi_end;
@@ -5,6 +5,7 @@
 #include <boost/graph/depth_first_search.hpp>
 
 #include "GraphDef.h"
+#include "AnalysisContext.h"
 #include "RecoGraphManager.h"
 #include "McGraphManager.h"
 
@@ -58,7 +59,7 @@ class TruthMatchManager {
     
     // Constructors and copy control
     TruthMatchManager();
-    TruthMatchManager(BDtaunuMcReader *reader);
+    TruthMatchManager(BDtaunuMcReader *reader, const AnalysisContext &context);
     TruthMatchManager(const TruthMatchManager&) = default;
     TruthMatchManager &operator=(const TruthMatchManager&) = default;
     ~TruthMatchManager() = default;
@@ -71,11 +72,28 @@ class TruthMatchManager {
     std::map<int, int> get_truth_map() const { return truth_match; }
 
     //! Update the cached particle graphs to analyze. 
+    /*! Call `contract_mc_graph()` before analyzing them. */
     void update_graph(const RecoGraphManager&, const McGraphManager&);
 
+    //! Edge contract the cached MC graph. 
+    void contract_mc_graph() { ContractMcGraph(mc_graph); }
+
     //! Analyze cached graphs.
     void analyze_graph();
 
+    //! Truth match the candidate at vertex `u` of the cached reco graph again. 
+    /*! Returns its truth match. Its daughters keep their matches from the 
+     * last `analyze_graph()`, which must have run. */
+    int match_candidate(RecoGraph::Vertex u);
+
+    //! Edge contract a BGL graph built by `McGraphManager::build_graph()`. 
+    /*! This is what `contract_mc_graph()` does to the cached copy of the MC graph. */
+    static void ContractMcGraph(McGraph::Graph &g);
+
+    //! Number of MC particles compared to a reco candidate by the last `analyze_graph()`.
+    /*! Only counted when ReaderStats::enabled. */
+    unsigned long long get_n_probes() const { return n_probes; }
+
     //! Print the edge contracted MC graph. 
     void print_mc(std::ostream &os) const;
 
@@ -89,8 +107,10 @@ class TruthMatchManager {
 
     // TruthMatchDfsVisitor writes its truth match results to this map. 
     std::map<int, int> truth_match;
+    unsigned long long n_probes = 0;
 
     BDtaunuMcReader *reader;
+    const AnalysisContext *context;
     const int *hMCIdx;
     const int *lMCIdx;
     const int *gammaMCIdx;
@@ -102,12 +122,11 @@ class TruthMatchManager {
 
     // Helper Functions
     // ----------------
-    void contract_mc_graph();
-    bool is_cleave_vertex(
+    static bool IsCleaveVertex(
         const McGraph::Vertex &v, 
         const McGraph::Graph &g, 
         const McGraph::LundIdPropertyMap &lund_id_pm,
-        const McGraph::McIndexPropertyMap &mc_idx_pm) const;
+        const McGraph::McIndexPropertyMap &mc_idx_pm);
 };
 
 
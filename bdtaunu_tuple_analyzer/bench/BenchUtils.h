@@ -0,0 +1,148 @@
+#ifndef __BENCHUTILS_H__
+#define __BENCHUTILS_H__
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+/** @file BenchUtils.h
+ *  @brief Helpers shared by the benchmark programs.
+ */
+
+namespace bench {
+
+typedef std::chrono::steady_clock Clock;
+
+//! Seconds between two time points.
+inline double Seconds(Clock::time_point start, Clock::time_point end) {
+  return std::chrono::duration<double>(end - start).count();
+}
+
+//! Multiplicity bucket of n.
+/*! `edges` are the inclusive upper edges of the buckets in increasing
+ * order, starting with 0; e.g. {0, 10, 50} gives "0", "1-10", "11-50",
+ * and ">50". */
+inline std::string Bucket(int n, const std::vector<int> &edges) {
+  int lo = 0;
+  for (auto hi : edges) {
+    if (n <= hi) {
+      return (lo == hi) ? std::to_string(hi) : std::to_string(lo) + "-" + std::to_string(hi);
+    }
+    lo = hi + 1;
+  }
+  return ">" + std::to_string(edges.back());
+}
+
+//! Summary statistics of a set of samples.
+struct Summary {
+  std::size_t n = 0;
+  double min = 0, median = 0, mean = 0, p95 = 0, p99 = 0, max = 0;
+};
+
+//! Nearest rank percentile q, in [0, 1], of sorted samples.
+inline double Percentile(const std::vector<double> &sorted, double q) {
+  if (sorted.empty()) return 0;
+  std::size_t rank = static_cast<std::size_t>(std::ceil(q * sorted.size()));
+  return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+inline Summary Summarize(std::vector<double> samples) {
+  Summary s;
+  if (samples.empty()) return s;
+  std::sort(samples.begin(), samples.end());
+  s.n = samples.size();
+  s.min = samples.front();
+  s.max = samples.back();
+  s.median = Percentile(samples, 0.50);
+  s.p95 = Percentile(samples, 0.95);
+  s.p99 = Percentile(samples, 0.99);
+  double sum = 0;
+  for (auto x : samples) sum += x;
+  s.mean = sum / samples.size();
+  return s;
+}
+
+/** @brief Streams JSON.
+ *
+ * @detail Commas and nesting are tracked by the writer; callers only
+ * open and close containers and write keys and values.
+ *
+ *     JsonWriter json(os);
+ *     json.begin_object();
+ *     json.field("events", 100);
+ *     json.key("stages");
+ *     json.begin_array();
+ *     json.value(0.5);
+ *     json.end_array();
+ *     json.end_object();
+ */
+class JsonWriter {
+
+  public:
+    JsonWriter(std::ostream &_os) : os(_os), after_key(false) {}
+
+    void begin_object() { Separate(); os << "{"; first.push_back(true); }
+    void end_object() { first.pop_back(); Newline(); os << "}"; if (first.empty()) os << "\n"; }
+    void begin_array() { Separate(); os << "["; first.push_back(true); }
+    void end_array() { first.pop_back(); Newline(); os << "]"; }
+
+    void key(const std::string &k) { Separate(); Quote(k); os << ": "; after_key = true; }
+
+    void value(const std::string &v) { Separate(); Quote(v); }
+    void value(const char *v) { value(std::string(v)); }
+    void value(bool v) { Separate(); os << (v ? "true" : "false"); }
+    void value(int v) { Separate(); os << v; }
+    void value(long v) { Separate(); os << v; }
+    void value(long long v) { Separate(); os << v; }
+    void value(unsigned long v) { Separate(); os << v; }
+    void value(unsigned long long v) { Separate(); os << v; }
+    //! NaN and infinities have no JSON number, so they are written as null.
+    void value(double v) {
+      Separate();
+      if (!std::isfinite(v)) { os << "null"; return; }
+      char buf[32];
+      std::snprintf(buf, sizeof(buf), "%.9g", v);
+      os << buf;
+    }
+
+    template <typename T>
+    void field(const std::string &k, const T &v) { key(k); value(v); }
+
+  private:
+    std::ostream &os;
+    std::vector<bool> first;
+    bool after_key;
+
+    // Comma and indentation before the next element.
+    void Separate() {
+      if (after_key) { after_key = false; return; }
+      if (first.empty()) return;
+      if (!first.back()) os << ",";
+      first.back() = false;
+      Newline();
+    }
+
+    void Newline() { os << "\n" << std::string(2 * first.size(), ' '); }
+
+    void Quote(const std::string &s) {
+      os << '"';
+      for (auto c : s) {
+        switch (c) {
+          case '"': os << "\\\""; break;
+          case '\\': os << "\\\\"; break;
+          case '\n': os << "\\n"; break;
+          case '\t': os << "\\t"; break;
+          default: os << c;
+        }
+      }
+      os << '"';
+    }
+};
+
+}
+
+#endif
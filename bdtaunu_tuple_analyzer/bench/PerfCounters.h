@@ -0,0 +1,172 @@
+#ifndef __PERFCOUNTERS_H__
+#define __PERFCOUNTERS_H__
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/** @file PerfCounters.h
+ *  @brief Hardware performance counters of the calling thread.
+ */
+
+namespace bench {
+
+/** @brief Reads Linux perf_event_open counters of the calling thread.
+ *
+ * @detail
+ * Each counter is opened on its own, so counters the CPU or kernel does
+ * not provide are left out while the rest still work. Where
+ * perf_event_open is not permitted, e.g. in containers or with a high
+ * `perf_event_paranoid`, or off Linux, no counter opens, `read()` returns
+ * zeros, and `get_error()` says why. Only user space is counted.
+ *
+ * Counts are scaled for multiplexing by the enabled over running time.
+ *
+ *     PerfCounters counters;
+ *     counters.open();
+ *     PerfCounters::Values v0 = counters.read();
+ *     // ...
+ *     PerfCounters::Values delta = counters.read() - v0;
+ */
+class PerfCounters {
+
+  public:
+
+    enum Counter {
+      kCycles, kInstructions, kL1dMisses, kLlcMisses, kBranchMisses, kPageFaults,
+      kNCounters
+    };
+
+    static const char *name(int c) {
+      static const char *names[] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "page_faults",
+      };
+      return names[c];
+    }
+
+    struct Values {
+      double v[kNCounters] = {};
+
+      Values &operator+=(const Values &o) {
+        for (int i = 0; i < kNCounters; ++i) v[i] += o.v[i];
+        return *this;
+      }
+
+      Values operator-(const Values &o) const {
+        Values d;
+        for (int i = 0; i < kNCounters; ++i) d.v[i] = v[i] - o.v[i];
+        return d;
+      }
+    };
+
+    PerfCounters() {
+      for (int i = 0; i < kNCounters; ++i) fd[i] = -1;
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters &operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() { close(); }
+
+    //! Open every counter that is available. Returns the number opened.
+    int open() {
+      int n = 0;
+      for (int i = 0; i < kNCounters; ++i) {
+        fd[i] = Open(static_cast<Counter>(i), error[i]);
+        if (fd[i] >= 0) ++n;
+      }
+      return n;
+    }
+
+    void close() {
+#ifdef __linux__
+      for (int i = 0; i < kNCounters; ++i) {
+        if (fd[i] >= 0) ::close(fd[i]);
+        fd[i] = -1;
+      }
+#endif
+    }
+
+    bool is_available(int c) const { return fd[c] >= 0; }
+
+    //! Why counter `c` did not open; empty if it did.
+    const std::string &get_error(int c) const { return error[c]; }
+
+    //! Current counts since `open()`.
+    Values read() const {
+      Values values;
+#ifdef __linux__
+      for (int i = 0; i < kNCounters; ++i) {
+        if (fd[i] < 0) continue;
+        unsigned long long buf[3];
+        if (::read(fd[i], buf, sizeof(buf)) != sizeof(buf)) continue;
+        values.v[i] = (buf[2] > 0) ? buf[0] * (static_cast<double>(buf[1]) / buf[2]) : 0;
+      }
+#endif
+      return values;
+    }
+
+  private:
+    int fd[kNCounters];
+    std::string error[kNCounters];
+
+    static int Open(Counter c, std::string &err) {
+#ifdef __linux__
+      struct perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      switch (c) {
+        case kCycles:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_CPU_CYCLES;
+          break;
+        case kInstructions:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+          break;
+        case kL1dMisses:
+          attr.type = PERF_TYPE_HW_CACHE;
+          attr.config = PERF_COUNT_HW_CACHE_L1D |
+                        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+          break;
+        case kLlcMisses:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_CACHE_MISSES;
+          break;
+        case kBranchMisses:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+          break;
+        case kPageFaults:
+          attr.type = PERF_TYPE_SOFTWARE;
+          attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+          break;
+        default:
+          err = "unknown counter";
+          return -1;
+      }
+
+      int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+      if (fd < 0) err = std::strerror(errno);
+      return fd;
+#else
+      err = "perf_event_open is only available on Linux";
+      return -1;
+#endif
+    }
+};
+
+}
+
+#endif
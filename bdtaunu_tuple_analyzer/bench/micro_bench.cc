@@ -0,0 +1,323 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <new>
+#include <cstdlib>
+
+#include <boost/graph/adjacency_list.hpp>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuDef.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+
+#include "BenchUtils.h"
+
+using namespace std;
+using namespace boost;
+using bench::Clock;
+
+// Allocation counting
+// -------------------
+// Every global operator new goes through here so that each kernel can
+// report how many heap allocations it makes per operation.
+
+static unsigned long long n_allocations = 0;
+
+void *operator new(size_t n) {
+  ++n_allocations;
+  if (void *p = malloc(n ? n : 1)) return p;
+  throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+// Kernels
+// -------
+
+enum Kernel {
+  kSearchD, kSearchDstar, kSearchMcB, kRecoIdx,
+  kRecoConstruct, kRecoDfs, kContractMc, kMatchComposite,
+  kNKernels
+};
+
+const char *kernel_names[] = {
+  "search_d_catalogue", "search_dstar_catalogue",
+  "mcB_search_catalogue", "get_reco_idx",
+  "reco_construct_graph", "reco_graph_dfs",
+  "contract_mc_graph", "match_composite_state",
+};
+
+// Samples of one kernel. Each sample is the time per operation of one
+// timed repetition, in nanoseconds.
+struct KernelResult {
+  vector<double> ns_per_op;
+  long long ops = 0;
+  unsigned long long allocations = 0;
+};
+
+// Runs each kernel on the state left by BDtaunuMcReader::next_record().
+// Kernel inputs are taken from the event so that they have the event's
+// real multiplicities. Kernels that modify their graphs run on copies
+// of the reader's graph managers, through their public API.
+class KernelBenchmark {
+
+  public:
+    KernelBenchmark(int _warmup, int _repetitions)
+      : warmup(_warmup), repetitions(_repetitions), sink(0) {}
+
+    void run_event(BDtaunuMcReader &r) {
+      const AnalysisContext &context = r.get_context();
+      const bdtaunu::RecoDTypeCatalogue &recoD = context.get_recoD_catalogue();
+      const bdtaunu::McBTypeCatalogue &mcB = context.get_mcB_catalogue();
+
+      const RecoGraphManager &reco = r.get_reco_graph_manager();
+      const McGraphManager &mc = r.get_mc_graph_manager();
+      const RecoGraph::Graph &g = reco.get_reco_graph();
+
+      // Catalogue words and indexer queries, exactly as the visitors
+      // build them.
+      vector<vector<int>> d_words, dstar_words;
+      vector<pair<int, int>> idx_queries;
+      vector<RecoGraph::Vertex> composites;
+      auto lund_pm = get(vertex_lund_id, g);
+      auto block_pm = get(vertex_block_index, g);
+      graph_traits<RecoGraph::Graph>::vertex_iterator vi, vi_end;
+      for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi) {
+        idx_queries.push_back(make_pair(lund_pm[*vi], block_pm[*vi]));
+
+        // Composites are classified as in TruthMatchDfsVisitor::finish_vertex().
+        vector<vector<int>> *words = nullptr;
+        switch (abs(lund_pm[*vi])) {
+          case bdtaunu::D0Lund:
+          case bdtaunu::DcLund:
+            words = &d_words;
+            composites.push_back(*vi);
+            break;
+          case bdtaunu::Dstar0Lund:
+          case bdtaunu::DstarcLund:
+            words = &dstar_words;
+            composites.push_back(*vi);
+            break;
+          case bdtaunu::eLund:
+          case bdtaunu::muLund:
+          case bdtaunu::piLund:
+          case bdtaunu::KLund:
+          case bdtaunu::gammaLund:
+            break;
+          default:
+            composites.push_back(*vi);
+        }
+        if (words == nullptr) continue;
+        vector<int> word = { lund_pm[*vi] };
+        RecoGraph::AdjacencyIterator ai, ai_end;
+        for (tie(ai, ai_end) = adjacent_vertices(*vi, g); ai != ai_end; ++ai) {
+          word.push_back(lund_pm[*ai]);
+        }
+        words->push_back(word);
+      }
+
+      vector<vector<int>> mcB_words;
+      const McGraph::Tree &t = mc.get_mc_tree();
+      for (int u = 0; u < t.size(); ++u) {
+        int lund = abs(t.lund(u));
+        if (lund != bdtaunu::B0Lund && lund != bdtaunu::BcLund) continue;
+        vector<int> word;
+        for (int v = t.daughters_begin(u); v < t.daughters_end(u); ++v) {
+          word.push_back(t.lund(v));
+        }
+        mcB_words.push_back(word);
+      }
+
+      Measure(kSearchD, d_words.size(), [&] {
+        for (const auto &w : d_words) sink += static_cast<int>(recoD.search_d_catalogue(w));
+      });
+
+      Measure(kSearchDstar, dstar_words.size(), [&] {
+        for (const auto &w : dstar_words) sink += static_cast<int>(recoD.search_dstar_catalogue(w));
+      });
+
+      Measure(kSearchMcB, mcB_words.size(), [&] {
+        for (const auto &w : mcB_words) sink += static_cast<int>(mcB.search_catalogue(w));
+      });
+
+      const RecoGraph::RecoIndexer &indexer = reco.get_reco_indexer();
+      Measure(kRecoIdx, idx_queries.size(), [&] {
+        for (const auto &q : idx_queries) sink += indexer.get_reco_idx(q.first, q.second);
+      });
+
+      // Graph construction and traversal from the reader's buffer.
+      RecoGraphManager reco_copy = reco;
+      long nvertices = num_vertices(g);
+      Measure(kRecoConstruct, nvertices, [&] { reco_copy.construct_graph(); });
+      Measure(kRecoDfs, nvertices, [&] { reco_copy.analyze_graph(); });
+
+      // Edge contraction modifies the graph, so it is rebuilt untimed
+      // from the MC tree before each repetition.
+      McGraph::Graph mc_graph;
+      Measure(kContractMc, t.size(),
+        [&] { mc.build_graph(mc_graph); },
+        [&] { TruthMatchManager::ContractMcGraph(mc_graph); });
+
+      // Each composite is matched again on its own, against the
+      // daughter matches of the reader's pass.
+      TruthMatchManager tm = r.get_truth_match_manager();
+      Measure(kMatchComposite, composites.size(), [&] {
+        for (auto u : composites) sink += tm.match_candidate(u);
+      });
+    }
+
+    const KernelResult &result(int k) const { return results[k]; }
+
+    // Keeps the optimizer from discarding the lookups.
+    long long get_sink() const { return sink; }
+
+  private:
+    int warmup;
+    int repetitions;
+    long long sink;
+    KernelResult results[kNKernels];
+
+    template <typename F>
+    void Measure(Kernel k, long nops, F f) {
+      Measure(k, nops, [] {}, f);
+    }
+
+    // Run `setup` untimed and then `f` `warmup` times, then time
+    // `repetitions` runs of `f`, each preceded by an untimed `setup`.
+    template <typename S, typename F>
+    void Measure(Kernel k, long nops, S setup, F f) {
+      if (nops <= 0) return;
+      for (int i = 0; i < warmup; ++i) { setup(); f(); }
+
+      KernelResult &result = results[k];
+      for (int i = 0; i < repetitions; ++i) {
+        setup();
+        unsigned long long a0 = n_allocations;
+        Clock::time_point t0 = Clock::now();
+        f();
+        Clock::time_point t1 = Clock::now();
+        result.allocations += n_allocations - a0;
+        result.ops += nops;
+        result.ns_per_op.push_back(1e9 * bench::Seconds(t0, t1) / nops);
+      }
+    }
+};
+
+// Per kernel timings of the inner loops of the readers: catalogue
+// lookups, reco indexing, reco graph construction and traversal, MC graph
+// edge contraction, and composite truth matching.
+//
+// Every kernel is run on each event's own data: `-w` untimed warm up
+// runs, then `-r` timed repetitions. The median and 95th percentile of
+// the per repetition time per operation are reported, together with the
+// heap allocations per operation.
+//
+// Usage: micro_bench [-n nevents] [-s seed] [-y nY_min nY_max] [-w warmup] [-r repetitions] [-l label] [-o output.json] [file1.root ...]
+int main(int argc, char **argv) {
+
+  int nevents = 200;
+  unsigned seed = 1;
+  int nY_min = 0, nY_max = 200;
+  int warmup = 3, repetitions = 10;
+  string label;
+  string output_fname;
+  vector<string> fnames;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-n" && i + 1 < argc) {
+      nevents = atoi(argv[++i]);
+    } else if (arg == "-s" && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "-y" && i + 2 < argc) {
+      nY_min = atoi(argv[++i]);
+      nY_max = atoi(argv[++i]);
+    } else if (arg == "-w" && i + 1 < argc) {
+      warmup = atoi(argv[++i]);
+    } else if (arg == "-r" && i + 1 < argc) {
+      repetitions = atoi(argv[++i]);
+    } else if (arg == "-l" && i + 1 < argc) {
+      label = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_fname = argv[++i];
+    } else if (arg[0] == '-') {
+      cerr << "usage: " << argv[0];
+      cerr << " [-n nevents] [-s seed] [-y nY_min nY_max] [-w warmup] [-r repetitions]";
+      cerr << " [-l label] [-o output.json] [file1.root ...]" << endl;
+      return EXIT_FAILURE;
+    } else {
+      fnames.push_back(arg);
+    }
+  }
+
+  bool generated = fnames.empty();
+  if (generated) {
+    string fname = "/tmp/micro_bench_" + to_string(seed) + ".root";
+    NtupleGenerator generator(seed);
+    generator.set_nY_range(nY_min, nY_max);
+    generator.set_continuum_fraction(0.2);
+    generator.write(fname.c_str(), nevents);
+    fnames.push_back(fname);
+  }
+
+  KernelBenchmark benchmark(warmup, repetitions);
+  long events = 0;
+  for (const auto &fname : fnames) {
+    BDtaunuMcReader reader(fname.c_str());
+    reader.set_result_cache(nullptr);
+    RootReader::Status status;
+    while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+      if (status != RootReader::Status::kReadSucceeded) continue;
+      benchmark.run_event(reader);
+      ++events;
+    }
+  }
+
+  ofstream output;
+  if (!output_fname.empty()) output.open(output_fname);
+  bench::JsonWriter json(output_fname.empty() ? cout : output);
+
+  json.begin_object();
+  json.field("benchmark", "micro_bench");
+  json.field("label", label);
+  json.key("input");
+  json.begin_object();
+  json.field("generated", generated);
+  if (generated) {
+    json.field("nevents", nevents);
+    json.field("seed", static_cast<unsigned long>(seed));
+    json.field("nY_min", nY_min);
+    json.field("nY_max", nY_max);
+  }
+  json.key("files");
+  json.begin_array();
+  for (const auto &f : fnames) json.value(f);
+  json.end_array();
+  json.end_object();
+  json.field("events", events);
+  json.field("warmup", warmup);
+  json.field("repetitions", repetitions);
+  json.key("kernels");
+  json.begin_array();
+  for (int k = 0; k < kNKernels; ++k) {
+    const KernelResult &result = benchmark.result(k);
+    bench::Summary s = bench::Summarize(result.ns_per_op);
+    json.begin_object();
+    json.field("kernel", kernel_names[k]);
+    json.field("samples", static_cast<unsigned long>(s.n));
+    json.field("ops", result.ops);
+    json.field("median_ns_per_op", s.median);
+    json.field("p95_ns_per_op", s.p95);
+    json.field("mean_ns_per_op", s.mean);
+    json.field("allocations_per_op",
+               result.ops > 0 ? static_cast<double>(result.allocations) / result.ops : 0.0);
+    json.end_object();
+  }
+  json.end_array();
+  json.field("sink", benchmark.get_sink());
+  json.end_object();
+
+  return 0;
+}
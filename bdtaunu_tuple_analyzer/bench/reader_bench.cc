@@ -0,0 +1,311 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuReader.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/ReaderStats.h>
+
+#include "BenchUtils.h"
+#include "PerfCounters.h"
+
+using namespace std;
+using bench::Clock;
+using bench::PerfCounters;
+
+// Bucket edges for the multiplicity breakdown.
+const vector<int> nY_edges = { 0, 10, 50, 200, 800 };
+const vector<int> mcLen_edges = { 20, 40, 60, 100 };
+
+// Time spent in next_record() by a set of events, split into the stages
+// the reader's ReaderStats times, and the hardware counts of the whole
+// call and of each stage when counters are open.
+struct StageTotals {
+  long events = 0;
+  long candidates = 0;
+  double seconds = 0;
+  double stage_seconds[ReaderStats::kNStages] = {};
+  PerfCounters::Values perf;
+  PerfCounters::Values stage_perf[ReaderStats::kNStages];
+};
+
+struct ReaderResult {
+  string reader;
+  long skipped = 0;
+  StageTotals all;
+  map<pair<string, string>, StageTotals> buckets;
+};
+
+// Hardware counters to read around each next_record() and each of its
+// stages; null for none.
+PerfCounters *perf_counters = nullptr;
+
+// Reads the counters when a stage of next_record() starts and stops,
+// and adds the difference to the stage.
+class StagePerf : public ReaderStats::StageObserver {
+
+  public:
+    StagePerf(const PerfCounters &_counters) : counters(_counters) {}
+
+    void stage_started() { v0 = counters.read(); }
+
+    void stage_stopped(ReaderStats::Stage stage) { perf[stage] += counters.read() - v0; }
+
+    //! Counts of each stage since the last call.
+    void take(PerfCounters::Values *out) {
+      for (int i = 0; i < ReaderStats::kNStages; ++i) {
+        out[i] = perf[i];
+        perf[i] = PerfCounters::Values();
+      }
+    }
+
+  private:
+    const PerfCounters &counters;
+    PerfCounters::Values v0;
+    PerfCounters::Values perf[ReaderStats::kNStages];
+};
+
+// Total time the reader has spent in each stage.
+void StageSeconds(const RootReader &r, double *seconds) {
+  ReaderStats s = r.stats();
+  for (int i = 0; i < ReaderStats::kNStages; ++i) {
+    seconds[i] = s.stage_latency[i].get_total_seconds();
+  }
+}
+
+// Read every event with next_record(). The time of each stage of an
+// event is the growth of the reader's stage totals across the call.
+// Events that do not read successfully, e.g. over the candidate limits,
+// are counted as skipped. mcLen_bucket gives the mcLen bucket of the
+// current event.
+template <typename McLenBucket>
+void Run(BDtaunuReader &r, ReaderResult &result, McLenBucket mcLen_bucket) {
+
+  double before[ReaderStats::kNStages], after[ReaderStats::kNStages];
+  r.clear_stats();
+  StageSeconds(r, before);
+
+  std::unique_ptr<StagePerf> stage_perf;
+  if (perf_counters) stage_perf.reset(new StagePerf(*perf_counters));
+  r.set_stage_observer(stage_perf.get());
+  PerfCounters::Values event_stage_perf[ReaderStats::kNStages];
+
+  while (true) {
+    PerfCounters::Values v0;
+    if (perf_counters) v0 = perf_counters->read();
+    Clock::time_point t0 = Clock::now();
+    RootReader::Status status = r.next_record();
+    Clock::time_point t1 = Clock::now();
+    PerfCounters::Values perf;
+    if (perf_counters) perf = perf_counters->read() - v0;
+    if (stage_perf) stage_perf->take(event_stage_perf);
+    if (status == RootReader::Status::kEOF) break;
+
+    StageSeconds(r, after);
+    if (status != RootReader::Status::kReadSucceeded) {
+      ++result.skipped;
+    } else {
+      int nY = r.get_nY();
+      StageTotals &b = result.buckets[make_pair(bench::Bucket(nY, nY_edges), mcLen_bucket())];
+      for (StageTotals *s : { &result.all, &b }) {
+        s->events += 1;
+        s->candidates += nY;
+        s->seconds += bench::Seconds(t0, t1);
+        for (int i = 0; i < ReaderStats::kNStages; ++i) {
+          s->stage_seconds[i] += after[i] - before[i];
+          s->stage_perf[i] += event_stage_perf[i];
+        }
+        s->perf += perf;
+      }
+    }
+    std::copy(after, after + ReaderStats::kNStages, before);
+  }
+  r.set_stage_observer(nullptr);
+}
+
+void WritePerf(bench::JsonWriter &json, const PerfCounters::Values &perf, long events) {
+  json.begin_object();
+  for (int c = 0; c < PerfCounters::kNCounters; ++c) {
+    if (!perf_counters->is_available(c)) continue;
+    json.field(PerfCounters::name(c), perf.v[c] / events);
+  }
+  json.end_object();
+}
+
+void WriteTotals(bench::JsonWriter &json, const StageTotals &s, int nstages) {
+  json.field("events", s.events);
+  json.field("candidates", s.candidates);
+  json.field("seconds", s.seconds);
+  json.field("events_per_second", s.seconds > 0 ? s.events / s.seconds : 0.0);
+  json.field("candidates_per_second", s.seconds > 0 ? s.candidates / s.seconds : 0.0);
+  json.key("stages");
+  json.begin_object();
+  for (int i = 0; i < nstages; ++i) {
+    json.field(ReaderStats::stage_name(static_cast<ReaderStats::Stage>(i)), s.stage_seconds[i]);
+  }
+  json.end_object();
+
+  // Per event averages of the counters that opened, of the whole call
+  // and of each stage.
+  if (perf_counters && s.events > 0) {
+    json.key("perf_per_event");
+    json.begin_object();
+    json.key("next_record");
+    WritePerf(json, s.perf, s.events);
+    for (int i = 0; i < nstages; ++i) {
+      json.key(ReaderStats::stage_name(static_cast<ReaderStats::Stage>(i)));
+      WritePerf(json, s.stage_perf[i], s.events);
+    }
+    json.end_object();
+  }
+}
+
+void WriteResult(bench::JsonWriter &json, const ReaderResult &result, int nstages) {
+  json.begin_object();
+  json.field("reader", result.reader);
+  json.field("skipped_events", result.skipped);
+  WriteTotals(json, result.all, nstages);
+  json.key("buckets");
+  json.begin_array();
+  for (const auto &b : result.buckets) {
+    json.begin_object();
+    json.field("nY", b.first.first);
+    json.field("mcLen", b.first.second);
+    WriteTotals(json, b.second, nstages);
+    json.end_object();
+  }
+  json.end_array();
+  json.end_object();
+}
+
+// End to end throughput of BDtaunuReader and BDtaunuMcReader with a
+// per stage breakdown of next_record(), bucketed by nY and mcLen. The
+// stages are timed by the readers themselves, so the library must be
+// built with statistics; see ReaderStats.
+//
+// Without input files, a synthetic ntuple is generated with the given
+// number of events, seed, and nY range so that runs are reproducible.
+//
+// With -p, hardware counters are read around each next_record() and
+// around each of its stages, through a ReaderStats::StageObserver, and
+// reported as per event averages of the call and of every stage. The
+// counter reads of the stages fall outside the stage times but inside
+// the time of the call. Counters that cannot be opened, e.g. in containers
+// or with a restrictive perf_event_paranoid, are listed with the reason
+// and left out; timing is unaffected.
+//
+// Usage: reader_bench [-n nevents] [-s seed] [-y nY_min nY_max] [-p] [-l label] [-o output.json] [file1.root ...]
+int main(int argc, char **argv) {
+
+  int nevents = 2000;
+  unsigned seed = 1;
+  int nY_min = 0, nY_max = 200;
+  bool perf = false;
+  string label;
+  string output_fname;
+  vector<string> fnames;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-n" && i + 1 < argc) {
+      nevents = atoi(argv[++i]);
+    } else if (arg == "-s" && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "-y" && i + 2 < argc) {
+      nY_min = atoi(argv[++i]);
+      nY_max = atoi(argv[++i]);
+    } else if (arg == "-p") {
+      perf = true;
+    } else if (arg == "-l" && i + 1 < argc) {
+      label = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_fname = argv[++i];
+    } else if (arg[0] == '-') {
+      cerr << "usage: " << argv[0];
+      cerr << " [-n nevents] [-s seed] [-y nY_min nY_max] [-p] [-l label] [-o output.json] [file1.root ...]" << endl;
+      return EXIT_FAILURE;
+    } else {
+      fnames.push_back(arg);
+    }
+  }
+
+  if (!ReaderStats::enabled) {
+    cerr << "reader_bench: the library was built without statistics (STATS=0)" << endl;
+    return EXIT_FAILURE;
+  }
+
+  bool generated = fnames.empty();
+  if (generated) {
+    string fname = "/tmp/reader_bench_" + to_string(seed) + ".root";
+    NtupleGenerator generator(seed);
+    generator.set_nY_range(nY_min, nY_max);
+    generator.set_continuum_fraction(0.2);
+    generator.write(fname.c_str(), nevents);
+    fnames.push_back(fname);
+  }
+
+  PerfCounters counters;
+  if (perf) {
+    if (counters.open() == 0) {
+      cerr << "reader_bench: no hardware counters available: ";
+      cerr << counters.get_error(PerfCounters::kCycles) << endl;
+    }
+    perf_counters = &counters;
+  }
+
+  ReaderResult reco_result, mc_result;
+  reco_result.reader = "BDtaunuReader";
+  mc_result.reader = "BDtaunuMcReader";
+  for (const auto &fname : fnames) {
+    BDtaunuReader reco_reader(fname.c_str());
+    Run(reco_reader, reco_result, [] { return string("all"); });
+    BDtaunuMcReader mc_reader(fname.c_str());
+    mc_reader.set_result_cache(nullptr);
+    Run(mc_reader, mc_result, [&mc_reader] { return bench::Bucket(mc_reader.get_mcLen(), mcLen_edges); });
+  }
+
+  ofstream output;
+  if (!output_fname.empty()) output.open(output_fname);
+  bench::JsonWriter json(output_fname.empty() ? cout : output);
+
+  json.begin_object();
+  json.field("benchmark", "reader_bench");
+  json.field("label", label);
+  json.key("input");
+  json.begin_object();
+  json.field("generated", generated);
+  if (generated) {
+    json.field("nevents", nevents);
+    json.field("seed", static_cast<unsigned long>(seed));
+    json.field("nY_min", nY_min);
+    json.field("nY_max", nY_max);
+  }
+  json.key("files");
+  json.begin_array();
+  for (const auto &f : fnames) json.value(f);
+  json.end_array();
+  json.end_object();
+  if (perf) {
+    json.key("perf_counters");
+    json.begin_object();
+    for (int c = 0; c < PerfCounters::kNCounters; ++c) {
+      if (counters.is_available(c)) json.field(PerfCounters::name(c), "available");
+      else json.field(PerfCounters::name(c), counters.get_error(c));
+    }
+    json.end_object();
+  }
+  json.key("results");
+  json.begin_array();
+  WriteResult(json, reco_result, ReaderStats::kFillRecoInfo + 1);
+  WriteResult(json, mc_result, ReaderStats::kNStages);
+  json.end_array();
+  json.end_object();
+
+  return 0;
+}
@@ -0,0 +1,479 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <cmath>
+#include <cstdlib>
+
+#include <sys/resource.h>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuDef.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/ReaderStats.h>
+
+#include "BenchUtils.h"
+
+using namespace std;
+using namespace bdtaunu;
+using bench::Clock;
+
+// Heap tracking
+// -------------
+// Every allocation carries its size in a header so that the live heap,
+// its peak during a stage, and the bytes allocated can be followed.
+
+static const size_t alloc_header = 16;
+static size_t live_bytes = 0;
+static size_t peak_bytes = 0;
+static size_t allocated_bytes = 0;
+
+void *operator new(size_t n) {
+  char *p = static_cast<char*>(malloc(n + alloc_header));
+  if (p == nullptr) throw bad_alloc();
+  *reinterpret_cast<size_t*>(p) = n;
+  live_bytes += n;
+  allocated_bytes += n;
+  if (live_bytes > peak_bytes) peak_bytes = live_bytes;
+  return p + alloc_header;
+}
+
+void operator delete(void *p) noexcept {
+  if (p == nullptr) return;
+  char *q = static_cast<char*>(p) - alloc_header;
+  live_bytes -= *reinterpret_cast<size_t*>(q);
+  free(q);
+}
+
+// Event shapes
+// ------------
+
+// How the MC tree is filled past its 17 particle core.
+enum class McFill {
+  kWide,  // Photons radiated by the final state particles.
+  kDeep,  // A single bremsstrahlung chain, e -> e gamma -> ...
+};
+
+const int mc_core_length = 17;
+
+// Multiplicities of an adversarial event.
+//
+// Reco: Y -> tag B (D0 e) and signal B (D0 pi), D0 -> K pi, and pi0 ->
+// gamma gamma. Y's take distinct (tag, signal) pairs, and B's and D's
+// reuse their daughters round robin, so fewer sub-candidates mean more
+// sharing.
+//
+// MC: Y(4S) -> B- B+, B- -> D0 e nu, B+ -> anti-D0 tau nu, tau -> pi nu,
+// D -> K pi, then filled to mcLen per McFill. Every particle past the
+// core is a cleave vertex of TruthMatchManager::ContractMcGraph().
+// Every reco track points at the MC particle of its Lund ID, so every
+// D and B reaches the MC graph scan of MatchCompositeState().
+struct Shape {
+  string name;
+  double scale;
+  int nY, nTagB, nSigB, nD, nK, nPiPlus, nPiMinus, nl, nC, ngamma;
+  McFill mc_fill;
+  int mcLen;
+
+  int nB() const { return nTagB + nSigB; }
+  int nh() const { return nK + nPiPlus + nPiMinus; }
+};
+
+// Per event samples of one shape. A stage is only sampled in events
+// that reach it.
+struct ShapeResult {
+  Shape shape;
+  bool accepted = true;
+  vector<double> seconds[ReaderStats::kNStages];
+  vector<double> total_seconds;
+  size_t peak_heap_growth = 0;
+  size_t allocated_bytes = 0;
+  size_t stage_peak_heap_growth[ReaderStats::kNStages] = {};
+  size_t stage_allocated_bytes[ReaderStats::kNStages] = {};
+};
+
+int Scaled(int n, double scale, int min) {
+  return max(min, static_cast<int>(lround(n * scale)));
+}
+
+Shape SmallReco(const string &name, double scale) {
+  return { name, scale, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, McFill::kWide, mc_core_length };
+}
+
+// Shapes at fractions of the caps, so that growth with multiplicity can
+// be read off, plus one shape at each cap.
+vector<Shape> Shapes() {
+
+  vector<Shape> shapes;
+  for (double s : { 0.125, 0.25, 0.5, 1.0 }) {
+
+    // Every block just below its cap.
+    shapes.push_back({ "max_multiplicity", s,
+        Scaled(799, s, 1), Scaled(200, s, 1), Scaled(199, s, 1),
+        Scaled(199, s, 1), Scaled(33, s, 1), Scaled(33, s, 1), Scaled(33, s, 1),
+        Scaled(99, s, 1), Scaled(99, s, 1), Scaled(99, s, 2),
+        McFill::kWide, Scaled(99, s, mc_core_length) });
+
+    // As many Y's as possible built from one D and one of each track.
+    int nY = Scaled(799, s, 1);
+    int nTagB = static_cast<int>(ceil(sqrt(nY)));
+    shapes.push_back({ "shared_subcandidates", s,
+        nY, nTagB, (nY + nTagB - 1) / nTagB, 1, 1, 1, 1, 1, 0, 0,
+        McFill::kWide, 99 });
+
+    Shape deep = SmallReco("deep_mc", s);
+    deep.mc_fill = McFill::kDeep;
+    deep.mcLen = Scaled(99, s, mc_core_length);
+    shapes.push_back(deep);
+
+    Shape cleave = SmallReco("cleave_mc", s);
+    cleave.mcLen = Scaled(99, s, mc_core_length);
+    shapes.push_back(cleave);
+  }
+
+  // At the caps. The reco cap is rejected by the reader; a 100 particle
+  // MC tree is the largest one accepted.
+  Shape reco_cap = shapes[shapes.size() - 4];
+  reco_cap.name = "at_reco_cap";
+  reco_cap.nY = 800;
+  shapes.push_back(reco_cap);
+
+  Shape mc_cap = SmallReco("at_mc_cap", 1.0);
+  mc_cap.mcLen = 100;
+  shapes.push_back(mc_cap);
+
+  return shapes;
+}
+
+// Adversarial events
+// ------------------
+
+// MC particles are decayed in the order they are added, so the tree is
+// breadth first like BtaTupleMaker's.
+void FillMc(NtupleGenerator::Event &e, McFill fill, int mcLen) {
+
+  auto add = [&e] (int lund, int moth) {
+    e.mc_lund.push_back(lund);
+    e.mc_moth.push_back(moth);
+  };
+
+  add(eLund, -1);
+  add(-eLund, -1);
+  add(UpsilonLund, -1);
+
+  // Particles past the core: photons left to radiate and the final
+  // state particles left to radiate them for McFill::kWide, or
+  // particles left in the chain for McFill::kDeep.
+  int nfill = mcLen - mc_core_length;
+  int nhosts = 6;
+
+  for (int i = 2; i < static_cast<int>(e.mc_lund.size()); ++i) {
+    int lund = e.mc_lund[i];
+    int moth_lund = e.mc_lund[e.mc_moth[i]];
+    vector<int> d;
+    switch (lund) {
+      case UpsilonLund: d = { -BcLund, BcLund }; break;
+      case -BcLund: d = { D0Lund, eLund, -nu_eLund }; break;
+      case BcLund: d = { -D0Lund, -tauLund, nu_tauLund }; break;
+      case D0Lund: d = { -KLund, piLund }; break;
+      case -D0Lund: d = { KLund, -piLund }; break;
+      case -tauLund: d = { piLund, -nu_tauLund }; break;
+    }
+
+    switch (fill) {
+      case McFill::kWide:
+        if (abs(lund) == eLund || abs(lund) == KLund || abs(lund) == piLund) {
+          d.assign(nfill / nhosts, gammaLund);
+          nfill -= d.size();
+          --nhosts;
+        }
+        break;
+
+      // The chain starts at the e- from the B- and continues
+      // through the e- of each step.
+      case McFill::kDeep:
+        if (lund == eLund && (moth_lund == -BcLund || moth_lund == eLund)) {
+          if (nfill >= 2) d = { eLund, gammaLund };
+          else if (nfill == 1) d = { gammaLund };
+          nfill -= d.size();
+        }
+        break;
+    }
+
+    for (auto l : d) add(l, i);
+  }
+}
+
+int FindMc(const NtupleGenerator::Event &e, int lund) {
+  for (int i = 2; i < static_cast<int>(e.mc_lund.size()); ++i) {
+    if (e.mc_lund[i] == lund) return i;
+  }
+  return -1;
+}
+
+NtupleGenerator::Event MakeEvent(const Shape &s) {
+
+  NtupleGenerator::Event e;
+  FillMc(e, s.mc_fill, s.mcLen);
+  int mcK = FindMc(e, -KLund);
+  int mcPiPlus = FindMc(e, piLund);
+  int mcPiMinus = FindMc(e, -piLund);
+  int mcE = FindMc(e, eLund);
+
+  // Tracks: K-, then pi+, then pi-.
+  for (int i = 0; i < s.nh(); ++i) {
+    bool is_K = (i < s.nK);
+    bool is_pip = !is_K && (i < s.nK + s.nPiPlus);
+    e.h.push_back({ is_K ? -KLund : (is_pip ? piLund : -piLund),
+                    is_K ? mcK : (is_pip ? mcPiPlus : mcPiMinus), {}, {} });
+  }
+  for (int i = 0; i < s.nl; ++i) e.l.push_back({ eLund, mcE, {}, {} });
+  for (int i = 0; i < s.ngamma; ++i) e.gamma.push_back({ gammaLund, -1, {}, {} });
+
+  for (int i = 0; i < s.nC; ++i) {
+    e.C.push_back({ pi0Lund, -1, { gammaLund, gammaLund },
+                    { i % s.ngamma, (i + 1) % s.ngamma } });
+  }
+
+  for (int i = 0; i < s.nD; ++i) {
+    e.D.push_back({ D0Lund, -1, { -KLund, piLund },
+                    { i % s.nK, s.nK + (i / s.nK) % s.nPiPlus } });
+  }
+
+  for (int i = 0; i < s.nB(); ++i) {
+    bool tag = (i < s.nTagB);
+    e.B.push_back({ -BcLund, -1, { D0Lund, tag ? eLund : -piLund },
+                    { i % s.nD, tag ? i % s.nl : s.nK + s.nPiPlus + (i - s.nTagB) % s.nPiMinus } });
+  }
+
+  for (int i = 0; i < s.nY; ++i) {
+    e.Y.push_back({ UpsilonLund, -1, { -BcLund, -BcLund },
+                    { i % s.nTagB, s.nTagB + (i / s.nTagB) % s.nSigB } });
+  }
+
+  return e;
+}
+
+// Timing
+// ------
+
+// Number of times each stage has run, and the time spent in it.
+struct StageTotals {
+  unsigned long long count[ReaderStats::kNStages];
+  double seconds[ReaderStats::kNStages];
+};
+
+StageTotals Totals(const RootReader &r) {
+  StageTotals totals;
+  ReaderStats s = r.stats();
+  for (int i = 0; i < ReaderStats::kNStages; ++i) {
+    totals.count[i] = s.stage_latency[i].get_count();
+    totals.seconds[i] = s.stage_latency[i].get_total_seconds();
+  }
+  return totals;
+}
+
+// Follows the heap through each stage of next_record(): the peak is
+// reset when a stage starts, and its growth over the live heap at the
+// start is read when the stage stops. The peak across the stage is
+// folded back in so that the peak of the whole call still holds.
+class StageHeap : public ReaderStats::StageObserver {
+
+  public:
+    void stage_started() {
+      outer_peak = peak_bytes;
+      base = live_bytes;
+      allocated = allocated_bytes;
+      peak_bytes = live_bytes;
+    }
+
+    void stage_stopped(ReaderStats::Stage stage) {
+      peak_growth[stage] = max(peak_growth[stage], peak_bytes - base);
+      allocated_growth[stage] += allocated_bytes - allocated;
+      peak_bytes = max(peak_bytes, outer_peak);
+    }
+
+    //! Peak heap growth and bytes allocated of each stage since the last call.
+    void take(size_t *peak, size_t *allocated) {
+      for (int i = 0; i < ReaderStats::kNStages; ++i) {
+        peak[i] = peak_growth[i];
+        allocated[i] = allocated_growth[i];
+        peak_growth[i] = allocated_growth[i] = 0;
+      }
+    }
+
+  private:
+    size_t outer_peak = 0;
+    size_t base = 0;
+    size_t allocated = 0;
+    size_t peak_growth[ReaderStats::kNStages] = {};
+    size_t allocated_growth[ReaderStats::kNStages] = {};
+};
+
+// Read every event with next_record(); the first one is an untimed
+// warm up. The time of each stage of an event is the growth of the
+// reader's stage totals across the call.
+void Run(BDtaunuMcReader &r, ShapeResult &result) {
+
+  StageHeap stage_heap;
+  r.set_stage_observer(&stage_heap);
+  size_t stage_peak[ReaderStats::kNStages], stage_allocated[ReaderStats::kNStages];
+
+  bool warmup = true;
+  StageTotals before = Totals(r);
+  while (true) {
+    size_t base = live_bytes;
+    size_t allocated = allocated_bytes;
+    peak_bytes = live_bytes;
+    Clock::time_point t0 = Clock::now();
+    RootReader::Status status = r.next_record();
+    Clock::time_point t1 = Clock::now();
+    stage_heap.take(stage_peak, stage_allocated);
+    if (status == RootReader::Status::kEOF) break;
+
+    StageTotals after = Totals(r);
+    result.accepted = (status == RootReader::Status::kReadSucceeded);
+    if (!warmup) {
+      for (int i = 0; i < ReaderStats::kNStages; ++i) {
+        if (after.count[i] == before.count[i]) continue;
+        result.seconds[i].push_back(after.seconds[i] - before.seconds[i]);
+        result.stage_peak_heap_growth[i] = max(result.stage_peak_heap_growth[i], stage_peak[i]);
+        result.stage_allocated_bytes[i] = max(result.stage_allocated_bytes[i], stage_allocated[i]);
+      }
+      result.total_seconds.push_back(bench::Seconds(t0, t1));
+      result.peak_heap_growth = max(result.peak_heap_growth, peak_bytes - base);
+      result.allocated_bytes = max(result.allocated_bytes, allocated_bytes - allocated);
+    }
+    warmup = false;
+    before = after;
+  }
+  r.set_stage_observer(nullptr);
+}
+
+void WriteSummary(bench::JsonWriter &json, const vector<double> &seconds) {
+  bench::Summary s = bench::Summarize(seconds);
+  json.field("p50_us", 1e6 * s.median);
+  json.field("p99_us", 1e6 * s.p99);
+  json.field("max_us", 1e6 * s.max);
+}
+
+void WriteResult(bench::JsonWriter &json, const ShapeResult &result) {
+  const Shape &s = result.shape;
+  json.begin_object();
+  json.field("shape", s.name);
+  json.field("scale", s.scale);
+  json.field("mc_fill", s.mc_fill == McFill::kWide ? "wide" : "deep");
+  json.field("nY", s.nY);
+  json.field("nB", s.nB());
+  json.field("nD", s.nD);
+  json.field("nC", s.nC);
+  json.field("nh", s.nh());
+  json.field("nl", s.nl);
+  json.field("ngamma", s.ngamma);
+  json.field("mcLen", s.mcLen);
+  json.field("accepted", result.accepted);
+  json.field("events", static_cast<unsigned long>(result.total_seconds.size()));
+  json.key("total");
+  json.begin_object();
+  WriteSummary(json, result.total_seconds);
+  json.field("peak_heap_growth_bytes", static_cast<unsigned long>(result.peak_heap_growth));
+  json.field("allocated_bytes", static_cast<unsigned long>(result.allocated_bytes));
+  json.end_object();
+  json.key("stages");
+  json.begin_array();
+  for (int i = 0; i < ReaderStats::kNStages; ++i) {
+    if (result.seconds[i].empty()) continue;
+    json.begin_object();
+    json.field("stage", ReaderStats::stage_name(static_cast<ReaderStats::Stage>(i)));
+    WriteSummary(json, result.seconds[i]);
+    json.field("peak_heap_growth_bytes", static_cast<unsigned long>(result.stage_peak_heap_growth[i]));
+    json.field("allocated_bytes", static_cast<unsigned long>(result.stage_allocated_bytes[i]));
+    json.end_object();
+  }
+  json.end_array();
+  json.end_object();
+}
+
+// Worst case latency of BDtaunuMcReader::next_record() per stage.
+//
+// Adversarial events are built at fractions of the BtaTupleMaker caps
+// (800 Y, 400 B, 200 D, 100 C/h/l/gamma, 100 MC particles), just below
+// them, and at them:
+//
+// * max_multiplicity: every block just below its cap.
+// * shared_subcandidates: up to 799 Y's built on a single D and track.
+// * deep_mc: a 40 step bremsstrahlung chain in the MC tree.
+// * cleave_mc: an MC tree that is mostly cleave vertices.
+// * at_reco_cap: 800 Y's, which the reader rejects.
+// * at_mc_cap: a 100 particle MC tree, the largest the reader accepts.
+//
+// Each shape is written to an ntuple `-n` + 1 times and read back with
+// next_record(); the first event is an untimed warm up. Per stage p50,
+// p99, and max latency, taken from the reader's ReaderStats, and the
+// largest per event peak heap growth and bytes allocated, of each stage
+// and of the whole next_record() call, are written as JSON; comparing
+// scales exposes super-linear stages. Reading the event is timed as get_entry, apart
+// from the stages that follow it.
+//
+// Usage: stress_bench [-n repetitions] [-l label] [-o output.json]
+int main(int argc, char **argv) {
+
+  int repetitions = 100;
+  string label;
+  string output_fname;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-n" && i + 1 < argc) {
+      repetitions = atoi(argv[++i]);
+    } else if (arg == "-l" && i + 1 < argc) {
+      label = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_fname = argv[++i];
+    } else {
+      cerr << "usage: " << argv[0] << " [-n repetitions] [-l label] [-o output.json]" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!ReaderStats::enabled) {
+    cerr << "stress_bench: the library was built without statistics (STATS=0)" << endl;
+    return EXIT_FAILURE;
+  }
+
+  const char *fname = "/tmp/stress_bench.root";
+  vector<ShapeResult> results;
+  for (const auto &shape : Shapes()) {
+    NtupleGenerator generator;
+    generator.write(fname, vector<NtupleGenerator::Event>(repetitions + 1, MakeEvent(shape)));
+
+    ShapeResult result;
+    result.shape = shape;
+    BDtaunuMcReader reader(fname);
+    reader.set_result_cache(nullptr);
+    Run(reader, result);
+    results.push_back(result);
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  ofstream output;
+  if (!output_fname.empty()) output.open(output_fname);
+  bench::JsonWriter json(output_fname.empty() ? cout : output);
+
+  json.begin_object();
+  json.field("benchmark", "stress_bench");
+  json.field("label", label);
+  json.field("repetitions", repetitions);
+  json.field("max_rss_kb", usage.ru_maxrss);
+  json.key("results");
+  json.begin_array();
+  for (const auto &result : results) WriteResult(json, result);
+  json.end_array();
+  json.end_object();
+
+  return 0;
+}
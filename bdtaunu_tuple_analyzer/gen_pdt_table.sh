@@ -0,0 +1,64 @@
+#!/bin/sh
+#
+# Compiles the particle data table into a C++ header.
+#
+# usage: gen_pdt_table.sh pdt.dat > PdtTable.h
+#
+# Each line of pdt.dat is: "particle name" lundId. The output defines
+# two constexpr arrays of bdtaunu::PdtEntry holding every line; one
+# sorted by lundId and one sorted by name in strcmp order, so that both
+# directions can be binary searched.
+
+set -e
+
+if [ $# -ne 1 ] || [ ! -r "$1" ]; then
+  echo "usage: $0 pdt.dat" >&2
+  exit 1
+fi
+
+pdt_file=$1
+n=$(awk 'NF == 2' "$pdt_file" | wc -l | tr -d ' ')
+
+if [ "$n" -eq 0 ]; then
+  echo "$0: no entries in $pdt_file" >&2
+  exit 1
+fi
+
+cat <<EOF
+// Generated by gen_pdt_table.sh from pdt.dat. Do not edit.
+
+#ifndef __PDTTABLE_H__
+#define __PDTTABLE_H__
+
+#include "BDtaunuUtils.h"
+
+namespace bdtaunu {
+
+namespace pdt {
+
+constexpr int kNEntries = $n;
+
+// Sorted by lundId.
+constexpr PdtEntry kByLund[kNEntries] = {
+EOF
+awk 'NF == 2 { print $2, $1 }' "$pdt_file" | LC_ALL=C sort -n -k1,1 | \
+  awk '{ printf "  { %d, \"%s\" },\n", $1, $2 }'
+
+cat <<EOF
+};
+
+// Sorted by particle name in strcmp order.
+constexpr PdtEntry kByName[kNEntries] = {
+EOF
+awk 'NF == 2' "$pdt_file" | LC_ALL=C sort -k1,1 | \
+  awk '{ printf "  { %d, \"%s\" },\n", $2, $1 }'
+
+cat <<EOF
+};
+
+}
+
+}
+
+#endif
+EOF
@@ -0,0 +1,96 @@
+#ifndef __TESTUTILS_H__
+#define __TESTUTILS_H__
+
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/UpsilonCandidate.h>
+
+/** @file TestUtils.h
+ *  @brief Helpers shared by the tests.
+ */
+
+namespace testutils {
+
+//! Every feature of a candidate, separated by colons.
+/*! Floats are written with enough digits to tell any two apart. */
+inline std::string CandidateSummary(const UpsilonCandidate &cand) {
+  std::ostringstream os;
+  os.precision(9);
+  os << cand.get_eventId();
+  os << ":" << cand.get_block_index();
+  os << ":" << cand.get_reco_index();
+  os << ":" << cand.get_truth_match();
+  os << ":" << static_cast<int>(cand.get_bflavor());
+  os << ":" << static_cast<int>(cand.get_cand_type());
+  os << ":" << static_cast<int>(cand.get_sample_type());
+  os << ":" << cand.get_eextra50();
+  os << ":" << cand.get_mmiss_prime2();
+  os << ":" << cand.get_cosThetaT();
+  os << ":" << cand.get_tag_lp3();
+  os << ":" << cand.get_tag_cosBY();
+  os << ":" << cand.get_tag_cosThetaDl();
+  os << ":" << cand.get_tag_Dmass();
+  os << ":" << cand.get_tag_deltaM();
+  os << ":" << cand.get_tag_cosThetaDSoft();
+  os << ":" << cand.get_tag_softP3MagCM();
+  os << ":" << static_cast<int>(cand.get_tag_d_mode());
+  os << ":" << static_cast<int>(cand.get_tag_dstar_mode());
+  os << ":" << cand.get_l_ePidMap();
+  os << ":" << cand.get_l_muPidMap();
+  os << ":" << cand.get_sig_hp3();
+  os << ":" << cand.get_sig_cosBY();
+  os << ":" << cand.get_sig_cosThetaDtau();
+  os << ":" << cand.get_sig_vtxB();
+  os << ":" << cand.get_sig_Dmass();
+  os << ":" << cand.get_sig_deltaM();
+  os << ":" << cand.get_sig_cosThetaDSoft();
+  os << ":" << cand.get_sig_softP3MagCM();
+  os << ":" << cand.get_sig_hmass();
+  os << ":" << cand.get_sig_vtxh();
+  os << ":" << static_cast<int>(cand.get_sig_d_mode());
+  os << ":" << static_cast<int>(cand.get_sig_dstar_mode());
+  os << ":" << static_cast<int>(cand.get_sig_tau_mode());
+  os << ":" << cand.get_h_ePidMap();
+  os << ":" << cand.get_h_muPidMap();
+  return os.str();
+}
+
+//! One line that identifies the current event and everything derived from it.
+/*! Two reads of an event agree if and only if their summaries do. */
+inline std::string Summary(const BDtaunuMcReader &reader, RootReader::Status status) {
+  std::string e = reader.get_eventId() + " " + std::to_string(static_cast<int>(status));
+  e += " " + std::to_string(static_cast<int>(reader.get_b1_mctype()));
+  e += " " + std::to_string(static_cast<int>(reader.get_b2_mctype()));
+  e += " " + std::to_string(static_cast<int>(reader.get_b1_tau_mctype()));
+  e += " " + std::to_string(static_cast<int>(reader.get_b2_tau_mctype()));
+  e += " " + std::to_string(reader.get_b1_signature());
+  e += " " + std::to_string(reader.get_b2_signature());
+  e += " " + std::to_string(reader.get_upsilon_candidates().size());
+  for (const auto &cand : reader.get_upsilon_candidates()) e += " " + CandidateSummary(cand);
+  return e;
+}
+
+//! Write `nfiles` synthetic ntuples of `nevents` events each.
+/*! File `i` is `/tmp/<name>_<i>.root`, is generated with seed
+ * `seed + i`, and has upper event ID `i`, so that event IDs are unique
+ * across the files. Returns the file names. */
+inline std::vector<std::string> WriteNtuples(
+    const std::string &name, int nfiles, int nevents, unsigned seed, int nY_max) {
+  std::vector<std::string> fnames;
+  for (int i = 0; i < nfiles; ++i) {
+    fnames.push_back("/tmp/" + name + "_" + std::to_string(i) + ".root");
+    NtupleGenerator generator(seed + i);
+    generator.set_nY_range(0, nY_max);
+    generator.set_upperID(i);
+    generator.write(fnames.back().c_str(), nevents);
+  }
+  return fnames;
+}
+
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuDef.h>
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/ArrowExport.h>
+
+using namespace std;
+
+// The child of a struct array named `name`.
+int FindChild(const ArrowSchema &schema, const string &name) {
+  for (int64_t i = 0; i < schema.n_children; ++i) {
+    if (name == schema.children[i]->name) return i;
+  }
+  return -1;
+}
+
+bool IsValid(const ArrowArray &a, int64_t row) {
+  const uint8_t *bits = static_cast<const uint8_t*>(a.buffers[0]);
+  return !bits || (bits[row / 8] >> (row % 8) & 1);
+}
+
+template <typename T> T Value(const ArrowArray &a, int64_t row) {
+  return static_cast<const T*>(a.buffers[1])[row];
+}
+
+// Entry `i` of a utf8 array.
+string String(const ArrowArray &a, int64_t i) {
+  const int32_t *offsets = static_cast<const int32_t*>(a.buffers[1]);
+  const char *data = static_cast<const char*>(a.buffers[2]);
+  return string(data + offsets[i], offsets[i + 1] - offsets[i]);
+}
+
+// Value of a dictionary encoded string column, or "" if null.
+template <typename Index>
+string DictValue(const ArrowArray &a, int64_t row) {
+  if (!IsValid(a, row)) return "";
+  return String(*a.dictionary, Value<Index>(a, row));
+}
+
+// Names of bdtaunu::CandType and bdtaunu::SampleType, by value.
+const vector<string> cand_type_names = {
+  "DDpi", "DDstarpi", "DstarDpi", "DstarDstarpi",
+  "DDrho", "DDstarrho", "DstarDrho", "DstarDstarrho" };
+const vector<string> sample_type_names = { "BcD", "BcDstar", "B0D", "B0Dstar" };
+
+// Export the candidates of a synthetic ntuple in batches of events, and
+// read them back through the C structs as any consumer would.
+int main() {
+
+  const string fname = "/tmp/arrow_test1.root";
+  NtupleGenerator generator(31415);
+  generator.set_nY_range(0, 20);
+  generator.write(fname.c_str(), 300);
+
+  BDtaunuMcReader reader(fname.c_str());
+  ArrowCandidateBatch batch(true);
+
+  // The candidates of the events of the current batch.
+  vector<string> eventIds;
+  vector<UpsilonCandidate> cands;
+  vector<int> nTrks;
+  vector<bdtaunu::McBTypeCatalogue::BMcType> b1_mctypes;
+
+  Long64_t nbatches = 0, ncands = 0;
+  bool eof = false;
+  while (!eof) {
+    eof = reader.next_record() == RootReader::Status::kEOF;
+    if (!eof) {
+      batch.append(reader);
+      for (const auto &cand : reader.get_upsilon_candidates()) {
+        eventIds.push_back(reader.get_eventId());
+        cands.push_back(cand);
+        nTrks.push_back(reader.get_nTrk());
+        b1_mctypes.push_back(reader.get_b1_mctype());
+      }
+      assert(batch.get_num_rows() == static_cast<Long64_t>(cands.size()));
+      if (batch.get_num_events() < 64) continue;
+    }
+
+    ArrowArray array;
+    ArrowSchema schema;
+    batch.export_batch(&array, &schema);
+    assert(batch.get_num_rows() == 0 && batch.get_num_events() == 0);
+
+    assert(string(schema.format) == "+s");
+    assert(array.length == static_cast<int64_t>(cands.size()));
+    assert(array.n_children == schema.n_children);
+
+    int eventId = FindChild(schema, "eventId");
+    int nTrk = FindChild(schema, "nTrk");
+    int eextra50 = FindChild(schema, "eextra50");
+    int sig_d_mode = FindChild(schema, "sig_d_mode");
+    int b1_mctype = FindChild(schema, "b1_mctype");
+    int continuum = FindChild(schema, "continuum");
+    int cand_type = FindChild(schema, "cand_type");
+    int sample_type = FindChild(schema, "sample_type");
+    assert(eventId >= 0 && nTrk >= 0 && eextra50 >= 0);
+    assert(sig_d_mode >= 0 && b1_mctype >= 0 && continuum >= 0);
+    assert(cand_type >= 0 && sample_type >= 0);
+
+    assert(string(schema.children[eventId]->format) == "i");
+    assert(string(schema.children[eventId]->dictionary->format) == "u");
+    assert(string(schema.children[nTrk]->format) == "i");
+    assert(string(schema.children[eextra50]->format) == "f");
+    assert(string(schema.children[sig_d_mode]->format) == "c");
+    assert(string(schema.children[sig_d_mode]->dictionary->format) == "u");
+    assert(string(schema.children[continuum]->format) == "b");
+    assert(string(schema.children[cand_type]->format) == "c");
+    assert(string(schema.children[sample_type]->dictionary->format) == "u");
+
+    for (int64_t i = 0; i < array.n_children; ++i) {
+      assert(array.children[i]->length == array.length);
+    }
+
+    Long64_t nnull = 0;
+    for (size_t row = 0; row < cands.size(); ++row) {
+      assert(DictValue<int32_t>(*array.children[eventId], row) == eventIds[row]);
+      assert(Value<int32_t>(*array.children[nTrk], row) == nTrks[row]);
+
+      const ArrowArray &e = *array.children[eextra50];
+      if (cands[row].get_eextra50() == -999) {
+        assert(!IsValid(e, row));
+        ++nnull;
+      } else {
+        assert(IsValid(e, row) && Value<float>(e, row) == cands[row].get_eextra50());
+      }
+
+      // Names are those of the enumerators; spot check with the values.
+      const ArrowArray &d = *array.children[sig_d_mode];
+      auto mode = cands[row].get_sig_d_mode();
+      assert(IsValid(d, row) == (mode != bdtaunu::RecoDTypeCatalogue::DType::null));
+      if (mode == bdtaunu::RecoDTypeCatalogue::DType::Dc_Kpipi) {
+        assert(DictValue<int8_t>(d, row) == "Dc_Kpipi");
+      }
+      if (mode == bdtaunu::RecoDTypeCatalogue::DType::D0_KK) {
+        assert(DictValue<int8_t>(d, row) == "D0_KK");
+      }
+      if (b1_mctypes[row] == bdtaunu::McBTypeCatalogue::BMcType::Dstartau) {
+        assert(DictValue<int8_t>(*array.children[b1_mctype], row) == "Dstartau");
+      }
+
+      const ArrowArray &ct = *array.children[cand_type];
+      auto ctype = cands[row].get_cand_type();
+      assert(IsValid(ct, row) == (ctype != bdtaunu::CandType::null));
+      if (ctype != bdtaunu::CandType::null) {
+        assert(DictValue<int8_t>(ct, row) == cand_type_names[static_cast<int>(ctype)]);
+      }
+
+      const ArrowArray &st = *array.children[sample_type];
+      auto stype = cands[row].get_sample_type();
+      assert(IsValid(st, row) == (stype != bdtaunu::SampleType::null));
+      if (stype != bdtaunu::SampleType::null) {
+        assert(DictValue<int8_t>(st, row) == sample_type_names[static_cast<int>(stype)]);
+      }
+    }
+
+    assert(array.children[eextra50]->null_count == nnull);
+
+    // The indices of eventId number the events of the batch.
+    if (array.length) {
+      assert(Value<int32_t>(*array.children[eventId], 0) == 0);
+      assert(array.children[eventId]->dictionary->length <= 64);
+    }
+
+    // Releasing the parents releases everything, and marks them released.
+    array.release(&array);
+    schema.release(&schema);
+    assert(!array.release && !schema.release);
+
+    ncands += cands.size();
+    eventIds.clear();
+    cands.clear();
+    nTrks.clear();
+    b1_mctypes.clear();
+    ++nbatches;
+  }
+  assert(nbatches > 1 && ncands > 0);
+
+  // The current event alone, from the reader.
+  BDtaunuMcReader one(fname.c_str());
+  while (one.next_record() != RootReader::Status::kEOF && one.get_upsilon_candidates().empty()) {}
+  ArrowArray array;
+  ArrowSchema schema;
+  one.export_candidates(&array, &schema);
+  assert(array.length == static_cast<int64_t>(one.get_upsilon_candidates().size()));
+  assert(FindChild(schema, "continuum") >= 0);
+  schema.release(&schema);
+  array.release(&array);
+
+  return 0;
+}
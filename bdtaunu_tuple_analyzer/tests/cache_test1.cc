@@ -0,0 +1,82 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/ReaderStats.h>
+
+using namespace std;
+
+// Read an entry range of a synthetic ntuple through the TTreeCache and
+// check that it sees the same events as a full read.
+int main() {
+
+  const char *fname = "/tmp/cache_test1.root";
+  const int nevents = 1000;
+  const int first = 250, last = 700;
+
+  NtupleGenerator generator(1357);
+  generator.set_nY_range(0, 50);
+  generator.write(fname, nevents);
+
+  // Full read with a cache sized from the baskets.
+  vector<string> eventIds;
+  vector<int> nYs;
+  BDtaunuMcReader reader(fname);
+  while (reader.next_record() != RootReader::Status::kEOF) {
+    eventIds.push_back(reader.get_eventId());
+    nYs.push_back(reader.get_upsilon_candidates().size());
+  }
+  assert(eventIds.size() == nevents);
+
+  ReaderStats stats = reader.stats();
+  stats.print(cout);
+  if (ReaderStats::enabled) {
+    assert(stats.cache_size > 0);
+    assert(stats.cache_read_calls > 0);
+    assert(stats.cache_efficiency >= 0 && stats.cache_efficiency <= 1);
+  }
+
+  // Entry range with an explicit cache size.
+  BDtaunuMcReader range_reader(fname);
+  range_reader.set_cache_size(4 << 20);
+  range_reader.set_entry_range(first, last);
+  int i = first;
+  while (range_reader.next_record() != RootReader::Status::kEOF) {
+    assert(range_reader.get_eventId() == eventIds[i]);
+    assert(static_cast<int>(range_reader.get_upsilon_candidates().size()) == nYs[i]);
+    ++i;
+  }
+  assert(i == last);
+  if (ReaderStats::enabled) assert(range_reader.stats().events_read == last - first);
+
+  // Cache counters restart with the other statistics.
+  range_reader.clear_stats();
+  ReaderStats cleared = range_reader.stats();
+  assert(cleared.events_read == 0);
+  assert(cleared.cache_read_calls == 0 && cleared.uncached_read_calls == 0);
+
+  // Over two files the cache counters of both are kept, and clearing
+  // them in the first file does not carry over to the second.
+  if (ReaderStats::enabled) {
+    const vector<string> fnames = { fname, fname };
+    BDtaunuMcReader two_reader(fnames);
+    while (two_reader.next_record() != RootReader::Status::kEOF) {}
+    ReaderStats two = two_reader.stats();
+    assert(two.cache_read_calls == 2 * stats.cache_read_calls);
+    assert(two.cache_bytes_read == 2 * stats.cache_bytes_read);
+    assert(two.uncached_read_calls == 2 * stats.uncached_read_calls);
+
+    BDtaunuMcReader cleared_reader(fnames);
+    for (int n = 0; n < nevents / 2; ++n) cleared_reader.next_record();
+    cleared_reader.clear_stats();
+    while (cleared_reader.next_record() != RootReader::Status::kEOF) {}
+    ReaderStats partial = cleared_reader.stats();
+    assert(partial.cache_read_calls >= stats.cache_read_calls);
+    assert(partial.cache_read_calls <= two.cache_read_calls);
+  }
+
+  return 0;
+}
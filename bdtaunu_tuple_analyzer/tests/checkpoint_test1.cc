@@ -0,0 +1,91 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/McYieldTally.h>
+
+using namespace std;
+
+string Write(const McYieldTable &table) {
+  ostringstream os;
+  table.write(os);
+  return os.str();
+}
+
+// Number of events a table was shown, whatever their status.
+unsigned long long Seen(const McYieldTable &table) {
+  return table.get_status_count(RootReader::Status::kReadSucceeded) +
+         table.get_status_count(RootReader::Status::kMaxRecoCandExceeded) +
+         table.get_status_count(RootReader::Status::kMaxMcParticlesExceeded);
+}
+
+// Stop a checkpointed tally again and again, restarting it each time
+// with a new tally object, and check that the final table is the one
+// of an uninterrupted run.
+int main() {
+
+  const vector<int> nevents = { 250, 120, 300 };
+  const int interval = 50;
+
+  vector<string> fnames;
+  for (size_t i = 0; i < nevents.size(); ++i) {
+    fnames.push_back("/tmp/checkpoint_test1_" + to_string(i) + ".root");
+    NtupleGenerator generator(300 + i);
+    generator.set_nY_range(0, 20);
+    generator.write(fnames.back().c_str(), nevents[i]);
+  }
+
+  McYieldTally uninterrupted(fnames);
+  uninterrupted.set_nthreads(2);
+  const string expected = Write(uninterrupted.run());
+  assert(uninterrupted.is_complete());
+
+  const string checkpoint = "/tmp/checkpoint_test1.ckpt";
+  remove(checkpoint.c_str());
+
+  // Every worker stops after its first checkpoint: with two threads,
+  // the first run reads one interval of each of the first two files.
+  int nruns = 0;
+  unsigned long long seen = 0;
+  bool complete = false;
+  while (!complete) {
+    McYieldTally tally(fnames);
+    tally.set_nthreads(2 - nruns % 2);
+    tally.set_checkpoint(checkpoint, interval);
+    tally.request_stop();
+    const McYieldTable &table = tally.run();
+    complete = tally.is_complete();
+
+    assert(Seen(table) > seen);
+    seen = Seen(table);
+    if (nruns == 0) assert(seen == 2 * interval);
+
+    ++nruns;
+    assert(nruns < 100);
+  }
+  assert(nruns > 2);
+
+  // The last run finished the table, and a rerun only reads the checkpoint.
+  McYieldTally rerun(fnames);
+  rerun.set_checkpoint(checkpoint, interval);
+  assert(Write(rerun.run()) == expected);
+  assert(rerun.is_complete());
+
+  // So does the table of a tally stopped and resumed repeatedly.
+  McYieldTally last(fnames);
+  last.set_checkpoint(checkpoint, interval);
+  remove(checkpoint.c_str());
+  for (int i = 0; i < 3; ++i) {
+    last.request_stop();
+    last.run();
+  }
+  assert(!last.is_complete());
+  assert(Write(last.run()) == expected);
+  assert(last.is_complete());
+
+  return 0;
+}
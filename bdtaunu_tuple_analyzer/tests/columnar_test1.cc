@@ -0,0 +1,190 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/ColumnarFile.h>
+#include <bdtaunu_tuple_analyzer/CandidateColumns.h>
+
+using namespace std;
+
+struct Row {
+  Long64_t id;
+  bool x_null;
+  float x;
+  bool mode_null;
+  int mode;
+  string name;
+};
+
+// Rows of a synthetic table. x grows with the row, so that the zone
+// maps of a chunk cover a narrow range.
+vector<Row> MakeRows(int n) {
+  vector<Row> rows;
+  for (int i = 0; i < n; ++i) {
+    Row r;
+    r.id = 10000000000LL + i;
+    r.x_null = (i % 17 == 0);
+    r.x = i * 0.01f + ((i * 7919) % 13) * 0.001f;
+    r.mode_null = (i % 5 == 0);
+    r.mode = (i * 31) % 7 - 1;
+    r.name = "event" + to_string(i / 3);
+    rows.push_back(r);
+  }
+  return rows;
+}
+
+// Write and read back a synthetic table, with and without compression,
+// and check that range cuts skip chunks but keep exactly the passing rows.
+void TestTable() {
+
+  const int nrows = 10000;
+  const int chunk_rows = 1000;
+  vector<Row> rows = MakeRows(nrows);
+
+  for (int level : { 0, 1 }) {
+    const string fname = "/tmp/columnar_test1_table.col";
+    {
+      ColumnarWriter w(fname, chunk_rows);
+      w.set_compression_level(level);
+      int id = w.add_column("id", ColumnType::kInt64);
+      int x = w.add_column("x", ColumnType::kFloat);
+      int mode = w.add_column("mode", ColumnType::kInt32, ColumnarWriter::Encoding::kDictionary);
+      int name = w.add_column("name", ColumnType::kString);
+      int empty = w.add_column("empty", ColumnType::kDouble);
+      assert(empty == 4);
+      for (const auto &r : rows) {
+        w.set(id, r.id);
+        if (!r.x_null) w.set(x, r.x);
+        if (!r.mode_null) w.set(mode, r.mode);
+        w.set(name, r.name);
+        w.end_row();
+      }
+      w.close();
+    }
+
+    // Everything reads back.
+    ColumnarReader all(fname);
+    assert(all.get_num_rows() == nrows);
+    assert(all.get_num_chunks() == nrows / chunk_rows);
+    assert(all.get_column_type(all.find_column("mode")) == ColumnType::kInt32);
+    assert(all.find_column("nonexistent") < 0);
+    int n = 0;
+    while (all.next_row()) {
+      const Row &r = rows[n];
+      assert(all.get_row_index() == n);
+      assert(all.get_int64(0) == r.id);
+      assert(all.is_null(1) == r.x_null);
+      if (!r.x_null) assert(all.get_float(1) == r.x);
+      assert(all.is_null(2) == r.mode_null);
+      if (!r.mode_null) assert(all.get_int32(2) == r.mode);
+      assert(all.get_string(3) == r.name);
+      assert(all.is_null(4));
+      ++n;
+    }
+    assert(n == nrows);
+
+    // Zone maps of the first chunk.
+    const ColumnStats &s = all.get_stats(0, 1);
+    assert(s.has_range && s.null_count == (chunk_rows + 16) / 17);
+    assert(s.min == rows[1].x && s.max <= 10.1);
+    assert(!all.get_stats(0, 4).has_range && all.get_stats(0, 4).null_count == chunk_rows);
+    assert(all.get_stats(0, 3).min_string == "event0");
+
+    // A narrow cut on x reads few chunks and finds every passing row.
+    ColumnarReader cut(fname);
+    cut.select_columns({ "id" });
+    cut.add_range("x", 25.0, 32.5);
+    cut.add_range("mode", 0, 3);
+    vector<Long64_t> expected, found;
+    for (const auto &r : rows) {
+      if (!r.x_null && r.x >= 25.0f && r.x <= 32.5f && !r.mode_null && r.mode >= 0 && r.mode <= 3) {
+        expected.push_back(r.id);
+      }
+    }
+    while (cut.next_row()) {
+      assert(cut.is_null(3));  // not selected
+      found.push_back(cut.get_int64(0));
+    }
+    assert(!expected.empty() && found == expected);
+    assert(cut.get_chunks_read() == 2 && cut.get_chunks_skipped() == 8);
+
+    // A cut no chunk can satisfy reads nothing.
+    cut.rewind();
+    cut.add_range("x", 1000, 2000);
+    assert(!cut.next_row());
+  }
+}
+
+// Write the candidates of a synthetic ntuple, and check them against the
+// reader.
+void TestCandidates() {
+
+  const string fname = "/tmp/columnar_test1.root";
+  const string col_fname = "/tmp/columnar_test1_cands.col";
+  NtupleGenerator generator(4242);
+  generator.set_nY_range(0, 20);
+  generator.write(fname.c_str(), 300);
+
+  vector<UpsilonCandidate> cands;
+  vector<int> b1_mctypes;
+  {
+    BDtaunuMcReader reader(fname.c_str());
+    CandidateColumnWriter writer(col_fname, true, 256);
+    while (reader.next_record() != RootReader::Status::kEOF) {
+      writer.write(reader);
+      for (const auto &c : reader.get_upsilon_candidates()) {
+        cands.push_back(c);
+        b1_mctypes.push_back(static_cast<int>(reader.get_b1_mctype()));
+      }
+    }
+    writer.close();
+  }
+  assert(!cands.empty());
+
+  ColumnarReader r(col_fname);
+  assert(r.get_num_rows() == static_cast<Long64_t>(cands.size()));
+  int eventId = r.find_column("eventId");
+  int eextra50 = r.find_column("eextra50");
+  int tag_Dmass = r.find_column("tag_Dmass");
+  int sig_tau_mode = r.find_column("sig_tau_mode");
+  int cand_type = r.find_column("cand_type");
+  int sample_type = r.find_column("sample_type");
+  int b1_mctype = r.find_column("b1_mctype");
+  size_t i = 0;
+  while (r.next_row()) {
+    const UpsilonCandidate &c = cands[i];
+    assert(r.get_string(eventId) == c.get_eventId());
+    assert(r.get_float(eextra50) == c.get_eextra50());
+    if (c.get_tag_Dmass() == -999) assert(r.is_null(tag_Dmass));
+    else assert(r.get_float(tag_Dmass) == c.get_tag_Dmass());
+    if (c.get_sig_tau_mode() == bdtaunu::TauType::null) assert(r.is_null(sig_tau_mode));
+    else assert(r.get_int32(sig_tau_mode) == static_cast<int>(c.get_sig_tau_mode()));
+    if (c.get_cand_type() == bdtaunu::CandType::null) assert(r.is_null(cand_type));
+    else assert(r.get_int32(cand_type) == static_cast<int>(c.get_cand_type()));
+    if (c.get_sample_type() == bdtaunu::SampleType::null) assert(r.is_null(sample_type));
+    else assert(r.get_int32(sample_type) == static_cast<int>(c.get_sample_type()));
+    if (b1_mctypes[i] == -1) assert(r.is_null(b1_mctype));
+    else assert(r.get_int32(b1_mctype) == b1_mctypes[i]);
+    ++i;
+  }
+  assert(i == cands.size());
+
+  // A cut on eextra50 keeps exactly the candidates that pass it.
+  ColumnarReader cut(col_fname);
+  cut.add_range("eextra50", 0, 0.5);
+  size_t npass = 0;
+  for (const auto &c : cands) npass += (c.get_eextra50() >= 0 && c.get_eextra50() <= 0.5);
+  size_t nfound = 0;
+  while (cut.next_row()) ++nfound;
+  assert(nfound == npass);
+}
+
+int main() {
+  TestTable();
+  TestCandidates();
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/ColumnarFile.h>
+#include <bdtaunu_tuple_analyzer/CandidateColumns.h>
+
+using namespace std;
+
+// Candidate features that both layouts share.
+const vector<string> features = { "block_index", "eextra50", "mmiss_prime2", "sig_d_mode",
+                                  "cand_type", "sample_type" };
+
+// Write the candidates of a synthetic ntuple in one table and in two,
+// and check that joining the two gives the one.
+int main() {
+
+  const string fname = "/tmp/columnar_test2.root";
+  const string flat_fname = "/tmp/columnar_test2_flat.col";
+  const string event_fname = "/tmp/columnar_test2_events.col";
+  const string cand_fname = "/tmp/columnar_test2_cands.col";
+
+  NtupleGenerator generator(2718);
+  generator.set_nY_range(0, 20);
+  generator.write(fname.c_str(), 400);
+
+  Long64_t nevents = 0;
+  {
+    BDtaunuMcReader reader(fname.c_str());
+    CandidateColumnWriter flat(flat_fname, true, 512);
+    CandidateColumnWriter normalized(event_fname, cand_fname, true, 512);
+    assert(!flat.get_event_writer() && normalized.get_event_writer());
+    while (reader.next_record() != RootReader::Status::kEOF) {
+      flat.write(reader);
+      normalized.write(reader);
+      ++nevents;
+    }
+    flat.close();
+    normalized.close();
+  }
+
+  ColumnarReader f(flat_fname), e(event_fname), c(cand_fname);
+  assert(e.get_num_rows() == nevents);
+  assert(c.get_num_rows() == f.get_num_rows() && c.get_num_rows() > 0);
+  assert(c.find_column("eventId") < 0 && c.find_column("nTrk") < 0);
+  assert(f.find_column("event_row") < 0);
+
+  // Load the event table.
+  vector<string> eventIds;
+  vector<int> nTrks, b1_mctypes;
+  vector<Long64_t> first_candidates;
+  vector<int> ncandidates;
+  Long64_t total = 0;
+  while (e.next_row()) {
+    eventIds.push_back(e.get_string(e.find_column("eventId")));
+    nTrks.push_back(e.get_int32(e.find_column("nTrk")));
+    int b1 = e.find_column("b1_mctype");
+    b1_mctypes.push_back(e.is_null(b1) ? -1 : e.get_int32(b1));
+    first_candidates.push_back(e.get_int64(e.find_column("first_candidate")));
+    ncandidates.push_back(e.get_int32(e.find_column("ncandidates")));
+    assert(first_candidates.back() == total);
+    total += ncandidates.back();
+  }
+  assert(total == c.get_num_rows());
+
+  // Every candidate row, joined with its event, is the row of the flat table.
+  int event_row = c.find_column("event_row");
+  Long64_t row = 0;
+  while (f.next_row()) {
+    assert(c.next_row());
+    Long64_t ev = c.get_int64(event_row);
+    assert(ev >= 0 && ev < nevents);
+    assert(row >= first_candidates[ev] && row < first_candidates[ev] + ncandidates[ev]);
+    assert(f.get_string(f.find_column("eventId")) == eventIds[ev]);
+    assert(f.get_int32(f.find_column("nTrk")) == nTrks[ev]);
+    int b1 = f.find_column("b1_mctype");
+    assert((f.is_null(b1) ? -1 : f.get_int32(b1)) == b1_mctypes[ev]);
+    for (const auto &name : features) {
+      int fi = f.find_column(name), ci = c.find_column(name);
+      assert(f.is_null(fi) == c.is_null(ci));
+      if (!f.is_null(fi)) assert(f.get_double(fi) == c.get_double(ci));
+    }
+    ++row;
+  }
+  assert(!c.next_row());
+
+  // An event selection, then the candidates of the selected events by
+  // their event rows.
+  ColumnarReader sel(event_fname);
+  sel.add_range("nTrk", 4, 8);
+  Long64_t nselected = 0;
+  while (sel.next_row()) {
+    Long64_t ev = sel.get_row_index();
+    ColumnarReader cands(cand_fname);
+    cands.select_columns({ "eextra50" });
+    cands.add_range("event_row", ev, ev);
+    int n = 0;
+    while (cands.next_row()) ++n;
+    assert(n == ncandidates[ev]);
+    assert(cands.get_chunks_read() <= 2);
+    ++nselected;
+  }
+  Long64_t expected = 0;
+  for (auto n : nTrks) expected += (n >= 4 && n <= 8);
+  assert(nselected == expected);
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include <iostream> 
+#include <cassert>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+
+using namespace std;
+
+// Write a synthetic ntuple and read it back with the full MC reader. 
+// Every event should be readable, and the pair of true B's should be 
+// found among the Y candidates of some events. Then give every block a
+// range and check the counts written stay in it.
+int main() {
+
+  const char *fname = "/tmp/generator_test1.root";
+  const int nevents = 2000;
+
+  NtupleGenerator generator(1234);
+  generator.set_nY_range(0, 50);
+  generator.set_continuum_fraction(0.2);
+  generator.write(fname, nevents);
+
+  BDtaunuMcReader reader(fname);
+  RootReader::Status status;
+  int nread = 0, ncontinuum = 0, nY = 0, ntruth_matched = 0;
+  while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+    assert(status == RootReader::Status::kReadSucceeded);
+    ++nread;
+    if (reader.is_continuum()) ++ncontinuum;
+    nY += reader.get_nY();
+    for (const auto &cand : reader.get_upsilon_candidates()) {
+      if (cand.get_truth_match() >= 0) ++ntruth_matched;
+    }
+  }
+
+  cout << "read " << nread << " events, " << ncontinuum << " continuum, ";
+  cout << nY << " Y candidates, " << ntruth_matched << " truth matched." << endl;
+  assert(nread == nevents);
+  assert(ncontinuum > 0 && ncontinuum < nevents);
+  assert(ntruth_matched > 0);
+
+  // Each range starts above the number of candidates reconstructed from
+  // MC truth, which are always made.
+  const char *ranged_fname = "/tmp/generator_test1_ranged.root";
+  const char *count_names[] = { "nB", "nD", "nC", "nh", "nl", "ngamma" };
+  const int range_min[] = { 30, 40, 20, 60, 10, 30 };
+  const int range_max[] = { 60, 80, 50, 90, 20, 60 };
+
+  NtupleGenerator ranged(4321);
+  ranged.set_nY_range(0, 50);
+  ranged.set_nB_range(range_min[0], range_max[0]);
+  ranged.set_nD_range(range_min[1], range_max[1]);
+  ranged.set_nC_range(range_min[2], range_max[2]);
+  ranged.set_nh_range(range_min[3], range_max[3]);
+  ranged.set_nl_range(range_min[4], range_max[4]);
+  ranged.set_ngamma_range(range_min[5], range_max[5]);
+  ranged.write(ranged_fname, 500);
+
+  TFile f(ranged_fname);
+  TTree *tr = static_cast<TTree*>(f.Get("ntp1"));
+  int count[6];
+  for (int b = 0; b < 6; ++b) tr->SetBranchAddress(count_names[b], &count[b]);
+  for (Long64_t i = 0; i < tr->GetEntries(); ++i) {
+    tr->GetEntry(i);
+    for (int b = 0; b < 6; ++b) {
+      assert(count[b] >= range_min[b] && count[b] <= range_max[b]);
+    }
+  }
+  f.Close();
+
+  BDtaunuMcReader ranged_reader(ranged_fname);
+  while ((status = ranged_reader.next_record()) != RootReader::Status::kEOF) {
+    assert(status == RootReader::Status::kReadSucceeded);
+  }
+
+  return 0;
+}
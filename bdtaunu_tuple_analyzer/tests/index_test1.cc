@@ -0,0 +1,85 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/EventIndex.h>
+
+#include "TestUtils.h"
+
+using namespace std;
+using testutils::Summary;
+
+// Index synthetic ntuples, and check that seeking an event reads the
+// same event that reading from the start does.
+int main() {
+
+  const int nfiles = 3;
+  const int nevents = 120;
+
+  vector<string> fnames = testutils::WriteNtuples("index_test1", nfiles, nevents, 400, 30);
+
+  // Every event, in order, and where it is.
+  vector<string> events;
+  map<string, pair<string, Long64_t>> locations;
+  for (const auto &fname : fnames) {
+    BDtaunuMcReader reader(fname.c_str());
+    RootReader::Status status;
+    Long64_t entry = 0;
+    while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+      events.push_back(Summary(reader, status));
+      locations[reader.get_eventId()] = make_pair(fname, entry++);
+    }
+  }
+
+  // The built index and the one written to disk find the same entries.
+  EventIndex built = EventIndex::Build(fnames, "ntp1", 2);
+  assert(built.size() == events.size());
+  built.write("/tmp/index_test1.evidx");
+  auto index = make_shared<EventIndex>(EventIndex::Open("/tmp/index_test1.evidx"));
+  assert(index->size() == built.size());
+  assert(index->get_files() == fnames);
+
+  for (const auto &l : locations) {
+    string fname;
+    Long64_t entry;
+    assert(index->find(l.first, fname, entry));
+    assert(fname == l.second.first && entry == l.second.second);
+  }
+  string fname;
+  Long64_t entry;
+  assert(!index->find("1:1:99/0", fname, entry));
+  assert(!index->find("not an event", fname, entry));
+
+  // Seek back and forth across files; reading carries on after the
+  // event sought.
+  BDtaunuMcReader reader(fnames);
+  assert(!reader.seek_event(events[0].substr(0, events[0].find(' '))));
+  reader.set_event_index(index);
+
+  for (int k : { 300, 5, 119, 120, 239, 0, 359, 200 }) {
+    string eventId = events[k].substr(0, events[k].find(' '));
+    assert(reader.seek_event(eventId));
+    RootReader::Status status = reader.next_record();
+    assert(Summary(reader, status) == events[k]);
+    if (k + 1 < static_cast<int>(events.size())) {
+      status = reader.next_record();
+      assert(Summary(reader, status) == events[k + 1]);
+    }
+  }
+  assert(!reader.seek_event("1:1:99/0"));
+
+  // Reading to the end after a seek sees the remaining events.
+  assert(reader.seek_event(events[100].substr(0, events[100].find(' '))));
+  size_t k = 100;
+  RootReader::Status status;
+  while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+    assert(Summary(reader, status) == events[k++]);
+  }
+  assert(k == events.size());
+
+  return 0;
+}
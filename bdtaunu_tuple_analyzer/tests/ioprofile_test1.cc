@@ -0,0 +1,82 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/BranchIoProfile.h>
+
+using namespace std;
+
+// Profile a synthetic ntuple in both reader modes and check that the
+// branch costs agree with what the reader read.
+int main() {
+
+  const char *fname = "/tmp/ioprofile_test1.root";
+  const int nevents = 200;
+
+  NtupleGenerator generator(2468);
+  generator.set_nY_range(0, 50);
+  generator.write(fname, nevents);
+
+  // Full mode binds every branch the generator writes except
+  // `mcenergy`, which no feature uses. It is still read, and the
+  // profile must flag it.
+  BDtaunuMcReader reader(fname);
+  reader.enable_io_profile();
+  while (reader.next_record() != RootReader::Status::kEOF) {}
+
+  const BranchIoProfile *profile = reader.get_io_profile();
+  assert(profile);
+  profile->print(cout);
+
+  vector<BranchIoProfile::BranchCost> ranked = profile->ranked();
+  assert(!ranked.empty());
+  unsigned long long nbytes = 0;
+  for (size_t i = 0; i < ranked.size(); ++i) {
+    const BranchIoProfile::BranchCost &c = ranked[i];
+    if (c.name == "mcenergy") {
+      assert(c.usage == BranchIoProfile::Usage::kUnbound);
+      assert(c.bytes > 0);
+    } else {
+      assert(c.usage == BranchIoProfile::Usage::kBound);
+    }
+    assert(c.calls == nevents);
+    if (i > 0) assert(ranked[i - 1].seconds >= c.seconds);
+    nbytes += c.bytes;
+  }
+  if (ReaderStats::enabled) assert(nbytes == reader.stats().bytes_read);
+
+  // MC truth only mode reads a handful of branches; the rest cost nothing.
+  BDtaunuMcReader mc_reader(fname, "ntp1", BDtaunuMcReader::Mode::kMcOnly);
+  mc_reader.enable_io_profile();
+  while (mc_reader.next_record() != RootReader::Status::kEOF) {}
+
+  int nactive = 0;
+  for (const auto &c : mc_reader.get_io_profile()->ranked()) {
+    if (c.usage == BranchIoProfile::Usage::kDisabled) {
+      assert(c.calls == 0 && c.bytes == 0);
+    } else {
+      assert(c.usage == BranchIoProfile::Usage::kBound);
+      assert(c.name != "nY" && c.name != "YLund");
+      ++nactive;
+    }
+  }
+  assert(nactive == 9);
+
+  // Profiles of two files merge by branch name.
+  BranchIoProfile merged;
+  merged.merge(*profile);
+  merged.merge(*mc_reader.get_io_profile());
+  for (const auto &c : merged.ranked()) {
+    if (c.name == "mcenergy") {
+      assert(c.usage == BranchIoProfile::Usage::kUnbound);
+    } else {
+      assert(c.usage == BranchIoProfile::Usage::kBound);
+    }
+    if (c.name == "mcLund") assert(c.calls == 2 * nevents);
+    if (c.name == "YLund") assert(c.calls == nevents);
+  }
+
+  return 0;
+}
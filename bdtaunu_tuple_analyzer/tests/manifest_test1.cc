@@ -0,0 +1,79 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuReader.h>
+#include <bdtaunu_tuple_analyzer/DatasetManifest.h>
+
+using namespace std;
+
+// Build a manifest of synthetic ntuples and one missing file, and check
+// it against what a reader sees and against a round trip through text.
+int main() {
+
+  const int nfiles = 3;
+  vector<string> fnames;
+  vector<int> nevents;
+  for (int i = 0; i < nfiles; ++i) {
+    fnames.push_back("/tmp/manifest_test1_" + to_string(i) + ".root");
+    nevents.push_back(100 * (i + 1));
+    NtupleGenerator generator(300 + i);
+    generator.set_nY_range(0, 40 * (i + 1));
+    generator.write(fnames.back().c_str(), nevents.back());
+  }
+  fnames.push_back("/tmp/manifest_test1_missing.root");
+
+  DatasetManifest manifest = DatasetManifest::Build(fnames, "ntp1", 2);
+  manifest.write(cout);
+
+  const vector<DatasetManifest::FileEntry> &files = manifest.get_files();
+  assert(files.size() == fnames.size());
+  assert(manifest.get_schemas().size() == 1);
+
+  int max_nY = 0;
+  for (int i = 0; i < nfiles; ++i) {
+    const DatasetManifest::FileEntry &f = files[i];
+    assert(f.fname == fnames[i]);
+    assert(f.error.empty());
+    assert(f.entries == nevents[i]);
+    assert(f.is_mc());
+    assert(DatasetManifest::is_current(f));
+    assert(!f.cluster_starts.empty() && f.cluster_starts[0] == 0);
+    assert(is_sorted(f.cluster_starts.begin(), f.cluster_starts.end()));
+
+    const vector<string> &branches = manifest.get_branches(f);
+    assert(find(branches.begin(), branches.end(), "mcLund") != branches.end());
+
+    // The recorded maximum is what a reader sees.
+    BDtaunuReader reader(fnames[i].c_str());
+    int file_max_nY = 0;
+    while (reader.next_record() != RootReader::Status::kEOF) {
+      file_max_nY = max(file_max_nY, reader.get_nY());
+    }
+    assert(f.max_count[DatasetManifest::knY] == file_max_nY);
+    max_nY = max(max_nY, file_max_nY);
+  }
+  assert(!files[nfiles].error.empty());
+  assert(manifest.get_total_entries() == 100 + 200 + 300);
+  assert(manifest.get_max_count(DatasetManifest::knY) == max_nY);
+
+  // Reading the sidecar back gives the same manifest.
+  stringstream ss;
+  manifest.write(ss);
+  DatasetManifest copy = DatasetManifest::Read(ss);
+  assert(copy.get_tree_name() == "ntp1");
+  assert(copy.get_schemas() == manifest.get_schemas());
+  assert(copy.get_files().size() == files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    const DatasetManifest::FileEntry &a = files[i], &b = copy.get_files()[i];
+    assert(a.fname == b.fname && a.entries == b.entries && a.error == b.error);
+    assert(a.cluster_starts == b.cluster_starts);
+    assert(equal(a.max_count, a.max_count + DatasetManifest::kNCounts, b.max_count));
+  }
+
+  return 0;
+}
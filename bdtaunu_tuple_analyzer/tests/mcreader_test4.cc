@@ -0,0 +1,60 @@
+#include <iostream> 
+#include <chrono>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+
+using namespace std;
+
+// Compare the MC truth only mode against the full reader. Every event 
+// read by the full reader should carry the same MC labels in both modes. 
+int main() {
+
+  const char *fname = "/tmp/mcreader_test4.root";
+  NtupleGenerator generator(11444);
+  generator.set_nY_range(0, 30);
+  generator.write(fname, 500);
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  std::chrono::duration<double> full_seconds, mc_seconds;
+
+  start = std::chrono::system_clock::now();
+  BDtaunuMcReader full_reader(fname);
+  int nfull = 0;
+  while (full_reader.next_record() != RootReader::Status::kEOF) nfull += 1;
+  end = std::chrono::system_clock::now();
+  full_seconds = end - start;
+
+  start = std::chrono::system_clock::now();
+  BDtaunuMcReader mc_reader(fname, "ntp1", BDtaunuMcReader::Mode::kMcOnly);
+  int nmc = 0;
+  while (mc_reader.next_record() != RootReader::Status::kEOF) nmc += 1;
+  end = std::chrono::system_clock::now();
+  mc_seconds = end - start;
+
+  cout << "full mode: processed " << nfull << " events in " << full_seconds.count() << " seconds." << endl;
+  cout << "mc only mode: processed " << nmc << " events in " << mc_seconds.count() << " seconds." << endl;
+  assert(nfull == nmc);
+
+  BDtaunuMcReader a(fname);
+  BDtaunuMcReader b(fname, "ntp1", BDtaunuMcReader::Mode::kMcOnly);
+  RootReader::Status status;
+  int nmismatch = 0;
+  while ((status = a.next_record()) != RootReader::Status::kEOF) {
+    b.next_record();
+    assert(a.get_eventId() == b.get_eventId());
+    if (status != RootReader::Status::kReadSucceeded) continue;
+    if (a.is_continuum() != b.is_continuum() || 
+        a.get_b1_mctype() != b.get_b1_mctype() || 
+        a.get_b2_mctype() != b.get_b2_mctype() || 
+        a.get_b1_tau_mctype() != b.get_b1_tau_mctype() || 
+        a.get_b2_tau_mctype() != b.get_b2_tau_mctype()) {
+      ++nmismatch;
+    }
+  }
+  cout << nmismatch << " events with mismatched MC labels." << endl;
+  assert(nmismatch == 0);
+
+  return 0;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/FilePrefetcher.h>
+#include <bdtaunu_tuple_analyzer/ReaderStats.h>
+
+#include "TestUtils.h"
+
+using namespace std;
+using testutils::Summary;
+
+// Events, in order, of reading each file with its own reader.
+vector<string> ReadOneByOne(const vector<string> &fnames, BDtaunuMcReader::Mode mode) {
+  vector<string> events;
+  for (const auto &fname : fnames) {
+    BDtaunuMcReader reader(fname.c_str(), "ntp1", mode);
+    RootReader::Status status;
+    while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+      events.push_back(Summary(reader, status));
+    }
+  }
+  return events;
+}
+
+// Read a list of files with one reader, with and without prefetching,
+// and check that it sees the same events as one reader per file.
+int main() {
+
+  const int nfiles = 4;
+  const int nevents = 150;
+
+  vector<string> fnames = testutils::WriteNtuples("multifile_test1", nfiles, nevents, 100, 30);
+
+  for (auto mode : { BDtaunuMcReader::Mode::kFull, BDtaunuMcReader::Mode::kMcOnly }) {
+    vector<string> expected = ReadOneByOne(fnames, mode);
+
+    for (int window : { 0, 1, 3 }) {
+      BDtaunuMcReader reader(fnames, "ntp1", mode);
+      reader.set_prefetch_window(window, 64 << 20);
+
+      vector<string> events;
+      RootReader::Status status;
+      while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+        events.push_back(Summary(reader, status));
+      }
+      assert(events == expected);
+
+      if (ReaderStats::enabled) {
+        ReaderStats stats = reader.stats();
+        assert(stats.files_opened == nfiles);
+        assert(stats.events_read == nfiles * nevents);
+        assert(stats.stage_latency[ReaderStats::kOpenFile].get_count() == nfiles);
+      }
+    }
+  }
+
+  // Page cache warming is bounded by the requested size and by the file.
+  assert(FilePrefetcher::WarmPageCache(fnames[0], 1000) == 1000);
+  assert(FilePrefetcher::WarmPageCache(fnames[0], 1LL << 40) > 1000);
+  assert(FilePrefetcher::WarmPageCache("/tmp/multifile_test1_missing.root", 1000) == 0);
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <cassert>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <bdtaunu_tuple_analyzer/AnalysisContext.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/ResultCache.h>
+
+#include "TestUtils.h"
+
+using namespace std;
+using testutils::Summary;
+
+// Events of a list of files with the decay strings of their
+// signatures, and how many of them were served from the cache.
+vector<string> ReadAll(const vector<string> &fnames, BDtaunuMcReader::Mode mode, int depth,
+                       shared_ptr<ResultCache> cache, int &ncached) {
+  BDtaunuMcReader reader(fnames, "ntp1", mode);
+  reader.set_signature_depth(depth);
+  reader.set_result_cache(cache);
+  vector<string> events;
+  ncached = 0;
+  RootReader::Status status;
+  while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+    const DecayDictionary &decays = reader.get_decay_dictionary();
+    events.push_back(Summary(reader, status) + 
+                     " | " + decays.get_decay_string(reader.get_b1_signature()) + 
+                     " | " + decays.get_decay_string(reader.get_b2_signature()));
+    if (reader.is_cached()) ++ncached;
+  }
+  return events;
+}
+
+// `key` with the value of `field` changed.
+string ChangeField(const string &key, const string &field) {
+  size_t pos = key.find(" " + field + " ");
+  assert(pos != string::npos);
+  pos = key.find(' ', pos + field.size() + 2);
+  return (pos == string::npos) ? key + "0" : key.substr(0, pos) + "0" + key.substr(pos);
+}
+
+// Read synthetic ntuples without the cache, then twice with it, and
+// check that all three reads agree, decay strings included, and that
+// the second is served from the cache. Then check what the key covers.
+int main() {
+
+  const int nfiles = 2;
+  const int nentries = 200;
+  vector<string> fnames = testutils::WriteNtuples("resultcache_test1", nfiles, nentries, 700, 20);
+
+  system("rm -rf /tmp/resultcache_test1_cache");
+  auto cache = make_shared<ResultCache>("/tmp/resultcache_test1_cache");
+
+  unsigned long long hits = 0;
+  for (auto mode : { BDtaunuMcReader::Mode::kFull, BDtaunuMcReader::Mode::kMcOnly }) {
+    for (int depth : { 2, 1 }) {
+      int n0, n1, n2;
+      vector<string> plain = ReadAll(fnames, mode, depth, nullptr, n0);
+      vector<string> first = ReadAll(fnames, mode, depth, cache, n1);
+      vector<string> second = ReadAll(fnames, mode, depth, cache, n2);
+
+      assert(plain.size() == static_cast<size_t>(nfiles * nentries));
+      assert(first == plain);
+      assert(second == plain);
+      assert(n0 == 0 && n1 == 0 && n2 == nfiles * nentries);
+
+      // Tables of one mode or depth are not used by another.
+      assert(cache->get_hits() == hits + nfiles);
+      hits = cache->get_hits();
+    }
+  }
+
+  // A table is only found under its own key; changing the algorithm
+  // version, the catalogue version, the particle data table, or the
+  // signature depth misses it.
+  TFile f(fnames[0].c_str());
+  TTree *tr = static_cast<TTree*>(f.Get("ntp1"));
+  string key = ResultCache::Key(tr, static_cast<int>(BDtaunuMcReader::Mode::kFull), 2,
+                                *AnalysisContext::Default());
+  assert(cache->load(key));
+  for (const string field : { "algorithm", "catalogue", "pdt", "depth" }) {
+    assert(!cache->load(ChangeField(key, field)));
+  }
+  assert(key != ResultCache::Key(tr, static_cast<int>(BDtaunuMcReader::Mode::kFull), 1,
+                                 *AnalysisContext::Default()));
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/ColumnarFile.h>
+#include <bdtaunu_tuple_analyzer/CandidateColumns.h>
+#include <bdtaunu_tuple_analyzer/OutputRouter.h>
+
+using namespace std;
+
+// Event Ids of an event table.
+vector<string> ReadEventIds(const string &fname) {
+  vector<string> ids;
+  ColumnarReader r(fname);
+  int eventId = r.find_column("eventId");
+  while (r.next_row()) ids.push_back(r.get_string(eventId));
+  return ids;
+}
+
+// Route the events of a synthetic ntuple to a hash split, a selection,
+// and a copy of every event in one pass, and check each output.
+int main() {
+
+  const string fname = "/tmp/router_test1.root";
+  const string direct_fname = "/tmp/router_test1_direct.col";
+  const string all_fname = "/tmp/router_test1_all.col";
+  const string sel_fname = "/tmp/router_test1_sel.col";
+  const vector<string> split_events = { "/tmp/router_test1_a.events.col", "/tmp/router_test1_b.events.col" };
+  const vector<string> split_cands = { "/tmp/router_test1_a.cands.col", "/tmp/router_test1_b.cands.col" };
+
+  NtupleGenerator generator(1618);
+  generator.set_nY_range(0, 20);
+  generator.write(fname.c_str(), 500);
+
+  // The candidates of every event, written directly.
+  Long64_t nevents = 0;
+  vector<string> ids;
+  set<string> selected;
+  {
+    BDtaunuMcReader reader(fname.c_str());
+    CandidateColumnWriter direct(direct_fname, true, 256);
+    while (reader.next_record() != RootReader::Status::kEOF) {
+      direct.write(reader);
+      ids.push_back(reader.get_eventId());
+      if (reader.get_nTrk() >= 4 && reader.get_nTrk() <= 8) selected.insert(ids.back());
+      ++nevents;
+    }
+    direct.close();
+  }
+
+  // The same events routed. Short queues make the event loop wait on
+  // the writer threads.
+  {
+    BDtaunuMcReader reader(fname.c_str());
+    OutputRouter router(true, 256, 4);
+    router.add_sink(split_events[0], split_cands[0], OutputRouter::HashSplit(0, 0.5, 7));
+    router.add_sink(split_events[1], split_cands[1], OutputRouter::HashSplit(0.5, 1, 7));
+    router.add_sink(sel_fname, [] (const BDtaunuReader &r) {
+      return r.get_nTrk() >= 4 && r.get_nTrk() <= 8;
+    });
+    router.add_sink(all_fname, nullptr);
+    assert(router.get_num_sinks() == 4);
+
+    assert(router.run(reader) == nevents);
+    router.close();
+    assert(router.get_num_events(0) + router.get_num_events(1) == nevents);
+    assert(router.get_num_events(0) > 0 && router.get_num_events(1) > 0);
+    assert(router.get_num_events(2) == static_cast<Long64_t>(selected.size()));
+    assert(router.get_num_events(3) == nevents);
+  }
+
+  // The copy of every event is the direct output, row for row.
+  ColumnarReader direct(direct_fname), all(all_fname);
+  assert(direct.get_num_rows() == all.get_num_rows() && direct.get_num_rows() > 0);
+  assert(direct.get_num_columns() == all.get_num_columns());
+  while (direct.next_row()) {
+    assert(all.next_row());
+    for (size_t c = 0; c < direct.get_num_columns(); ++c) {
+      assert(direct.is_null(c) == all.is_null(c));
+      if (direct.is_null(c)) continue;
+      if (direct.get_column_type(c) == ColumnType::kString) {
+        assert(direct.get_string(c) == all.get_string(c));
+      } else {
+        assert(direct.get_double(c) == all.get_double(c));
+      }
+    }
+  }
+  assert(!all.next_row());
+
+  // The split is a partition, in order, decided by the event Id alone.
+  vector<string> a = ReadEventIds(split_events[0]), b = ReadEventIds(split_events[1]);
+  assert(static_cast<Long64_t>(a.size() + b.size()) == nevents);
+  size_t ia = 0, ib = 0;
+  for (const auto &id : ids) {
+    double x = OutputRouter::HashFraction(id, 7);
+    assert(x >= 0 && x < 1);
+    if (x < 0.5) assert(ia < a.size() && a[ia++] == id);
+    else assert(ib < b.size() && b[ib++] == id);
+  }
+
+  // The selection holds the candidates of the selected events only.
+  ColumnarReader sel(sel_fname);
+  int eventId = sel.find_column("eventId");
+  int nTrk = sel.find_column("nTrk");
+  while (sel.next_row()) {
+    assert(selected.count(sel.get_string(eventId)));
+    assert(sel.get_int32(nTrk) >= 4 && sel.get_int32(nTrk) <= 8);
+  }
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/McGraphManager.h>
+#include <bdtaunu_tuple_analyzer/AnalysisContext.h>
+
+using namespace std;
+
+// An MC truth tree held in the buffer layout of BtaTupleMaker.
+struct McBuffer {
+  vector<int> lund, moth, dau, daulen;
+
+  int add(int l, int m) {
+    lund.push_back(l);
+    moth.push_back(m);
+    dau.push_back(0);
+    daulen.push_back(0);
+    return lund.size() - 1;
+  }
+
+  // Add the daughters of `u`, which must be the last particles added.
+  void decay(int u, const vector<int> &daughters) {
+    dau[u] = lund.size();
+    daulen[u] = daughters.size();
+    for (int l : daughters) add(l, u);
+  }
+
+  McGraph::Tree tree() const {
+    return McGraph::Tree(lund.size(), lund.data(), moth.data(), dau.data(), daulen.data());
+  }
+};
+
+// B0 -> D*- tau+ nu_tau, D*- -> anti-D0 pi-, with the daughters of
+// each in the order given, under an Upsilon(4S) at index 0. Returns
+// the index of the B.
+int AddB0Decay(McBuffer &b, const vector<int> &b_daughters, const vector<int> &dstar_daughters) {
+  int y = b.add(70553, -1);
+  b.decay(y, { 511 });
+  int b0 = b.dau[y];
+  b.decay(b0, b_daughters);
+  for (int v = b.dau[b0]; v < b.dau[b0] + b.daulen[b0]; ++v) {
+    if (b.lund[v] == -413) {
+      b.decay(v, dstar_daughters);
+      break;
+    }
+  }
+  return b0;
+}
+
+// Check the defining properties of decay chain signatures on hand built
+// trees, then on the trees of a synthetic ntuple.
+int main() {
+
+  const AnalysisContext &context = *AnalysisContext::Default();
+  typedef McGraphManager M;
+
+  McBuffer a, b, conj, mu;
+  int ua = AddB0Decay(a, { -413, -15, 16 }, { -421, -211 });
+  int ub = AddB0Decay(b, { 16, -413, -15 }, { -211, -421 });
+
+  // The charge conjugate: anti-B0 -> D*+ tau- anti-nu_tau.
+  int y = conj.add(70553, -1);
+  conj.decay(y, { -511 });
+  int uc = conj.dau[y];
+  conj.decay(uc, { -16, 15, 413 });
+  conj.decay(conj.dau[uc] + 2, { 211, 421 });
+
+  // A different decay: the tau replaced by a mu.
+  int um = AddB0Decay(mu, { -413, -13, 14 }, { -421, -211 });
+
+  McGraph::Tree ta = a.tree(), tb = b.tree(), tc = conj.tree(), tm = mu.tree();
+
+  for (int depth = 0; depth <= 3; ++depth) {
+    // Any order of the daughters.
+    assert(M::ChainSignature(ta, ua, depth, context) == M::ChainSignature(tb, ub, depth, context));
+    assert(M::ChainDecayString(ta, ua, depth, context) == M::ChainDecayString(tb, ub, depth, context));
+
+    // A decay and its charge conjugate.
+    assert(M::ChainSignature(ta, ua, depth, context) == M::ChainSignature(tc, uc, depth, context));
+    assert(M::ChainDecayString(ta, ua, depth, context) == M::ChainDecayString(tc, uc, depth, context));
+  }
+
+  // Different depths, once the chain goes that deep.
+  assert(M::ChainSignature(ta, ua, 0, context) != M::ChainSignature(ta, ua, 1, context));
+  assert(M::ChainSignature(ta, ua, 1, context) != M::ChainSignature(ta, ua, 2, context));
+  assert(M::ChainSignature(ta, ua, 2, context) == M::ChainSignature(ta, ua, 3, context));
+
+  // Different decays.
+  assert(M::ChainSignature(ta, ua, 0, context) == M::ChainSignature(tm, um, 0, context));
+  assert(M::ChainSignature(ta, ua, 1, context) != M::ChainSignature(tm, um, 1, context));
+
+  // The decay strings.
+  assert(M::ChainDecayString(ta, ua, 0, context) == "B0");
+  assert(M::ChainDecayString(ta, ua, 1, context) == "B0 -> D*- nu_tau tau+");
+  assert(M::ChainDecayString(ta, ua, 2, context) == "B0 -> (D*- -> anti-D0 pi-) nu_tau tau+");
+  assert(M::ChainDecayString(tc, uc, 2, context) == "B0 -> (D*- -> anti-D0 pi-) nu_tau tau+");
+
+  // Every signature a reader gives decodes to the decay string of its
+  // chain, at any depth.
+  const string fname = "/tmp/signature_test1.root";
+  NtupleGenerator generator(2029);
+  generator.set_nY_range(0, 5);
+  generator.write(fname.c_str(), 300);
+
+  vector<vector<DecayDictionary::Signature>> signatures;
+  for (int depth : { 1, 2 }) {
+    BDtaunuMcReader reader(fname.c_str(), "ntp1", BDtaunuMcReader::Mode::kMcOnly);
+    reader.set_signature_depth(depth);
+    signatures.push_back({});
+    int nB = 0;
+    while (reader.next_record() != RootReader::Status::kEOF) {
+      for (auto s : { reader.get_b1_signature(), reader.get_b2_signature() }) {
+        signatures.back().push_back(s);
+        if (!s) continue;
+        const string &decay = reader.get_decay_dictionary().get_decay_string(s);
+        assert(decay.compare(0, 6, "B0 -> ") == 0 || decay.compare(0, 6, "B+ -> ") == 0);
+        assert((depth > 1) == (decay.find('(') != string::npos));
+        ++nB;
+      }
+    }
+    assert(nB > 0);
+  }
+
+  // The same B at depths 1 and 2.
+  assert(signatures[0].size() == signatures[1].size());
+  for (size_t i = 0; i < signatures[0].size(); ++i) {
+    assert((signatures[0][i] == 0) == (signatures[1][i] == 0));
+    if (signatures[0][i]) assert(signatures[0][i] != signatures[1][i]);
+  }
+
+  return 0;
+}
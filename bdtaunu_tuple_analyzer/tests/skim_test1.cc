@@ -0,0 +1,98 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/SkimWriter.h>
+
+#include "TestUtils.h"
+
+using namespace std;
+using testutils::Summary;
+
+bool Keep(const BDtaunuReader &reader) {
+  return reader.get_upsilon_candidates().size() >= 3;
+}
+
+// Events of a list of files, optionally only the ones Keep() accepts.
+vector<string> ReadAll(const vector<string> &fnames, bool filter) {
+  vector<string> events;
+  for (const auto &fname : fnames) {
+    BDtaunuMcReader reader(fname.c_str());
+    RootReader::Status status;
+    while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+      if (status != RootReader::Status::kReadSucceeded) continue;
+      if (filter && !Keep(reader)) continue;
+      events.push_back(Summary(reader, status));
+    }
+  }
+  return events;
+}
+
+// Skim synthetic ntuples and check that the skims read back as the
+// events that were kept.
+int main() {
+
+  const int nfiles = 3;
+  vector<string> fnames = testutils::WriteNtuples("skim_test1", nfiles, 200, 500, 20);
+  vector<string> skim_fnames, copy_fnames;
+  for (int i = 0; i < nfiles; ++i) {
+    skim_fnames.push_back("/tmp/skim_test1_" + to_string(i) + ".skim.root");
+    copy_fnames.push_back("/tmp/skim_test1_" + to_string(i) + ".copy.root");
+  }
+
+  vector<string> all = ReadAll(fnames, false);
+  vector<string> kept = ReadAll(fnames, true);
+  assert(!kept.empty() && kept.size() < all.size());
+
+  auto make_reader = [] (const string &fname) {
+    return unique_ptr<BDtaunuReader>(new BDtaunuMcReader(fname.c_str()));
+  };
+
+  // Filtered skims, in parallel.
+  SkimWriter skim(Keep);
+  skim.set_nthreads(2);
+  skim.set_reader_factory(make_reader);
+  vector<Long64_t> nwritten = skim.run(fnames, skim_fnames);
+  Long64_t total = 0;
+  for (auto n : nwritten) total += n;
+  assert(total == static_cast<Long64_t>(kept.size()));
+  assert(ReadAll(skim_fnames, false) == kept);
+
+  // Unfiltered copies are fast cloned.
+  SkimWriter copy(nullptr);
+  copy.set_reader_factory(make_reader);
+  copy.run(fnames, copy_fnames);
+  assert(ReadAll(copy_fnames, false) == all);
+
+  // One reader over several files into one skim.
+  BDtaunuMcReader reader(fnames);
+  assert(skim.skim(reader, "/tmp/skim_test1_all.skim.root") == total);
+  assert(ReadAll({ "/tmp/skim_test1_all.skim.root" }, false) == kept);
+
+  // Entries the reader rejects are dropped by the copy as well. Event 4
+  // has one photon too many.
+  const string capped_fname = "/tmp/skim_test1_capped.root";
+  vector<NtupleGenerator::Event> events(10);
+  for (size_t i = 0; i < events.size(); ++i) {
+    events[i].mc_lund = { 11, -11, 70553 };
+    events[i].mc_moth = { -1, -1, -1 };
+    events[i].gamma.assign(i == 4 ? 100 : 3, { 22, -1, {}, {} });
+  }
+  NtupleGenerator capped_generator(600);
+  capped_generator.write(capped_fname.c_str(), events);
+
+  vector<string> capped = ReadAll({ capped_fname }, false);
+  assert(capped.size() == events.size() - 1);
+  vector<Long64_t> ncopied = copy.run({ capped_fname }, { "/tmp/skim_test1_capped.copy.root" });
+  assert(ncopied[0] == static_cast<Long64_t>(capped.size()));
+  assert(ReadAll({ "/tmp/skim_test1_capped.copy.root" }, false) == capped);
+
+  BDtaunuMcReader capped_reader(capped_fname.c_str());
+  assert(copy.skim(capped_reader, "/tmp/skim_test1_capped.skim.root") == ncopied[0]);
+
+  return 0;
+}
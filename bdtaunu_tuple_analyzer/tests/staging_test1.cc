@@ -0,0 +1,113 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cassert>
+#include <cstdlib>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuReader.h>
+#include <bdtaunu_tuple_analyzer/StagingCache.h>
+
+using namespace std;
+
+bool Exists(const string &path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0;
+}
+
+Long64_t FileSize(const string &path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+vector<string> EventIds(BDtaunuReader &reader) {
+  vector<string> ids;
+  while (reader.next_record() != RootReader::Status::kEOF) ids.push_back(reader.get_eventId());
+  return ids;
+}
+
+// Stage synthetic ntuples into a small cache and check hits, copies,
+// eviction order, that leased copies are not evicted, and that a file
+// they leave no room for is read in place.
+int main() {
+
+  const string cache_dir = "/tmp/staging_test1_cache";
+  system(("rm -rf " + cache_dir + " " + cache_dir + "_tiny").c_str());
+
+  vector<string> fnames;
+  for (int i = 0; i < 3; ++i) {
+    fnames.push_back("/tmp/staging_test1_" + to_string(i) + ".root");
+    NtupleGenerator generator(200 + i);
+    generator.write(fnames.back().c_str(), 300);
+  }
+
+  // Room for two of the three files.
+  Long64_t largest = 0;
+  for (const auto &f : fnames) largest = max(largest, FileSize(f));
+  auto cache = make_shared<StagingCache>(cache_dir, 2 * largest + largest / 2);
+
+  string copy0;
+  {
+    StagingCache::Lease lease = cache->stage(fnames[0]);
+    assert(lease.is_staged());
+    assert(lease.get_path() != fnames[0]);
+    assert(FileSize(lease.get_path()) == FileSize(fnames[0]));
+    copy0 = lease.get_path();
+  }
+  assert(cache->get_copies() == 1 && cache->get_hits() == 0);
+
+  {
+    StagingCache::Lease lease = cache->stage(fnames[0]);
+    assert(lease.get_path() == copy0);
+  }
+  assert(cache->get_copies() == 1 && cache->get_hits() == 1);
+
+  // Staging a third file evicts the least recently used copy, unless
+  // it is leased.
+  {
+    sleep(1);
+    StagingCache::Lease lease1 = cache->stage(fnames[1]);
+    sleep(1);
+    string copy2 = cache->stage(fnames[2]).get_path();
+    assert(!Exists(copy0) && Exists(lease1.get_path()) && Exists(copy2));
+
+    sleep(1);
+    cache->stage(fnames[0]);
+    assert(Exists(lease1.get_path()) && !Exists(copy2));
+  }
+
+  // With every copy leased, eviction cannot make room, and the original
+  // is read instead.
+  {
+    StagingCache::Lease lease0 = cache->stage(fnames[0]);
+    StagingCache::Lease lease1 = cache->stage(fnames[1]);
+    assert(lease0.is_staged() && lease1.is_staged());
+    unsigned long long copies = cache->get_copies();
+    StagingCache::Lease lease2 = cache->stage(fnames[2]);
+    assert(!lease2.is_staged() && lease2.get_path() == fnames[2]);
+    assert(cache->get_copies() == copies);
+    assert(Exists(lease0.get_path()) && Exists(lease1.get_path()));
+  }
+
+  // Files larger than the budget, and missing files, are read in place.
+  StagingCache tiny(cache_dir + "_tiny", 1000);
+  assert(!tiny.stage(fnames[0]).is_staged());
+  assert(cache->stage("/tmp/staging_test1_missing.root").get_path() == "/tmp/staging_test1_missing.root");
+
+  // Readers read the staged copy and see the same events.
+  BDtaunuReader direct(fnames[2].c_str());
+  vector<string> expected = EventIds(direct);
+
+  StagingCache::SetDefault(cache);
+  unsigned long long copies = cache->get_copies();
+  BDtaunuReader staged(fnames[2].c_str());
+  assert(EventIds(staged) == expected);
+  assert(cache->get_copies() == copies + 1);
+  StagingCache::SetDefault(nullptr);
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <cassert>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/ReaderStats.h>
+
+using namespace std;
+
+// Read a synthetic ntuple and check that the reader statistics agree
+// with what the caller sees.
+int main() {
+
+  const char *fname = "/tmp/stats_test1.root";
+  const int nevents = 500;
+
+  NtupleGenerator generator(4321);
+  generator.set_nY_range(0, 100);
+  generator.write(fname, nevents);
+
+  BDtaunuMcReader reader(fname);
+  RootReader::Status status;
+  unsigned long long status_counts[ReaderStats::n_status] = {};
+  unsigned long long ncandidates = 0;
+  while ((status = reader.next_record()) != RootReader::Status::kEOF) {
+    ++status_counts[static_cast<int>(status)];
+    ncandidates += reader.get_upsilon_candidates().size();
+  }
+  ++status_counts[static_cast<int>(status)];
+
+  ReaderStats stats = reader.stats();
+  stats.print(cout);
+
+  if (!ReaderStats::enabled) {
+    assert(stats.events_read == 0);
+    return 0;
+  }
+
+  assert(stats.events_read == nevents);
+  for (int i = 0; i < ReaderStats::n_status; ++i) {
+    assert(stats.status_counts[i] == status_counts[i]);
+  }
+  assert(stats.candidates == ncandidates);
+  assert(stats.reco_vertices > 0 && stats.reco_edges > 0);
+  assert(stats.mc_vertices > 0 && stats.mc_edges > 0);
+  assert(stats.truth_match_probes > 0);
+
+  unsigned long long nsucceeded = status_counts[static_cast<int>(RootReader::Status::kReadSucceeded)];
+  assert(stats.stage_latency[ReaderStats::kGetEntry].get_count() == nevents);
+  assert(stats.stage_latency[ReaderStats::kTruthMatchAnalyzeGraph].get_count() == nsucceeded);
+
+  // Bucket counts add up, and quantiles are ordered.
+  const LatencyHistogram &h = stats.stage_latency[ReaderStats::kRecoConstructGraph];
+  unsigned long long nbucketed = 0;
+  for (int i = 0; i < LatencyHistogram::n_buckets; ++i) nbucketed += h.get_bucket_count(i);
+  assert(nbucketed == h.get_count());
+  assert(h.quantile(0.5) <= h.quantile(0.99));
+  assert(h.quantile(0.99) <= h.get_max_seconds());
+
+  // Statistics of two readers merge.
+  ReaderStats merged = stats;
+  merged.merge(stats);
+  assert(merged.events_read == 2 * stats.events_read);
+  assert(merged.stage_latency[ReaderStats::kGetEntry].get_count() == 2 * nevents);
+
+  reader.clear_stats();
+  assert(reader.stats().events_read == 0);
+
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+
+#include <bdtaunu_tuple_analyzer/DatasetManifest.h>
+
+using namespace std;
+
+// Scan a list of ntuples once and write a dataset manifest: entry
+// counts, cluster boundaries, branch lists, and block count maxima.
+//
+// Usage: build_manifest [-j nthreads] [-o output] [-t tree] file1.root [file2.root ...]
+int main(int argc, char **argv) {
+
+  int nthreads = 0;
+  string output_fname;
+  string trname = "ntp1";
+  vector<string> fnames;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      nthreads = atoi(argv[++i]);
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_fname = argv[++i];
+    } else if (arg == "-t" && i + 1 < argc) {
+      trname = argv[++i];
+    } else {
+      fnames.push_back(arg);
+    }
+  }
+
+  if (fnames.empty()) {
+    cerr << "usage: " << argv[0];
+    cerr << " [-j nthreads] [-o output] [-t tree] file1.root [file2.root ...]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  start = std::chrono::system_clock::now();
+
+  DatasetManifest manifest = DatasetManifest::Build(fnames, trname.c_str(), nthreads);
+
+  end = std::chrono::system_clock::now();
+  std::chrono::duration<double> elapsed_seconds = end - start;
+  int nerrors = 0;
+  for (const auto &f : manifest.get_files()) {
+    if (!f.error.empty()) {
+      cerr << f.error << endl;
+      ++nerrors;
+    }
+  }
+  cerr << "scanned " << fnames.size() << " files with ";
+  cerr << manifest.get_total_entries() << " entries in ";
+  cerr << elapsed_seconds.count() << " seconds; " << nerrors << " unreadable." << endl;
+
+  if (output_fname.empty()) {
+    manifest.write(cout);
+  } else {
+    ofstream output(output_fname);
+    manifest.write(output);
+  }
+
+  return 0;
+}
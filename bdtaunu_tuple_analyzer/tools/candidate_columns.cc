@@ -0,0 +1,140 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <chrono>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuReader.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/ColumnarFile.h>
+#include <bdtaunu_tuple_analyzer/CandidateColumns.h>
+
+using namespace std;
+
+// Print one value of the current row of a columnar file.
+void PrintValue(const ColumnarReader &r, int column) {
+  if (r.is_null(column)) {
+    cout << "null";
+    return;
+  }
+  switch (r.get_column_type(column)) {
+    case ColumnType::kInt32: cout << r.get_int32(column); break;
+    case ColumnType::kInt64: cout << r.get_int64(column); break;
+    case ColumnType::kFloat: cout << r.get_float(column); break;
+    case ColumnType::kDouble: cout << r.get_double(column); break;
+    case ColumnType::kString: cout << r.get_string(column); break;
+  }
+}
+
+// Write the candidates of a list of ntuples to a columnar file, or
+// print the rows of one that pass range cuts. With -e, the events are
+// written to a table of their own, linked to the candidates by row.
+//
+// Usage: candidate_columns [-t tree] [-n chunk_rows] [--mc] [-e events] -o output file1.root [file2.root ...]
+//        candidate_columns -i input [-r column:lo:hi ...] [column ...]
+int main(int argc, char **argv) {
+
+  string output_fname, input_fname, event_fname;
+  string trname = "ntp1";
+  Long64_t chunk_rows = 16384;
+  bool mc = false;
+  vector<string> ranges;
+  vector<string> args;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-o" && i + 1 < argc) {
+      output_fname = argv[++i];
+    } else if (arg == "-e" && i + 1 < argc) {
+      event_fname = argv[++i];
+    } else if (arg == "-i" && i + 1 < argc) {
+      input_fname = argv[++i];
+    } else if (arg == "-t" && i + 1 < argc) {
+      trname = argv[++i];
+    } else if (arg == "-n" && i + 1 < argc) {
+      chunk_rows = atoll(argv[++i]);
+    } else if (arg == "-r" && i + 1 < argc) {
+      ranges.push_back(argv[++i]);
+    } else if (arg == "--mc") {
+      mc = true;
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  if (output_fname.empty() == input_fname.empty() || (!output_fname.empty() && args.empty())) {
+    cerr << "usage: " << argv[0];
+    cerr << " [-t tree] [-n chunk_rows] [--mc] [-e events] -o output file1.root [file2.root ...]" << endl;
+    cerr << "       " << argv[0] << " -i input [-r column:lo:hi ...] [column ...]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  start = std::chrono::system_clock::now();
+
+  // Scan: print the passing rows, one per line.
+  if (!input_fname.empty()) {
+    ColumnarReader r(input_fname);
+    for (const auto &range : ranges) {
+      string name;
+      double lo, hi;
+      istringstream is(range);
+      char sep1, sep2;
+      if (!getline(is, name, ':') || !(is >> lo >> sep1 >> hi) || sep1 != ':' || (is >> sep2)) {
+        cerr << "bad range " << range << "; expected column:lo:hi" << endl;
+        return EXIT_FAILURE;
+      }
+      r.add_range(name, lo, hi);
+    }
+    if (!args.empty()) r.select_columns(args);
+
+    vector<int> columns;
+    if (args.empty()) {
+      for (size_t i = 0; i < r.get_num_columns(); ++i) columns.push_back(i);
+    } else {
+      for (const auto &name : args) columns.push_back(r.find_column(name));
+    }
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+      cout << (i ? "\t" : "") << r.get_column_name(columns[i]);
+    }
+    cout << "\n";
+
+    Long64_t nrows = 0;
+    while (r.next_row()) {
+      for (size_t i = 0; i < columns.size(); ++i) {
+        if (i) cout << "\t";
+        PrintValue(r, columns[i]);
+      }
+      cout << "\n";
+      ++nrows;
+    }
+
+    end = std::chrono::system_clock::now();
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    cerr << nrows << " of " << r.get_num_rows() << " rows pass; read ";
+    cerr << r.get_chunks_read() << " and skipped " << r.get_chunks_skipped();
+    cerr << " chunks in " << elapsed_seconds.count() << " seconds." << endl;
+    return 0;
+  }
+
+  // Write.
+  unique_ptr<BDtaunuReader> reader;
+  if (mc) reader.reset(new BDtaunuMcReader(args, trname.c_str()));
+  else reader.reset(new BDtaunuReader(args, trname.c_str()));
+
+  unique_ptr<CandidateColumnWriter> writer;
+  if (event_fname.empty()) writer.reset(new CandidateColumnWriter(output_fname, mc, chunk_rows));
+  else writer.reset(new CandidateColumnWriter(event_fname, output_fname, mc, chunk_rows));
+  while (reader->next_record() != RootReader::Status::kEOF) writer->write(*reader);
+  writer->close();
+
+  end = std::chrono::system_clock::now();
+  std::chrono::duration<double> elapsed_seconds = end - start;
+  cerr << "wrote " << writer->get_writer().get_num_rows() << " candidates of ";
+  cerr << args.size() << " files in " << elapsed_seconds.count() << " seconds." << endl;
+
+  return 0;
+}
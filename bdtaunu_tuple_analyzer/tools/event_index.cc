@@ -0,0 +1,73 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+
+#include <bdtaunu_tuple_analyzer/EventIndex.h>
+
+using namespace std;
+
+// Build an event Id index of a list of ntuples, or look events up in one.
+//
+// Usage: event_index [-j nthreads] [-t tree] -o index file1.root [file2.root ...]
+//        event_index -i index eventId [eventId ...]
+int main(int argc, char **argv) {
+
+  int nthreads = 0;
+  string output_fname, input_fname;
+  string trname = "ntp1";
+  vector<string> args;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      nthreads = atoi(argv[++i]);
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_fname = argv[++i];
+    } else if (arg == "-i" && i + 1 < argc) {
+      input_fname = argv[++i];
+    } else if (arg == "-t" && i + 1 < argc) {
+      trname = argv[++i];
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  if (args.empty() || output_fname.empty() == input_fname.empty()) {
+    cerr << "usage: " << argv[0];
+    cerr << " [-j nthreads] [-t tree] -o index file1.root [file2.root ...]" << endl;
+    cerr << "       " << argv[0] << " -i index eventId [eventId ...]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  // Look up: print the file and entry of each event.
+  if (!input_fname.empty()) {
+    EventIndex index = EventIndex::Open(input_fname);
+    int nmissing = 0;
+    for (const auto &eventId : args) {
+      string fname;
+      Long64_t entry;
+      if (index.find(eventId, fname, entry)) {
+        cout << eventId << " " << fname << " " << entry << endl;
+      } else {
+        cout << eventId << " not found" << endl;
+        ++nmissing;
+      }
+    }
+    return nmissing ? EXIT_FAILURE : 0;
+  }
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  start = std::chrono::system_clock::now();
+
+  EventIndex index = EventIndex::Build(args, trname.c_str(), nthreads);
+  index.write(output_fname);
+
+  end = std::chrono::system_clock::now();
+  std::chrono::duration<double> elapsed_seconds = end - start;
+  cerr << "indexed " << index.size() << " events in " << args.size() << " files in ";
+  cerr << elapsed_seconds.count() << " seconds." << endl;
+
+  return 0;
+}
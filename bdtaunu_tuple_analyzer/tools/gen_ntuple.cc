@@ -0,0 +1,61 @@
+#include <iostream> 
+#include <string> 
+#include <cstdlib> 
+#include <chrono>
+
+#include <bdtaunu_tuple_analyzer/NtupleGenerator.h>
+
+using namespace std;
+
+// Write a synthetic BtaTupleMaker ntuple. 
+//
+// Usage: gen_ntuple [-n nevents] [-s seed] [-y nY_min nY_max] [-c continuum_fraction] [-t tree] output.root
+int main(int argc, char **argv) {
+
+  int nevents = 1000;
+  unsigned seed = 1;
+  int nY_min = 1, nY_max = 20;
+  double continuum_fraction = 0.0;
+  string trname = "ntp1";
+  string output_fname;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-n" && i + 1 < argc) {
+      nevents = atoi(argv[++i]);
+    } else if (arg == "-s" && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "-y" && i + 2 < argc) {
+      nY_min = atoi(argv[++i]);
+      nY_max = atoi(argv[++i]);
+    } else if (arg == "-c" && i + 1 < argc) {
+      continuum_fraction = atof(argv[++i]);
+    } else if (arg == "-t" && i + 1 < argc) {
+      trname = argv[++i];
+    } else {
+      output_fname = arg;
+    }
+  }
+
+  if (output_fname.empty() || nY_min < 0 || nY_min > nY_max || nY_max > NtupleGenerator::max_nY) {
+    cerr << "usage: " << argv[0];
+    cerr << " [-n nevents] [-s seed] [-y nY_min nY_max] [-c continuum_fraction] [-t tree] output.root" << endl;
+    cerr << "nY_max can be at most " << NtupleGenerator::max_nY << "." << endl;
+    return EXIT_FAILURE;
+  }
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  start = std::chrono::system_clock::now();
+
+  NtupleGenerator generator(seed);
+  generator.set_nY_range(nY_min, nY_max);
+  generator.set_continuum_fraction(continuum_fraction);
+  generator.write(output_fname.c_str(), nevents, trname.c_str());
+
+  end = std::chrono::system_clock::now();
+  std::chrono::duration<double> elapsed_seconds = end - start;
+  cerr << "wrote " << nevents << " events to " << output_fname;
+  cerr << " in " << elapsed_seconds.count() << " seconds." << endl;
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuReader.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/BranchIoProfile.h>
+
+using namespace std;
+
+// Rank the branches of a list of ntuples by read and decompression
+// time, as read by the reader the analysis would use, and flag the
+// branches that are read but never bound.
+//
+// The reader is BDtaunuMcReader unless --reco (BDtaunuReader, for data)
+// or --mc-only (BDtaunuMcReader in MC truth only mode) is given.
+//
+// Usage: io_profile [-o output] [-t tree] [--reco | --mc-only] file1.root [file2.root ...]
+int main(int argc, char **argv) {
+
+  string output_fname;
+  string trname = "ntp1";
+  bool reco = false;
+  BDtaunuMcReader::Mode mode = BDtaunuMcReader::Mode::kFull;
+  vector<string> fnames;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-o" && i + 1 < argc) {
+      output_fname = argv[++i];
+    } else if (arg == "-t" && i + 1 < argc) {
+      trname = argv[++i];
+    } else if (arg == "--reco") {
+      reco = true;
+    } else if (arg == "--mc-only") {
+      mode = BDtaunuMcReader::Mode::kMcOnly;
+    } else {
+      fnames.push_back(arg);
+    }
+  }
+
+  if (fnames.empty()) {
+    cerr << "usage: " << argv[0];
+    cerr << " [-o output] [-t tree] [--reco | --mc-only] file1.root [file2.root ...]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  BranchIoProfile profile;
+  for (const auto &fname : fnames) {
+    unique_ptr<RootReader> reader;
+    if (reco) {
+      reader.reset(new BDtaunuReader(fname.c_str(), trname.c_str()));
+    } else {
+      reader.reset(new BDtaunuMcReader(fname.c_str(), trname.c_str(), mode));
+    }
+    reader->enable_io_profile();
+    while (reader->next_record() != RootReader::Status::kEOF) {}
+    profile.merge(*reader->get_io_profile());
+  }
+
+  if (output_fname.empty()) {
+    profile.print(cout);
+  } else {
+    ofstream output(output_fname);
+    profile.print(output);
+  }
+
+  return 0;
+}
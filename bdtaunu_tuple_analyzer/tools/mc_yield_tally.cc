@@ -0,0 +1,99 @@
+#include <iostream> 
+#include <fstream> 
+#include <string> 
+#include <vector> 
+#include <cstdlib> 
+#include <chrono>
+#include <csignal>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/McYieldTally.h>
+
+using namespace std;
+
+static McYieldTally *running_tally = nullptr;
+
+// Batch systems send SIGTERM some time before they preempt a job. 
+static void StopAtCheckpoint(int) {
+  if (running_tally) running_tally->request_stop();
+}
+
+// Tally generated events by MC labels over a list of MC ntuples. 
+//
+// With -c, progress is checkpointed to the given file every -k entries 
+// of each file, and a rerun with the same arguments resumes from it. 
+// SIGTERM and SIGINT then stop the run at the next checkpoint, and the 
+// exit status is 2 until the run is complete. 
+//
+// Usage: mc_yield_tally [-j nthreads] [-o output] [-t tree] [--full] 
+//                       [-c checkpoint [-k interval]] file1.root [file2.root ...]
+int main(int argc, char **argv) {
+
+  int nthreads = 0;
+  string output_fname;
+  string trname = "ntp1";
+  BDtaunuMcReader::Mode mode = BDtaunuMcReader::Mode::kMcOnly;
+  vector<string> fnames;
+  string checkpoint_fname;
+  Long64_t checkpoint_interval = 100000;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      nthreads = atoi(argv[++i]);
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_fname = argv[++i];
+    } else if (arg == "-t" && i + 1 < argc) {
+      trname = argv[++i];
+    } else if (arg == "-c" && i + 1 < argc) {
+      checkpoint_fname = argv[++i];
+    } else if (arg == "-k" && i + 1 < argc) {
+      checkpoint_interval = atoll(argv[++i]);
+    } else if (arg == "--full") {
+      mode = BDtaunuMcReader::Mode::kFull;
+    } else {
+      fnames.push_back(arg);
+    }
+  }
+
+  if (fnames.empty()) {
+    cerr << "usage: " << argv[0];
+    cerr << " [-j nthreads] [-o output] [-t tree] [--full]";
+    cerr << " [-c checkpoint [-k interval]] file1.root [file2.root ...]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  start = std::chrono::system_clock::now();
+
+  McYieldTally tally(fnames, trname.c_str());
+  tally.set_nthreads(nthreads);
+  tally.set_mode(mode);
+  if (!checkpoint_fname.empty()) {
+    tally.set_checkpoint(checkpoint_fname, checkpoint_interval);
+    running_tally = &tally;
+    signal(SIGTERM, StopAtCheckpoint);
+    signal(SIGINT, StopAtCheckpoint);
+  }
+  const McYieldTable &table = tally.run();
+  running_tally = nullptr;
+
+  if (!tally.is_complete()) {
+    cerr << "stopped; progress saved to " << checkpoint_fname << "." << endl;
+    return 2;
+  }
+
+  end = std::chrono::system_clock::now();
+  std::chrono::duration<double> elapsed_seconds = end - start;
+  cerr << "tallied " << table.total() << " events from " << fnames.size();
+  cerr << " files in " << elapsed_seconds.count() << " seconds." << endl;
+
+  if (output_fname.empty()) {
+    table.write(cout);
+  } else {
+    ofstream output(output_fname);
+    table.write(output);
+  }
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <chrono>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuReader.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/OutputRouter.h>
+
+using namespace std;
+
+// Split the candidates of a list of ntuples into columnar files by a
+// hash of the event Id, reading the ntuples once. Each -s gives an
+// output and the range of hash fractions it takes; ranges may overlap.
+//
+// Usage: route_candidates [-t tree] [-n chunk_rows] [--mc] [--seed seed]
+//                         -s output:lo:hi [-s output:lo:hi ...] file1.root [file2.root ...]
+//
+// For example, a 80/10/10 split:
+//
+//     route_candidates --mc -s train.col:0:0.8 -s test.col:0.8:0.9 -s validation.col:0.9:1 sp1235r*.root
+int main(int argc, char **argv) {
+
+  string trname = "ntp1";
+  Long64_t chunk_rows = 16384;
+  unsigned long long seed = 0;
+  bool mc = false;
+  vector<string> splits;
+  vector<string> args;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-s" && i + 1 < argc) {
+      splits.push_back(argv[++i]);
+    } else if (arg == "-t" && i + 1 < argc) {
+      trname = argv[++i];
+    } else if (arg == "-n" && i + 1 < argc) {
+      chunk_rows = atoll(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--mc") {
+      mc = true;
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  if (splits.empty() || args.empty()) {
+    cerr << "usage: " << argv[0] << " [-t tree] [-n chunk_rows] [--mc] [--seed seed]";
+    cerr << " -s output:lo:hi [-s output:lo:hi ...] file1.root [file2.root ...]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  start = std::chrono::system_clock::now();
+
+  // The output name may itself hold colons; the range is the last two fields.
+  OutputRouter router(mc, chunk_rows);
+  for (const auto &split : splits) {
+    size_t hi_sep = split.rfind(':');
+    size_t lo_sep = hi_sep == string::npos || hi_sep == 0 ? string::npos : split.rfind(':', hi_sep - 1);
+    double lo, hi;
+    istringstream los, his;
+    if (lo_sep != string::npos) {
+      los.str(split.substr(lo_sep + 1, hi_sep - lo_sep - 1));
+      his.str(split.substr(hi_sep + 1));
+    }
+    if (lo_sep == string::npos || lo_sep == 0 || !(los >> lo) || !(his >> hi)) {
+      cerr << "bad split " << split << "; expected output:lo:hi" << endl;
+      return EXIT_FAILURE;
+    }
+    router.add_sink(split.substr(0, lo_sep), OutputRouter::HashSplit(lo, hi, seed));
+  }
+
+  unique_ptr<BDtaunuReader> reader;
+  if (mc) reader.reset(new BDtaunuMcReader(args, trname.c_str()));
+  else reader.reset(new BDtaunuReader(args, trname.c_str()));
+
+  Long64_t nevents = router.run(*reader);
+  router.close();
+
+  end = std::chrono::system_clock::now();
+  std::chrono::duration<double> elapsed_seconds = end - start;
+  for (size_t i = 0; i < router.get_num_sinks(); ++i) {
+    cerr << splits[i] << ": " << router.get_num_events(i) << " events" << endl;
+  }
+  cerr << "routed " << nevents << " events of " << args.size() << " files in ";
+  cerr << elapsed_seconds.count() << " seconds." << endl;
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <chrono>
+
+#include <bdtaunu_tuple_analyzer/BDtaunuReader.h>
+#include <bdtaunu_tuple_analyzer/BDtaunuMcReader.h>
+#include <bdtaunu_tuple_analyzer/SkimWriter.h>
+
+using namespace std;
+
+// Skim a list of ntuples into a directory, one output per input, keeping
+// the branches the reader uses and the events with enough candidates.
+// Without --min-candidates every event is kept, and baskets are copied
+// without unpacking them.
+//
+// Usage: skim_ntuple -d outdir [-j nthreads] [-t tree] [--mc] [--min-candidates n]
+//                    [-b branch ...] file1.root [file2.root ...]
+int main(int argc, char **argv) {
+
+  int nthreads = 0;
+  int min_candidates = -1;
+  bool mc = false;
+  string output_dir;
+  string trname = "ntp1";
+  vector<string> extra_branches;
+  vector<string> fnames;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      nthreads = atoi(argv[++i]);
+    } else if (arg == "-d" && i + 1 < argc) {
+      output_dir = argv[++i];
+    } else if (arg == "-t" && i + 1 < argc) {
+      trname = argv[++i];
+    } else if (arg == "-b" && i + 1 < argc) {
+      extra_branches.push_back(argv[++i]);
+    } else if (arg == "--min-candidates" && i + 1 < argc) {
+      min_candidates = atoi(argv[++i]);
+    } else if (arg == "--mc") {
+      mc = true;
+    } else {
+      fnames.push_back(arg);
+    }
+  }
+
+  if (fnames.empty() || output_dir.empty()) {
+    cerr << "usage: " << argv[0] << " -d outdir [-j nthreads] [-t tree] [--mc]";
+    cerr << " [--min-candidates n] [-b branch ...] file1.root [file2.root ...]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  vector<string> output_fnames;
+  for (const auto &f : fnames) {
+    output_fnames.push_back(output_dir + "/" + f.substr(f.find_last_of('/') + 1));
+  }
+
+  SkimWriter::Predicate keep;
+  if (min_candidates >= 0) {
+    keep = [min_candidates] (const BDtaunuReader &r) {
+      return static_cast<int>(r.get_upsilon_candidates().size()) >= min_candidates;
+    };
+  }
+
+  SkimWriter skim(keep);
+  skim.set_nthreads(nthreads);
+  skim.set_extra_branches(extra_branches);
+  skim.set_reader_factory([mc, &trname] (const string &fname) {
+    return mc ? unique_ptr<BDtaunuReader>(new BDtaunuMcReader(fname.c_str(), trname.c_str()))
+              : unique_ptr<BDtaunuReader>(new BDtaunuReader(fname.c_str(), trname.c_str()));
+  });
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  start = std::chrono::system_clock::now();
+
+  vector<Long64_t> nwritten = skim.run(fnames, output_fnames);
+
+  end = std::chrono::system_clock::now();
+  std::chrono::duration<double> elapsed_seconds = end - start;
+  Long64_t total = 0;
+  for (size_t i = 0; i < fnames.size(); ++i) {
+    cout << output_fnames[i] << " " << nwritten[i] << endl;
+    total += nwritten[i];
+  }
+  cerr << "skimmed " << total << " events from " << fnames.size();
+  cerr << " files in " << elapsed_seconds.count() << " seconds." << endl;
+
+  return 0;
+}